@@ -55,7 +55,7 @@
 /*
     IO pins assignments.
 */
-#define GPIOA_PIN0                     0U
+#define GPIOA_REF_CLK                  0U
 #define GPIOA_PIN1                     1U
 #define GPIOA_PIN2                     2U
 #define GPIOA_PIN3                     3U
@@ -82,7 +82,7 @@
 #define GPIOB_UART_RX                  7U
 #define GPIOB_I2C_SCL                  8U
 #define GPIOB_I2C_SDA                  9U
-#define GPIOB_PIN10                    10U
+#define GPIOB_PLL_LOCK                 10U
 #define GPIOB_PIN11                    11U
 #define GPIOB_PIN12                    12U
 #define GPIOB_OTG_VBUS                 13U
@@ -95,8 +95,8 @@
 #define GPIOC_PIN3                     3U
 #define GPIOC_PIN4                     4U
 #define GPIOC_PIN5                     5U
-#define GPIOC_PIN6                     6U
-#define GPIOC_PIN7                     7U
+#define GPIOC_GPS_PPS                  6U
+#define GPIOC_PPS_OUT                  7U
 #define GPIOC_PIN8                     8U
 #define GPIOC_PIN9                     9U
 #define GPIOC_PIN10                    10U
@@ -213,12 +213,16 @@
 */
 #define LINE_ANT_EN                    PAL_LINE(GPIOB, 4U)
 #define LINE_ANT_FLAG                  PAL_LINE(GPIOB, 3U)
+#define LINE_GPS_PPS                   PAL_LINE(GPIOC, 6U)
 #define LINE_GPS_RST                   PAL_LINE(GPIOB, 5U)
 #define LINE_I2C_SCL                   PAL_LINE(GPIOB, 8U)
 #define LINE_I2C_SDA                   PAL_LINE(GPIOB, 9U)
 #define LINE_OTG_DM                    PAL_LINE(GPIOB, 14U)
 #define LINE_OTG_DP                    PAL_LINE(GPIOB, 15U)
 #define LINE_OTG_VBUS                  PAL_LINE(GPIOB, 13U)
+#define LINE_PLL_LOCK                  PAL_LINE(GPIOB, 10U)
+#define LINE_PPS_OUT                   PAL_LINE(GPIOC, 7U)
+#define LINE_REF_CLK                   PAL_LINE(GPIOA, 0U)
 #define LINE_STATUS                    PAL_LINE(GPIOC, 0U)
 #define LINE_SWCLK                     PAL_LINE(GPIOA, 14U)
 #define LINE_SWDIO                     PAL_LINE(GPIOA, 13U)
@@ -250,7 +254,7 @@
 /*
  *  GPIOA setup:
  *
- * PA0  - PIN0                         (unused).
+ * PA0  - REF_CLK                      (af3).
  * PA1  - PIN1                         (unused).
  * PA2  - PIN2                         (unused).
  * PA3  - PIN3                         (unused).
@@ -267,7 +271,7 @@
  * PA14 - SWCLK                        (pulldown af0).
  * PA15 - PIN15                        (unused).
 */
-#define VAL_GPIOA_MODER                (PIN_MODE_INPUT(GPIOA_PIN0) | \
+#define VAL_GPIOA_MODER                (PIN_MODE_ALTERNATE(GPIOA_REF_CLK) | \
                                         PIN_MODE_INPUT(GPIOA_PIN1) | \
                                         PIN_MODE_INPUT(GPIOA_PIN2) | \
                                         PIN_MODE_INPUT(GPIOA_PIN3) | \
@@ -284,7 +288,7 @@
                                         PIN_MODE_ALTERNATE(GPIOA_SWCLK) | \
                                         PIN_MODE_INPUT(GPIOA_PIN15))
 
-#define VAL_GPIOA_OTYPER               (PIN_OTYPE_PUSHPULL(GPIOA_PIN0) | \
+#define VAL_GPIOA_OTYPER               (PIN_OTYPE_PUSHPULL(GPIOA_REF_CLK) | \
                                         PIN_OTYPE_PUSHPULL(GPIOA_PIN1) | \
                                         PIN_OTYPE_PUSHPULL(GPIOA_PIN2) | \
                                         PIN_OTYPE_PUSHPULL(GPIOA_PIN3) | \
@@ -301,7 +305,7 @@
                                         PIN_OTYPE_PUSHPULL(GPIOA_SWCLK) | \
                                         PIN_OTYPE_PUSHPULL(GPIOA_PIN15))
 
-#define VAL_GPIOA_OSPEEDR              (PIN_OSPEED_HIGH(GPIOA_PIN0) | \
+#define VAL_GPIOA_OSPEEDR              (PIN_OSPEED_HIGH(GPIOA_REF_CLK) | \
                                         PIN_OSPEED_HIGH(GPIOA_PIN1) | \
                                         PIN_OSPEED_HIGH(GPIOA_PIN2) | \
                                         PIN_OSPEED_HIGH(GPIOA_PIN3) | \
@@ -318,7 +322,7 @@
                                         PIN_OSPEED_HIGH(GPIOA_SWCLK) | \
                                         PIN_OSPEED_HIGH(GPIOA_PIN15))
 
-#define VAL_GPIOA_PUPDR                (PIN_PUPD_PULLUP(GPIOA_PIN0) | \
+#define VAL_GPIOA_PUPDR                (PIN_PUPD_PULLUP(GPIOA_REF_CLK) | \
                                         PIN_PUPD_PULLUP(GPIOA_PIN1) | \
                                         PIN_PUPD_PULLUP(GPIOA_PIN2) | \
                                         PIN_PUPD_PULLUP(GPIOA_PIN3) | \
@@ -335,7 +339,7 @@
                                         PIN_PUPD_PULLDOWN(GPIOA_SWCLK) | \
                                         PIN_PUPD_PULLUP(GPIOA_PIN15))
 
-#define VAL_GPIOA_ODR                  (PIN_OD_HIGH(GPIOA_PIN0) | \
+#define VAL_GPIOA_ODR                  (PIN_OD_HIGH(GPIOA_REF_CLK) | \
                                         PIN_OD_HIGH(GPIOA_PIN1) | \
                                         PIN_OD_HIGH(GPIOA_PIN2) | \
                                         PIN_OD_HIGH(GPIOA_PIN3) | \
@@ -352,7 +356,7 @@
                                         PIN_OD_HIGH(GPIOA_SWCLK) | \
                                         PIN_OD_HIGH(GPIOA_PIN15))
 
-#define VAL_GPIOA_AFRL                 (PIN_AFIO_AF(GPIOA_PIN0, 0U) | \
+#define VAL_GPIOA_AFRL                 (PIN_AFIO_AF(GPIOA_REF_CLK, 3U) | \
                                         PIN_AFIO_AF(GPIOA_PIN1, 0U) | \
                                         PIN_AFIO_AF(GPIOA_PIN2, 0U) | \
                                         PIN_AFIO_AF(GPIOA_PIN3, 0U) | \
@@ -383,7 +387,7 @@
  * PB7  - UART_RX                      (af7).
  * PB8  - I2C_SCL                      (af4 opendrain).
  * PB9  - I2C_SDA                      (af4 opendrain).
- * PB10 - PIN10                        (unused).
+ * PB10 - PLL_LOCK                     (input pullup).
  * PB11 - PIN11                        (unused).
  * PB12 - PIN12                        (unused).
  * PB13 - OTG_VBUS                     (input pulldown).
@@ -400,7 +404,7 @@
                                         PIN_MODE_ALTERNATE(GPIOB_UART_RX) | \
                                         PIN_MODE_ALTERNATE(GPIOB_I2C_SCL) | \
                                         PIN_MODE_ALTERNATE(GPIOB_I2C_SDA) | \
-                                        PIN_MODE_INPUT(GPIOB_PIN10) | \
+                                        PIN_MODE_INPUT(GPIOB_PLL_LOCK) | \
                                         PIN_MODE_INPUT(GPIOB_PIN11) | \
                                         PIN_MODE_INPUT(GPIOB_PIN12) | \
                                         PIN_MODE_INPUT(GPIOB_OTG_VBUS) | \
@@ -417,7 +421,7 @@
                                         PIN_OTYPE_PUSHPULL(GPIOB_UART_RX) | \
                                         PIN_OTYPE_OPENDRAIN(GPIOB_I2C_SCL) | \
                                         PIN_OTYPE_OPENDRAIN(GPIOB_I2C_SDA) | \
-                                        PIN_OTYPE_PUSHPULL(GPIOB_PIN10) | \
+                                        PIN_OTYPE_PUSHPULL(GPIOB_PLL_LOCK) | \
                                         PIN_OTYPE_PUSHPULL(GPIOB_PIN11) | \
                                         PIN_OTYPE_PUSHPULL(GPIOB_PIN12) | \
                                         PIN_OTYPE_PUSHPULL(GPIOB_OTG_VBUS) | \
@@ -434,7 +438,7 @@
                                         PIN_OSPEED_HIGH(GPIOB_UART_RX) | \
                                         PIN_OSPEED_HIGH(GPIOB_I2C_SCL) | \
                                         PIN_OSPEED_HIGH(GPIOB_I2C_SDA) | \
-                                        PIN_OSPEED_HIGH(GPIOB_PIN10) | \
+                                        PIN_OSPEED_HIGH(GPIOB_PLL_LOCK) | \
                                         PIN_OSPEED_HIGH(GPIOB_PIN11) | \
                                         PIN_OSPEED_HIGH(GPIOB_PIN12) | \
                                         PIN_OSPEED_HIGH(GPIOB_OTG_VBUS) | \
@@ -451,7 +455,7 @@
                                         PIN_PUPD_PULLUP(GPIOB_UART_RX) | \
                                         PIN_PUPD_PULLUP(GPIOB_I2C_SCL) | \
                                         PIN_PUPD_PULLUP(GPIOB_I2C_SDA) | \
-                                        PIN_PUPD_PULLUP(GPIOB_PIN10) | \
+                                        PIN_PUPD_PULLUP(GPIOB_PLL_LOCK) | \
                                         PIN_PUPD_PULLUP(GPIOB_PIN11) | \
                                         PIN_PUPD_PULLUP(GPIOB_PIN12) | \
                                         PIN_PUPD_PULLDOWN(GPIOB_OTG_VBUS) | \
@@ -468,7 +472,7 @@
                                         PIN_OD_HIGH(GPIOB_UART_RX) | \
                                         PIN_OD_HIGH(GPIOB_I2C_SCL) | \
                                         PIN_OD_HIGH(GPIOB_I2C_SDA) | \
-                                        PIN_OD_HIGH(GPIOB_PIN10) | \
+                                        PIN_OD_HIGH(GPIOB_PLL_LOCK) | \
                                         PIN_OD_HIGH(GPIOB_PIN11) | \
                                         PIN_OD_HIGH(GPIOB_PIN12) | \
                                         PIN_OD_HIGH(GPIOB_OTG_VBUS) | \
@@ -486,7 +490,7 @@
 
 #define VAL_GPIOB_AFRH                 (PIN_AFIO_AF(GPIOB_I2C_SCL, 4U) | \
                                         PIN_AFIO_AF(GPIOB_I2C_SDA, 4U) | \
-                                        PIN_AFIO_AF(GPIOB_PIN10, 0U) | \
+                                        PIN_AFIO_AF(GPIOB_PLL_LOCK, 0U) | \
                                         PIN_AFIO_AF(GPIOB_PIN11, 0U) | \
                                         PIN_AFIO_AF(GPIOB_PIN12, 0U) | \
                                         PIN_AFIO_AF(GPIOB_OTG_VBUS, 0U) | \
@@ -502,8 +506,8 @@
  * PC3  - PIN3                         (unused).
  * PC4  - PIN4                         (unused).
  * PC5  - PIN5                         (unused).
- * PC6  - PIN6                         (unused).
- * PC7  - PIN7                         (unused).
+ * PC6  - GPS_PPS                      (af3).
+ * PC7  - PPS_OUT                      (af3).
  * PC8  - PIN8                         (unused).
  * PC9  - PIN9                         (unused).
  * PC10 - PIN10                        (unused).
@@ -519,8 +523,8 @@
                                         PIN_MODE_INPUT(GPIOC_PIN3) | \
                                         PIN_MODE_INPUT(GPIOC_PIN4) | \
                                         PIN_MODE_INPUT(GPIOC_PIN5) | \
-                                        PIN_MODE_INPUT(GPIOC_PIN6) | \
-                                        PIN_MODE_INPUT(GPIOC_PIN7) | \
+                                        PIN_MODE_ALTERNATE(GPIOC_GPS_PPS) | \
+                                        PIN_MODE_ALTERNATE(GPIOC_PPS_OUT) | \
                                         PIN_MODE_INPUT(GPIOC_PIN8) | \
                                         PIN_MODE_INPUT(GPIOC_PIN9) | \
                                         PIN_MODE_INPUT(GPIOC_PIN10) | \
@@ -536,8 +540,8 @@
                                         PIN_OTYPE_PUSHPULL(GPIOC_PIN3) | \
                                         PIN_OTYPE_PUSHPULL(GPIOC_PIN4) | \
                                         PIN_OTYPE_PUSHPULL(GPIOC_PIN5) | \
-                                        PIN_OTYPE_PUSHPULL(GPIOC_PIN6) | \
-                                        PIN_OTYPE_PUSHPULL(GPIOC_PIN7) | \
+                                        PIN_OTYPE_PUSHPULL(GPIOC_GPS_PPS) | \
+                                        PIN_OTYPE_PUSHPULL(GPIOC_PPS_OUT) | \
                                         PIN_OTYPE_PUSHPULL(GPIOC_PIN8) | \
                                         PIN_OTYPE_PUSHPULL(GPIOC_PIN9) | \
                                         PIN_OTYPE_PUSHPULL(GPIOC_PIN10) | \
@@ -553,8 +557,8 @@
                                         PIN_OSPEED_HIGH(GPIOC_PIN3) | \
                                         PIN_OSPEED_HIGH(GPIOC_PIN4) | \
                                         PIN_OSPEED_HIGH(GPIOC_PIN5) | \
-                                        PIN_OSPEED_HIGH(GPIOC_PIN6) | \
-                                        PIN_OSPEED_HIGH(GPIOC_PIN7) | \
+                                        PIN_OSPEED_HIGH(GPIOC_GPS_PPS) | \
+                                        PIN_OSPEED_HIGH(GPIOC_PPS_OUT) | \
                                         PIN_OSPEED_HIGH(GPIOC_PIN8) | \
                                         PIN_OSPEED_HIGH(GPIOC_PIN9) | \
                                         PIN_OSPEED_HIGH(GPIOC_PIN10) | \
@@ -570,8 +574,8 @@
                                         PIN_PUPD_PULLUP(GPIOC_PIN3) | \
                                         PIN_PUPD_PULLUP(GPIOC_PIN4) | \
                                         PIN_PUPD_PULLUP(GPIOC_PIN5) | \
-                                        PIN_PUPD_PULLUP(GPIOC_PIN6) | \
-                                        PIN_PUPD_PULLUP(GPIOC_PIN7) | \
+                                        PIN_PUPD_PULLUP(GPIOC_GPS_PPS) | \
+                                        PIN_PUPD_PULLUP(GPIOC_PPS_OUT) | \
                                         PIN_PUPD_PULLUP(GPIOC_PIN8) | \
                                         PIN_PUPD_PULLUP(GPIOC_PIN9) | \
                                         PIN_PUPD_PULLUP(GPIOC_PIN10) | \
@@ -587,8 +591,8 @@
                                         PIN_OD_HIGH(GPIOC_PIN3) | \
                                         PIN_OD_HIGH(GPIOC_PIN4) | \
                                         PIN_OD_HIGH(GPIOC_PIN5) | \
-                                        PIN_OD_HIGH(GPIOC_PIN6) | \
-                                        PIN_OD_HIGH(GPIOC_PIN7) | \
+                                        PIN_OD_HIGH(GPIOC_GPS_PPS) | \
+                                        PIN_OD_HIGH(GPIOC_PPS_OUT) | \
                                         PIN_OD_HIGH(GPIOC_PIN8) | \
                                         PIN_OD_HIGH(GPIOC_PIN9) | \
                                         PIN_OD_HIGH(GPIOC_PIN10) | \
@@ -604,8 +608,8 @@
                                         PIN_AFIO_AF(GPIOC_PIN3, 0U) | \
                                         PIN_AFIO_AF(GPIOC_PIN4, 0U) | \
                                         PIN_AFIO_AF(GPIOC_PIN5, 0U) | \
-                                        PIN_AFIO_AF(GPIOC_PIN6, 0U) | \
-                                        PIN_AFIO_AF(GPIOC_PIN7, 0U))
+                                        PIN_AFIO_AF(GPIOC_GPS_PPS, 3U) | \
+                                        PIN_AFIO_AF(GPIOC_PPS_OUT, 3U))
 
 #define VAL_GPIOC_AFRH                 (PIN_AFIO_AF(GPIOC_PIN8, 0U) | \
                                         PIN_AFIO_AF(GPIOC_PIN9, 0U) | \
@@ -28,7 +28,7 @@
 #define CS2100_DEVICE_CTRL_UNLOCK           (1<<7)
 #define CS2100_DEVICE_CTRL_AUX_OUT_DIS      (1<<1)
 #define CS2100_DEVICE_CTRL_CLK_OUT_DIS      (1<<0)
-#define CS2100_DEVICE_CFG_1_R_MOD_SEL(x)    ((x<<5) & 0xE0)
+#define CS2100_DEVICE_CFG_1_R_MOD_SEL(x)    (((x)<<5) & 0xE0)
 #define CS2100_DEVICE_CFG_1_AUX_OUT_SRC_REF_CLK         (0<<1)
 #define CS2100_DEVICE_CFG_1_AUX_OUT_SRC_CLK_IN          (1<<1)
 #define CS2100_DEVICE_CFG_1_AUX_OUT_SRC_CLK_OUT         (1<<2)
@@ -52,27 +52,49 @@
 #define CS2100_FUNCT_CFG_3_CLK_IN_BW_64HZ   (6<<4)
 #define CS2100_FUNCT_CFG_3_CLK_IN_BW_128HZ  (7<<4)
 
+/* R_MOD_SEL Codes */
+#define CS2100_R_MOD_MUL(n) (n)                         // x2^n, n 0..3
+#define CS2100_R_MOD_DIV(n) (3 + (n))                   // /2^n, n 1..4
+
+/* L_F_RATIO_CFG Takes 12.20 from this Many Fractional Bits */
+#define CS2100_HIGH_ACCURACY_BITS 17
+
 static I2CDriver* cs2100_i2cd;
-static void cs2100_error(const char* err);
-static uint8_t cs2100_read(uint8_t reg_addr);
+static uint32_t cs2100_errors;
+static uint8_t cs2100_aux_src;                          // DEVICE_CFG_1 less R_MOD_SEL
+static uint8_t cs2100_funct_cfg_2;                      // As last written
+static bool cs2100_read(uint8_t reg_addr, uint8_t *data);
 static bool cs2100_write(uint8_t reg_addr, uint8_t data);
+static bool cs2100_result(msg_t result);
+static bool cs2100_write_ratio(const cs2100_ratio_t *ratio);
+static bool cs2100_write_funct_cfg_2(uint8_t data);
 
 
+/* Fast Mode - 10k Pull-ups on a Short Bus Meet the Rise Time */
 static const I2CConfig i2c_cfg = {
     OPMODE_I2C,
-    10000,
-    STD_DUTY_CYCLE,
+    400000,
+    FAST_DUTY_CYCLE_2,
 };
 
 
-static void cs2100_error(const char* err)
+/* Errors are Counted & Returned - the Caller Retries */
+static bool cs2100_result(msg_t result)
 {
-    /* TODO error handling */
-    chSysHalt(err);
+    if(result == MSG_OK)
+        return true;
+
+    /* A Timeout Leaves the Driver Locked Until Restarted */
+    cs2100_errors++;
+    if(result == MSG_TIMEOUT) {
+        i2cStop(cs2100_i2cd);
+        i2cStart(cs2100_i2cd, &i2c_cfg);
+    }
+    return false;
 }
 
 
-static uint8_t cs2100_read(uint8_t reg_addr)
+static bool cs2100_read(uint8_t reg_addr, uint8_t *data)
 {
     static uint8_t res __attribute__((section("DATA_RAM")));
     static uint8_t read_reg_addr __attribute__((section("DATA_RAM")));
@@ -81,19 +103,8 @@ static uint8_t cs2100_read(uint8_t reg_addr)
     msg_t result = i2cMasterTransmitTimeout(
         cs2100_i2cd, CS2100_ADDR, &read_reg_addr, 1, &res, 1, MS2ST(20));
 
-   if(result == MSG_OK) {
-        return res;
-    } else if(result == MSG_RESET) {
-        i2cflags_t i2c_errs = i2cGetErrors(cs2100_i2cd);
-        (void)i2c_errs;
-        cs2100_error("I2C write error");
-        return 0;
-    } else if(result == MSG_TIMEOUT) {
-        cs2100_error("I2C write timeout");
-        return 0;
-    } else {
-        return 0;
-    }
+    *data = res;
+    return cs2100_result(result);
 }
 
 
@@ -106,71 +117,143 @@ static bool cs2100_write(uint8_t reg_addr, uint8_t data)
     msg_t result = i2cMasterTransmitTimeout(
         cs2100_i2cd, CS2100_ADDR, buf, 2, NULL, 0, MS2ST(20));
 
-    if(result == MSG_OK) {
-        return true;
-    } else if(result == MSG_RESET) {
-        i2cflags_t i2c_errs = i2cGetErrors(cs2100_i2cd);
-        (void)i2c_errs;
-        cs2100_error("I2C write error");
-        return false;
-    } else if(result == MSG_TIMEOUT) {
-        cs2100_error("I2C write timeout");
+    return cs2100_result(result);
+}
+
+
+bool cs2100_ratio(uint32_t out_hz, cs2100_ratio_t *ratio)
+{
+    uint8_t bits;
+
+    if(out_hz < CS2100_OUT_MIN_HZ || out_hz > CS2100_OUT_MAX_HZ)
         return false;
-    } else {
+
+    /* Most Fractional Bits that Still Fit 32 Bits */
+    for(bits = 24; bits > 9; bits--)
+        if((((uint64_t)out_hz << bits) + CS2100_CLK_IN_HZ / 2) / CS2100_CLK_IN_HZ <= UINT32_MAX)
+            break;
+
+    ratio->frac_bits = bits;
+    ratio->value = (((uint64_t)out_hz << bits) + CS2100_CLK_IN_HZ / 2) / CS2100_CLK_IN_HZ;
+    return true;
+}
+
+
+int32_t cs2100_ratio_error_ppt(uint32_t out_hz, const cs2100_ratio_t *ratio)
+{
+    int64_t want = (int64_t)out_hz << ratio->frac_bits;
+    int64_t got = (int64_t)ratio->value * CS2100_CLK_IN_HZ;
+
+    return (got - want) * 1000000000000LL / want;
+}
+
+
+/* Ratio Registers & R_MOD_SEL - Value * 2^-frac_bits is 12.20 or 20.12 Shifted */
+static bool cs2100_write_ratio(const cs2100_ratio_t *ratio)
+{
+    bool ok = true;
+    int shift = (ratio->frac_bits >= CS2100_HIGH_ACCURACY_BITS ? 20 : 12) - ratio->frac_bits;
+    uint8_t r_mod = shift >= 0 ? CS2100_R_MOD_MUL(shift) : CS2100_R_MOD_DIV(-shift);
+
+    /* This register is big endian. */
+    ok &= cs2100_write(CS2100_RATIO_1, ratio->value >> 24);
+    ok &= cs2100_write(CS2100_RATIO_2, ratio->value >> 16);
+    ok &= cs2100_write(CS2100_RATIO_3, ratio->value >> 8);
+    ok &= cs2100_write(CS2100_RATIO_4, ratio->value);
+
+    ok &= cs2100_write(CS2100_DEVICE_CFG_1,
+                       CS2100_DEVICE_CFG_1_R_MOD_SEL(r_mod) | cs2100_aux_src);
+    return ok;
+}
+
+
+static bool cs2100_write_funct_cfg_2(uint8_t data)
+{
+    if(!cs2100_write(CS2100_FUNCT_CFG_2, data))
         return false;
-    }
+    cs2100_funct_cfg_2 = data;
+    return true;
 }
 
 
-void cs2100_configure(I2CDriver* i2cd)
+bool cs2100_configure(I2CDriver* i2cd, bool aux_lock, const cs2100_ratio_t *ratio)
 {
+    bool ok = true;
+
     cs2100_i2cd = i2cd;
     i2cStart(cs2100_i2cd, &i2c_cfg);
 
     /* Set reference clock divider to /2, to get 26MHz TCXO into range.
      */
-    cs2100_write(CS2100_FUNCT_CFG_1, CS2100_FUNCT_CFG_1_REF_CLK_DIV_2);
+    ok &= cs2100_write(CS2100_FUNCT_CFG_1, CS2100_FUNCT_CFG_1_REF_CLK_DIV_2);
 
     /* Don't drive outputs when PLL is unlocked,
-     * set ratio to high accuracy.
+     * set ratio to high accuracy unless it needs high multiplication.
      */
-    cs2100_write(CS2100_FUNCT_CFG_2, CS2100_FUNCT_CFG_2_L_F_RATIO_CFG);
+    ok &= cs2100_write_funct_cfg_2(ratio->frac_bits >= CS2100_HIGH_ACCURACY_BITS ?
+                                   CS2100_FUNCT_CFG_2_L_F_RATIO_CFG : 0);
 
     /* Set the PLL bandwidth after-lock to the minimum, 1Hz.
      * Should roughly match with the GPS.
      */
-    cs2100_write(CS2100_FUNCT_CFG_3, CS2100_FUNCT_CFG_3_CLK_IN_BW_1HZ);
-
+    ok &= cs2100_write(CS2100_FUNCT_CFG_3, CS2100_FUNCT_CFG_3_CLK_IN_BW_1HZ);
 
-    /* Set ratio to 40MHz / 1MHz = 40
-     * 40 * (1<<20) = 0x02800000
-     * This register is big endian.
-     */
-    cs2100_write(CS2100_RATIO_1, 0x02);
-    cs2100_write(CS2100_RATIO_2, 0x80);
-    cs2100_write(CS2100_RATIO_3, 0x00);
-    cs2100_write(CS2100_RATIO_4, 0x00);
 
-    /* Don't shift the ratio register at all
-     * Output 40MHz clock on aux
+    /* Output CLK_OUT on aux, or the PLL lock indicator:
+     * push-pull, high while unlocked.
      * Must set EN_DEV_CFG_1 to 1.
      */
-    cs2100_write(CS2100_DEVICE_CFG_1,
-                 CS2100_DEVICE_CFG_1_R_MOD_SEL(0) |
-                 CS2100_DEVICE_CFG_1_AUX_OUT_SRC_CLK_OUT |
-                 CS2100_DEVICE_CFG_1_EN_DEV_CFG_1);
+    cs2100_aux_src = (aux_lock ? CS2100_DEVICE_CFG_1_AUX_OUT_SRC_CLK_PLL_LOCK :
+                                 CS2100_DEVICE_CFG_1_AUX_OUT_SRC_CLK_OUT) |
+                     CS2100_DEVICE_CFG_1_EN_DEV_CFG_1;
+    ok &= cs2100_write_ratio(ratio);
 
     /* Must set EN_DEV_CFG_2 to 1. */
-    cs2100_write(CS2100_GLOBAL_CFG, CS2100_GLOBAL_CFG_EN_DEV_CFG_2);
+    ok &= cs2100_write(CS2100_GLOBAL_CFG, CS2100_GLOBAL_CFG_EN_DEV_CFG_2);
+
+    return ok;
+}
+
+/* Drive CLK_OUT While Unlocked, or Mute it as Configured */
+bool cs2100_output_unlocked(bool enable){
+
+    return cs2100_write_funct_cfg_2((cs2100_funct_cfg_2 & ~CS2100_FUNCT_CFG_2_CLK_OUT_UNL) |
+                                    (enable ? CS2100_FUNCT_CFG_2_CLK_OUT_UNL : 0));
+}
+
+/* The PLL Sees Ratio & R_MOD_SEL Together on Unfreeze. FUNCT_CFG_2 is not
+ * Frozen, so is Only Written if the Ratio Changes Format.
+ */
+bool cs2100_set_ratio(const cs2100_ratio_t *ratio){
+
+    uint8_t funct_cfg_2 = (cs2100_funct_cfg_2 & ~CS2100_FUNCT_CFG_2_L_F_RATIO_CFG) |
+                          (ratio->frac_bits >= CS2100_HIGH_ACCURACY_BITS ?
+                           CS2100_FUNCT_CFG_2_L_F_RATIO_CFG : 0);
+    bool ok;
+
+    ok = cs2100_write(CS2100_GLOBAL_CFG, CS2100_GLOBAL_CFG_FREEZE | CS2100_GLOBAL_CFG_EN_DEV_CFG_2);
+    ok = ok && cs2100_write_ratio(ratio);
+    if(ok && funct_cfg_2 != cs2100_funct_cfg_2)
+        ok = cs2100_write_funct_cfg_2(funct_cfg_2);
+
+    /* Unfreeze Even After a Failure - the Caller Retries */
+    ok &= cs2100_write(CS2100_GLOBAL_CFG, CS2100_GLOBAL_CFG_EN_DEV_CFG_2);
+    return ok;
+}
+
+/* Get PLL Lock Status, false if the read failed */
+bool cs2100_pll_status(bool *locked){
+
+    uint8_t ctrl;
+    if(!cs2100_read(CS2100_DEVICE_CTRL, &ctrl))
+        return false;
+    *locked = !(ctrl & CS2100_DEVICE_CTRL_UNLOCK);
+    return true;
 }
 
-/* Get PLL Lock Status */
-bool cs2100_pll_status(void){
+/* I2C Errors so Far */
+uint32_t cs2100_i2c_errors(void){
 
-    bool unlocked;
-    uint8_t ctrl ;
-    ctrl = cs2100_read(CS2100_DEVICE_CTRL);
-    unlocked = ctrl & CS2100_DEVICE_CTRL_UNLOCK;
-    return !unlocked;
+    return cs2100_errors;
 }
 
@@ -3,11 +3,44 @@
 
 #include "hal.h"
 
-/* Configure the CS2100 to generate a suitable clock input */
-void cs2100_configure(I2CDriver* i2cd);
+/* CLK_IN - the uBlox TIMEPULSE */
+#define CS2100_CLK_IN_HZ    1000000
 
-/* Returns PLL Lock Status */
-bool cs2100_pll_status(void);
+/* CLK_OUT Range */
+#define CS2100_OUT_MIN_HZ   6000000
+#define CS2100_OUT_MAX_HZ   75000000
+
+/* Ratio as Written - Value * 2^-frac_bits is CLK_OUT / CLK_IN.
+ * 17 to 24 fractional bits are 12.20 shifted by R_MOD_SEL, 9 to 16 are 20.12.
+ */
+typedef struct {
+    uint32_t value;
+    uint8_t frac_bits;
+} cs2100_ratio_t;
+
+/* Most Precise Ratio for out_hz, false if out of range */
+bool cs2100_ratio(uint32_t out_hz, cs2100_ratio_t *ratio);
+
+/* What the Ratio Misses out_hz by, ppt */
+int32_t cs2100_ratio_error_ppt(uint32_t out_hz, const cs2100_ratio_t *ratio);
+
+/* Configure the CS2100 to generate CLK_OUT at ratio,
+ * with AUX_OUT as the lock indicator or a copy of CLK_OUT.
+ * False if any register write failed.
+ */
+bool cs2100_configure(I2CDriver* i2cd, bool aux_lock, const cs2100_ratio_t *ratio);
+
+/* Change the Ratio in One Step Behind GLOBAL_CFG_FREEZE, false if a write failed */
+bool cs2100_set_ratio(const cs2100_ratio_t *ratio);
+
+/* Drive CLK_OUT While Unlocked, false if the write failed */
+bool cs2100_output_unlocked(bool enable);
+
+/* Read PLL Lock Status over I2C, false if the read failed */
+bool cs2100_pll_status(bool *locked);
+
+/* I2C Errors so Far */
+uint32_t cs2100_i2c_errors(void);
 
 
 #endif
@@ -0,0 +1,501 @@
+#include "ch.h"
+#include "hal.h"
+
+#include "freq_monitor.h"
+#include "holdover.h"
+#include "pll_monitor.h"
+#include "cs2100.h"
+#include "gps.h"
+#include "usb_serial_link.h"
+
+#if FREQ_MONITOR_USE_TIM8
+
+#define FREQ_TIM STM32_TIM8
+
+/* Output PPS Edge Pending */
+#define PPS_OUT_IDLE    0
+#define PPS_OUT_RISE    1
+#define PPS_OUT_FALL    2
+
+/* CH2 Output Compare Modes */
+#define OC_FROZEN       0
+#define OC_ACTIVE       1
+#define OC_INACTIVE     2
+#define OC_FORCE_LOW    4
+
+/* Function Prototypes */
+static void freq_monitor_serve(void);
+static void pps_out_mode(uint32_t mode);
+static void pps_out_edge(void);
+static void pps_out_arm(uint32_t boundary);
+static void pps_out_queue(uint32_t rise);
+static void pps_out_reshape(void);
+static void pps_out_shape(uint32_t width, bool inverted);
+static void pps_out_retime(uint32_t now, uint32_t hz);
+static uint32_t freq_isqrt(uint64_t n);
+static uint32_t freq_monitor_now(void);
+static uint32_t freq_monitor_apply(uint32_t next);
+
+/* Extended Count - Written by the Timer Interrupts */
+static uint32_t overflows;
+static volatile uint32_t pps_capture;
+static volatile uint32_t pps_seq;
+static binary_semaphore_t pps_sem;
+
+/* Output PPS - Edges in Extended Counts, Armed by the Timer Interrupts */
+static uint8_t out_state;
+static uint32_t out_at;
+static bool out_armed;
+static uint32_t out_queued;
+static bool out_queued_valid;
+static volatile uint32_t out_rise;
+static volatile uint32_t out_seq;
+
+/* Output PPS Shape - Changed Only Between Pulses */
+static uint32_t out_width;
+static bool out_inverted;
+static uint32_t shape_width;
+static bool shape_inverted;
+static bool shape_pending;
+
+/* Reference Counts in a Second - FREQ Thread */
+static uint32_t count_hz;
+
+/* Settings Waiting for the Next Output Rise */
+static settings_t pending_set;
+static volatile bool pending;
+
+/* Window of PPS Captures, Newest at head */
+static uint32_t captures[FREQ_MONITOR_WINDOW + 1];
+static uint32_t head, filled;
+
+
+static void pps_out_mode(uint32_t mode)
+{
+    FREQ_TIM->CCMR1 = (FREQ_TIM->CCMR1 & ~STM32_TIM_CCMR1_OC2M_MASK) | STM32_TIM_CCMR1_OC2M(mode);
+}
+
+
+/* The Pending Edge Happened - a Rise Wakes the Thread for the Next */
+static void pps_out_edge(void)
+{
+    out_armed = false;
+    pps_out_mode(OC_FROZEN);
+
+    if(out_state == PPS_OUT_RISE) {
+        out_rise = out_at;
+        out_seq++;
+        chBSemSignalI(&pps_sem);
+        out_at += out_width;
+        out_state = PPS_OUT_FALL;
+    } else {
+        out_state = PPS_OUT_IDLE;
+        if(shape_pending)
+            pps_out_reshape();
+        if(out_queued_valid) {
+            out_at = out_queued;
+            out_state = PPS_OUT_RISE;
+            out_queued_valid = false;
+        }
+    }
+}
+
+
+/* Each Half of the 16 Bit Count - Arm an Edge Falling in the Next Half.
+ * CCR2 Then Cannot Match in the Current Half, so the Edge Lands Exactly.
+ */
+static void pps_out_arm(uint32_t boundary)
+{
+    if(out_state == PPS_OUT_IDLE || out_armed)
+        return;
+
+    uint32_t ahead = out_at - boundary;
+    if(ahead >= 0x10000 && ahead < 0x80000000)
+        return;
+
+    /* Queued Too Late - Keep the Cadence, Skip the Pulse */
+    if(ahead < 0x8000 || ahead >= 0x80000000) {
+        if(out_state == PPS_OUT_FALL)
+            pps_out_mode(OC_FORCE_LOW);
+        pps_out_edge();
+        return;
+    }
+
+    FREQ_TIM->CCR[1] = out_at & 0xFFFF;
+    FREQ_TIM->SR = ~STM32_TIM_SR_CC2IF;
+    pps_out_mode(out_state == PPS_OUT_RISE ? OC_ACTIVE : OC_INACTIVE);
+    out_armed = true;
+}
+
+
+/* Overflow, Half Count, Capture & Compare - Both Vectors at One Priority, so Never Nested */
+static void freq_monitor_serve(void)
+{
+    uint32_t sr = FREQ_TIM->SR;
+
+    chSysLockFromISR();
+
+    /* CCR2 Matches Every Wrap - Only the Armed One is an Edge */
+    if(sr & STM32_TIM_SR_CC2IF) {
+        FREQ_TIM->SR = ~STM32_TIM_SR_CC2IF;
+        if(out_armed)
+            pps_out_edge();
+    }
+
+    /* A Capture Just After the Wrap Sees the Overflow Still Pending */
+    if(sr & STM32_TIM_SR_CC1IF) {
+        uint32_t low = FREQ_TIM->CCR[0];
+        uint32_t high = overflows;
+        if((sr & STM32_TIM_SR_UIF) && low < 0x8000)
+            high++;
+
+        pps_capture = (high << 16) | low;
+        pps_seq++;
+        chBSemSignalI(&pps_sem);
+    }
+
+    if(sr & STM32_TIM_SR_UIF) {
+        FREQ_TIM->SR = ~STM32_TIM_SR_UIF;
+        overflows++;
+        pps_out_arm(overflows << 16);
+    }
+
+    if(sr & STM32_TIM_SR_CC3IF) {
+        FREQ_TIM->SR = ~STM32_TIM_SR_CC3IF;
+        pps_out_arm((overflows << 16) | 0x8000);
+    }
+
+    chSysUnlockFromISR();
+}
+
+OSAL_IRQ_HANDLER(STM32_TIM8_UP_HANDLER)
+{
+    OSAL_IRQ_PROLOGUE();
+    freq_monitor_serve();
+    OSAL_IRQ_EPILOGUE();
+}
+
+OSAL_IRQ_HANDLER(STM32_TIM8_CC_HANDLER)
+{
+    OSAL_IRQ_PROLOGUE();
+    freq_monitor_serve();
+    OSAL_IRQ_EPILOGUE();
+}
+
+
+/* Output Inactive, so Flipping CC2P Moves the Idle Level but Cuts no Pulse */
+static void pps_out_reshape(void)
+{
+    out_width = shape_width;
+    out_inverted = shape_inverted;
+    FREQ_TIM->CCER = (FREQ_TIM->CCER & ~STM32_TIM_CCER_CC2P) |
+                     (out_inverted ? STM32_TIM_CCER_CC2P : 0);
+    shape_pending = false;
+}
+
+
+/* Reshape from the Next Pulse - Straight Away Unless One is High */
+static void pps_out_shape(uint32_t width, bool inverted)
+{
+    chSysLock();
+    shape_width = width;
+    shape_inverted = inverted;
+    shape_pending = true;
+    if(out_state != PPS_OUT_FALL)
+        pps_out_reshape();
+    chSysUnlock();
+}
+
+
+/* The Count Rate Changed at now - a Fall Not Yet Armed Keeps its Time */
+static void pps_out_retime(uint32_t now, uint32_t hz)
+{
+    chSysLock();
+    int32_t left = (int32_t)(out_at - now);
+    if(out_state == PPS_OUT_FALL && !out_armed && left > 0)
+        out_at = now + (uint32_t)((uint64_t)left * hz / count_hz);
+    chSysUnlock();
+}
+
+
+/* Integer Square Root - libm is not Linked */
+static uint32_t freq_isqrt(uint64_t n)
+{
+    uint64_t root = 0, bit = (uint64_t)1 << 62;
+
+    while(bit > n)
+        bit >>= 2;
+    while(bit) {
+        if(n >= root + bit) {
+            n -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+
+/* Extended Count Now */
+static uint32_t freq_monitor_now(void)
+{
+    chSysLock();
+    uint32_t low = FREQ_TIM->CNT;
+    uint32_t high = overflows;
+    if((FREQ_TIM->SR & STM32_TIM_SR_UIF) && low < 0x8000)
+        high++;
+    chSysUnlock();
+
+    return (high << 16) | low;
+}
+
+
+/* Take the Pending Settings Just After an Output Rise - Returns the
+ * Next Rise, Moved if the Count Rate Changed
+ */
+static uint32_t freq_monitor_apply(uint32_t next)
+{
+    settings_t set;
+    uint32_t hz;
+
+    chSysLock();
+    set = pending_set;
+    pending = false;
+    chSysUnlock();
+
+    /* Counting Carries on at the New Rate Whether or not the Write is Through -
+     * Failing, the PLL Thread Retries and the Window Restarts Until it Lands.
+     */
+    hz = set.out_freq_hz / FREQ_MONITOR_ETR_DIV;
+    if(hz != count_hz) {
+        cs2100_ratio_t ratio;
+        uint32_t now;
+        cs2100_ratio(set.out_freq_hz, &ratio);
+        pll_retune(&ratio);
+        now = freq_monitor_now();
+        pps_out_retime(now, hz);
+        next = holdover_retune(hz, now);
+        count_hz = hz;
+        filled = 0;
+    }
+
+    pps_out_shape((uint64_t)set.pps_width_us * count_hz / 1000000, set.pps_inverted);
+    gps_cable_delay(set.cable_delay_ns);
+    settings_applied();
+
+    return next;
+}
+
+
+void freq_monitor_configure(const settings_t *set)
+{
+    chSysLock();
+    pending_set = *set;
+    pending = true;
+    chSysUnlock();
+}
+
+
+/* Queue the Next Rise Behind Any Pending Edges */
+static void pps_out_queue(uint32_t rise)
+{
+    chSysLock();
+    if(out_state == PPS_OUT_IDLE) {
+        out_at = rise;
+        out_state = PPS_OUT_RISE;
+    } else {
+        out_queued = rise;
+        out_queued_valid = true;
+    }
+    chSysUnlock();
+}
+
+
+/* Log One Second - A Gap or an Implausible Second Restarts the Window */
+static void freq_monitor_second(uint32_t capture, bool gap, freq_packet *out)
+{
+    freq_packet pkt = {0};
+
+    if(gap) {
+        pkt.flags |= FREQ_FLAGS_BAD_PPS;
+        filled = 0;
+    } else if(filled) {
+        uint32_t delta = capture - captures[head];
+        int32_t err = (int32_t)(delta - count_hz);
+        int32_t max_err = FREQ_MONITOR_MAX_ERR(count_hz);
+        pkt.ref_counts = delta;
+        if(delta == 0) {
+            pkt.flags |= FREQ_FLAGS_NO_REF;
+            filled = 0;
+        } else if(err > max_err || err < -max_err) {
+            pkt.flags |= FREQ_FLAGS_BAD_PPS;
+            filled = 0;
+        } else {
+            pkt.freq_err_ppb = (int64_t)err * 1000000000 / count_hz;
+        }
+    }
+
+    head = (head + 1) % (FREQ_MONITOR_WINDOW + 1);
+    captures[head] = capture;
+    if(filled < FREQ_MONITOR_WINDOW + 1)
+        filled++;
+
+    /* Mean Error & Spread of the Seconds in the Window */
+    uint32_t n = filled - 1;
+    if(n >= 1) {
+        int64_t sum = 0, sum_sq = 0;
+        for(uint32_t i = 0; i < n; i++) {
+            uint32_t cur = (head + FREQ_MONITOR_WINDOW + 1 - i) % (FREQ_MONITOR_WINDOW + 1);
+            uint32_t prev = (cur + FREQ_MONITOR_WINDOW) % (FREQ_MONITOR_WINDOW + 1);
+            int32_t err = (int32_t)(captures[cur] - captures[prev] - count_hz);
+            sum += err;
+            sum_sq += (int64_t)err * err;
+        }
+
+        int64_t ppt = sum * 1000000000000LL / ((int64_t)n * count_hz);
+        pkt.freq_err_avg_ppt = ppt > INT32_MAX ? INT32_MAX : ppt < -INT32_MAX ? -INT32_MAX : ppt;
+
+        /* Standard Deviation in Counts * 1000, then ps - Zero for a Single Second */
+        uint64_t var = (uint64_t)(n * sum_sq - sum * sum) * 1000000 / ((uint64_t)n * n);
+        pkt.jitter_ps = (uint64_t)freq_isqrt(var) * 1000000000 / count_hz;
+    }
+    pkt.window = n;
+
+    upload_freq_packet(&pkt);
+    *out = pkt;
+}
+
+
+/* Measurement Thread */
+static THD_WORKING_AREA(freq_thd_wa, 512);
+static THD_FUNCTION(freq_thd, arg) {
+
+    (void)arg;
+    chRegSetThreadName("FREQ");
+
+    uint32_t seen = 0, rises = 0;
+    bool started = false;
+    systime_t last_pps = chVTGetSystemTime();
+    systime_t last_missing = last_pps;
+    while(true) {
+        chBSemWaitTimeout(&pps_sem, MS2ST(500));
+
+        chSysLock();
+        uint32_t capture = pps_capture;
+        uint32_t seq = pps_seq;
+        uint32_t rise = out_rise;
+        uint32_t rseq = out_seq;
+        chSysUnlock();
+
+        /* New Capture - a Skipped Sequence Means Pulses were Lost */
+        if(seq != seen) {
+            freq_packet pkt;
+            uint32_t first;
+            freq_monitor_second(capture, seq - seen > 1, &pkt);
+            if(holdover_capture(capture, &pkt, &first)) {
+                pps_out_queue(first);
+                started = true;
+            }
+            seen = seq;
+            last_pps = chVTGetSystemTime();
+        } else if(chVTTimeElapsedSinceX(last_pps) > MS2ST(1500) &&
+                  chVTTimeElapsedSinceX(last_missing) >= MS2ST(1000)) {
+            freq_packet pkt = {0};
+            pkt.flags = FREQ_FLAGS_NO_PPS;
+            upload_freq_packet(&pkt);
+            filled = 0;
+            holdover_no_pps();
+            last_missing = chVTGetSystemTime();
+        }
+
+        /* Output Pulse Rose - Schedule the Next */
+        if(rseq != rises) {
+            uint32_t next = holdover_rise(rise);
+            rises = rseq;
+            if(pending)
+                next = freq_monitor_apply(next);
+            pps_out_queue(next);
+        } else if(pending && !started) {
+            freq_monitor_apply(0);
+        }
+    }
+}
+
+
+void freq_monitor_init(bool rising_edge, const settings_t *set)
+{
+    chBSemObjectInit(&pps_sem, true);
+    count_hz = set->out_freq_hz / FREQ_MONITOR_ETR_DIV;
+    out_width = (uint64_t)set->pps_width_us * count_hz / 1000000;
+    out_inverted = set->pps_inverted;
+    shape_pending = false;
+    pending = false;
+    holdover_init(count_hz);
+    overflows = 0;
+    pps_seq = 0;
+    out_state = PPS_OUT_IDLE;
+    out_armed = false;
+    out_queued_valid = false;
+    out_seq = 0;
+    head = 0;
+    filled = 0;
+
+    rccEnableTIM8(FALSE);
+    rccResetTIM8();
+
+    /* External Clock Mode 2 from ETR, Free Running over 16 Bits */
+    FREQ_TIM->PSC = 0;
+    FREQ_TIM->ARR = 0xFFFF;
+    FREQ_TIM->SMCR = STM32_TIM_SMCR_ECE |
+                     STM32_TIM_SMCR_ETPS(FREQ_MONITOR_ETR_DIV == 1 ? 0 :
+                                         FREQ_MONITOR_ETR_DIV == 2 ? 1 :
+                                         FREQ_MONITOR_ETR_DIV == 4 ? 2 : 3);
+
+    /* CH1 Captures TI1 after 8 Samples at TIMCLK2,
+     * CH2 Drives the Output PPS, Held Low Until the First Edge is Armed,
+     * CH3 Interrupts Half Way Round the Count.
+     */
+    FREQ_TIM->CCMR1 = STM32_TIM_CCMR1_CC1S(1) | STM32_TIM_CCMR1_IC1F(3) |
+                      STM32_TIM_CCMR1_OC2M(OC_FORCE_LOW);
+    FREQ_TIM->CCMR2 = STM32_TIM_CCMR2_OC3M(OC_FROZEN);
+    FREQ_TIM->CCR[2] = 0x8000;
+    FREQ_TIM->CCER = STM32_TIM_CCER_CC1E | (rising_edge ? 0 : STM32_TIM_CCER_CC1P) |
+                     STM32_TIM_CCER_CC2E | (out_inverted ? STM32_TIM_CCER_CC2P : 0);
+    FREQ_TIM->BDTR = STM32_TIM_BDTR_MOE;
+
+    FREQ_TIM->EGR = STM32_TIM_EGR_UG;
+    FREQ_TIM->SR = 0;
+    FREQ_TIM->DIER = STM32_TIM_DIER_CC1IE | STM32_TIM_DIER_CC2IE |
+                     STM32_TIM_DIER_CC3IE | STM32_TIM_DIER_UIE;
+    FREQ_TIM->CR1 = STM32_TIM_CR1_URS | STM32_TIM_CR1_CEN;
+
+    nvicEnableVector(STM32_TIM8_UP_NUMBER, STM32_ICU_TIM8_IRQ_PRIORITY);
+    nvicEnableVector(STM32_TIM8_CC_NUMBER, STM32_ICU_TIM8_IRQ_PRIORITY);
+
+    chThdCreateStatic(freq_thd_wa, sizeof(freq_thd_wa), NORMALPRIO, freq_thd, NULL);
+}
+
+#else
+
+/* Nothing is Counted & P2 is the uBlox PPS - its Shape Goes into CFG-TP5 */
+void freq_monitor_configure(const settings_t *set)
+{
+    cs2100_ratio_t ratio;
+
+    cs2100_ratio(set->out_freq_hz, &ratio);
+    pll_retune(&ratio);
+    gps_cable_delay(set->cable_delay_ns);
+    gps_pps_shape(set->pps_width_us, set->pps_inverted);
+    settings_applied();
+}
+
+
+void freq_monitor_init(bool rising_edge, const settings_t *set)
+{
+    (void)rising_edge;
+    gps_pps_shape(set->pps_width_us, set->pps_inverted);
+}
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef FREQ_MONITOR_H
+#define FREQ_MONITOR_H
+
+#include "ch.h"
+#include "hal.h"
+#include "settings.h"
+
+/* Measurement & Output PPS on TIM8 - Needs CLK_OUT (P3) Wired to PA0, the GPS
+ * PPS (P2) to PC6, and P2 Driven from PC7 in Place of the uBlox SAFEBOOT Pulse.
+ * Without it P2 Carries the uBlox PPS and the Settings Apply at Once.
+ */
+#if !defined(FREQ_MONITOR_USE_TIM8)
+#define FREQ_MONITOR_USE_TIM8 FALSE
+#endif
+
+/* Reference Counted by TIM8 - CS2100 CLK_OUT on PA0 (ETR), PPS on PC6 (CH1) */
+#define FREQ_MONITOR_ETR_DIV    2                       // ETR prescaler, counter must stay below TIMCLK2 / 4
+
+/* Seconds Averaged for Frequency Error & Jitter */
+#define FREQ_MONITOR_WINDOW     64
+
+/* Largest Believable Second - Anything Further Out is a Missed or Extra Pulse */
+#define FREQ_MONITOR_MAX_ERR(hz) ((hz) / 1000)
+
+
+/* PPS to Reference Self-Measurement
+ * TIM8 counts the disciplined reference through its ETR prescaler, and
+ * captures the count on each PPS edge. The 16 bit counter is extended to
+ * 32 bits in the overflow interrupt. Each second is logged as the count,
+ * its frequency error, and the error and jitter over the last window.
+ * CH2 generates the output PPS (PC7) at the counts holdover asks for, so
+ * it keeps going when the GPS PPS does not. New settings are taken just
+ * after an output rise, so the pulse in progress keeps its shape.
+ */
+
+/* Start Counting at set, Capturing the PPS on its Active Edge */
+void freq_monitor_init(bool rising_edge, const settings_t *set);
+
+/* Take set at the Next Output Rise, or Straight Away Before the First */
+void freq_monitor_configure(const settings_t *set);
+
+#endif
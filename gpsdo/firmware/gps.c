@@ -5,28 +5,111 @@
 #include "packets.h"
 #include "cs2100.h"
 #include "usb_serial_link.h"
+#include "gps_link.h"
+#include "ubx_handlers.h"
 
 MUTEX_DECL(pos_pkt_mutex);
 
-/* Serial Setup */
-static SerialDriver* gps_seriald;
-static SerialConfig serial_cfg = {
-    .speed = 9600,
-    .cr1 = 0,
-    .cr2 = 0,
-    .cr3 = 0,
-};
+/* Serial Setup - the uBlox Starts at GPS_DEFAULT_BAUD */
+#define GPS_DEFAULT_BAUD 9600
+#define GPS_BAUD_SETTLE 100                         // ms for both ends to switch
+
+/* Bauds to Try, Fastest First */
+static const uint32_t gps_bauds[] = {460800, 115200};
+
+/* Share of the Link Periodic Messages may Use (%) */
+#define GPS_LINK_BUDGET 50
+
+/* Satellites Assumed in NAV-SAT for the Budget - One per Channel */
+#define GPS_SAT_BUDGET 32
+
+/* Longer Frames are Taken as a Corrupt Length */
+#define UBX_MAX_LENGTH 1024
+
+/* Time to Wait for an ACK/NAK (ms) */
+#define GPS_ACK_TIMEOUT 1000
+
+/* Finding the Baud - Time per Poll (ms) & Passes Over the Bauds While the uBlox Boots */
+#define GPS_PROBE_TIMEOUT 250
+#define GPS_PROBE_ROUNDS 3
+
+/* Longest Poll Request Payload */
+#define GPS_POLL_MAX_REQ 4
+
+/* Port Number of UART1 in CFG-PRT & CFG-MSG */
+#define GPS_UART_PORT 1
 
 /* Config Flag */
 static bool gps_configured = false;
 
+/* Powered Up with the MCU - the uBlox Starts at GPS_DEFAULT_BAUD */
+static bool gps_cold;
+
+/* Timepulse Settings - the Delay & the PPS Shape Change at Runtime */
+static bool tp_rising_edge;
+static volatile int16_t tp_cable_delay;
+static volatile uint32_t tp_width_us = 60;
+static volatile bool tp_inverted;
+static volatile bool tp_pending;
+
+/* Periodic Messages to Enable - Set by gps_init */
+static struct {
+    bool nav_pvt, nav_posecef, tim_tp, signal;
+} gps_msgs;
+
+/* Reply Being Polled For - Captured Whether or Not a Handler Decodes it */
+static struct {
+    uint8_t class, id;
+    bool active;
+} poll;
+
+/* Streaming Parser - Fixed Memory Whatever the Frame Length */
+static struct {
+    enum {
+        UBX_STATE_SYNC1, UBX_STATE_SYNC2, UBX_STATE_HEADER,
+        UBX_STATE_PAYLOAD, UBX_STATE_CK_A, UBX_STATE_CK_B
+    } state;
+    uint8_t header[4];                              // Class, ID & length
+    uint8_t header_len;
+    uint16_t length;
+    uint16_t pos;                                   // Payload bytes so far
+    uint16_t ck;
+    uint8_t ck_a;
+    const ubx_handler_t *handler;                   // NULL if not decoded
+    bool polled;                                    // The reply gps_poll is waiting for
+    uint8_t head[UBX_HEAD_SIZE] __attribute__((aligned(4)));
+    uint8_t block[UBX_BLOCK_SIZE];
+} parser;
+
 /* Function Prototypes */
-static uint16_t gps_fletcher_8(uint16_t chk, uint8_t *buf, uint8_t n);
+static uint16_t gps_fletcher_8(uint16_t chk, const uint8_t *buf, size_t n);
 static void gps_checksum(uint8_t *buf);
 static bool gps_transmit(uint8_t *buf);
-static enum ublox_result ublox_state_machine(uint8_t b);
-static bool gps_configure(bool nav_pvt, bool nav_posecef, bool rising_edge);
+static enum ublox_result ublox_next_frame(void);
+static size_t ublox_parse(const uint8_t *buf, size_t n, enum ublox_result *result);
+static void ublox_capture(const uint8_t *buf, size_t n, uint16_t pos);
+static bool gps_configure(void);
 static bool gps_tx_ack(uint8_t *buf);
+static uint16_t gps_poll(uint8_t class, uint8_t id, const uint8_t *req, uint16_t n,
+                         uint8_t *reply, uint16_t size, uint16_t timeout);
+static bool gps_poll_frame(const uint8_t *frame, uint16_t n, uint8_t *held, uint16_t size);
+static bool gps_timepulses(void);
+static bool gps_timepulse_held(uint8_t tp_idx);
+static void gps_port_setup(ubx_cfg_prt_t *prt, uint32_t baud);
+static void gps_gnss_setup(ubx_cfg_gnss_t *gnss);
+static void gps_nav5_setup(ubx_cfg_nav5_t *nav5);
+static void gps_rate_setup(ubx_cfg_rate_t *rate);
+static void gps_sbas_setup(ubx_cfg_sbas_t *sbas);
+static void gps_tp5_setup(ubx_cfg_tp5_t *tp5, uint8_t tp_idx);
+static uint32_t gps_negotiate_baud(void);
+static bool gps_find_baud(void);
+static bool gps_enable_msg(uint8_t class, uint8_t id, uint16_t length, uint32_t *load, bool verify);
+static bool gps_messages(bool verify);
+static bool gps_gnss_held(const ubx_cfg_gnss_t *gnss);
+static bool gps_config_held(void);
+static bool gps_save(void);
+static void gps_reset(void);
+static void gps_start(void);
 
 /* Global Position Packet */
 position_packet pos_pkt;
@@ -34,18 +117,10 @@ position_packet pos_pkt;
 /* Position Packet Mutex */
 mutex_t pos_pkt_mutex;
 
-/* UBX Decoding State Machine States */
-typedef enum {
-    STATE_IDLE = 0, STATE_SYNC1, STATE_SYNC2,
-    STATE_CLASS, STATE_ID, STATE_L1, STATE_L2,
-    STATE_PAYLOAD, STATE_CK_A, NUM_STATES
-} ubx_state;
-
-
 /* Run the Fletcher-8 checksum, initialised to chk, over n bytes of buf */
-static uint16_t gps_fletcher_8(uint16_t chk, uint8_t *buf, uint8_t n)
+static uint16_t gps_fletcher_8(uint16_t chk, const uint8_t *buf, size_t n)
 {
-    int i;
+    size_t i;
     uint8_t ck_a = chk & 0xff, ck_b = chk>>8;
 
     /* Run Fletcher-8 algorithm */
@@ -86,7 +161,7 @@ static void gps_checksum(uint8_t *buf)
  */
 static bool gps_transmit(uint8_t *buf)
 {
-    size_t n, nwritten;
+    size_t n;
     systime_t timeout;
 
     /* Add checksum to outgoing message */
@@ -97,8 +172,7 @@ static bool gps_transmit(uint8_t *buf)
     timeout = MS2ST(n*2);
 
     /* Transmit message */
-    nwritten = sdWriteTimeout(gps_seriald, buf, n, timeout);
-    return nwritten == n;
+    return gps_link_write(buf, n, timeout);
 }
 
 
@@ -107,481 +181,800 @@ static bool gps_transmit(uint8_t *buf)
  */
 static bool gps_tx_ack(uint8_t *buf)
 {
+    enum ublox_result r;
+    systime_t start;
+
     if(!gps_transmit(buf)) {
         return false;
     }
 
-    enum ublox_result r;
-    do {
-        r = ublox_state_machine(sdGet(gps_seriald));
-    } while( (r != UBLOX_ACK) && (r != UBLOX_NAK) );
-
-    if(r == UBLOX_NAK){
-        return false;
+    /* Parse Frames as they Arrive until the ACK/NAK */
+    start = chVTGetSystemTime();
+    while(chVTTimeElapsedSinceX(start) < MS2ST(GPS_ACK_TIMEOUT)) {
+        gps_link_wait(MS2ST(100));
+        while((r = ublox_next_frame()) != UBLOX_WAIT) {
+            if(r == UBLOX_ACK)
+                return true;
+            if(r == UBLOX_NAK)
+                return false;
+        }
     }
-    return true;
+    return false;
 }
 
 
-/* Run new byte b through the UBX decoding state machine. Note that this
- * function preserves static state and processes new messages as appropriate
- * once received.
+/* Keep the payload head, and hand each repeated block to the layout
+ * as it completes. pos is the payload offset of buf[0]. A polled
+ * reply keeps its head alone, for gps_poll to take.
  */
-static enum ublox_result ublox_state_machine(uint8_t b)
+static void ublox_capture(const uint8_t *buf, size_t n, uint16_t pos)
 {
-    static ubx_state state = STATE_IDLE;
-
-    static uint8_t class, id;
-    static uint16_t length;
-    static uint16_t length_remaining;
-    static uint8_t payload[128];
-    static uint8_t ck_a, ck_b;
-    static uint16_t ck;
-
-    ubx_cfg_nav5_t cfg_nav5;
-    ublox_posecef_t posecef;
-    ublox_pvt_t pvt_data;
-    
-
-    switch(state) {
-        case STATE_IDLE:
-            if(b == UBX_SYNC1)
-                state = STATE_SYNC1;
-            break;
-
-        case STATE_SYNC1:
-            if(b == UBX_SYNC2)
-                state = STATE_SYNC2;
-            else
-                state = STATE_IDLE;
-            break;
-
-        case STATE_SYNC2:
-            class = b;
-            state = STATE_CLASS;
-            break;
-
-        case STATE_CLASS:
-            id = b;
-            state = STATE_ID;
-            break;
-
-        case STATE_ID:
-            length = (uint16_t)b;
-            state = STATE_L1;
-            break;
-
-        case STATE_L1:
-            length |= (uint16_t)b << 8;
-            if(length >= 128) {
-                state = STATE_IDLE;
-                return UBLOX_RXLEN_TOO_LONG;
-            }
-            length_remaining = length;
-            state = STATE_PAYLOAD;
-            break;
-
-        case STATE_PAYLOAD:
-            if(length_remaining) {
-                payload[length - length_remaining--] = b;
-            } else {
-                ck_a = b;
-                state = STATE_CK_A;
-            }
-            break;
-
-        case STATE_CK_A:
-            ck_b = b;
-            state = STATE_IDLE;
-
-            /* Verify checksum */
-            ck = gps_fletcher_8(0, &class, 1);
-            ck = gps_fletcher_8(ck, &id, 1);
-            ck = gps_fletcher_8(ck, (uint8_t*)&length, 2);
-            ck = gps_fletcher_8(ck, payload, length);
-            if(ck_a != (ck&0xFF) || ck_b != (ck>>8)) {
-                state=STATE_IDLE;
-                return UBLOX_BAD_CHECKSUM;
-            }
+    const ubx_block_layout_t *layout;
+    size_t i, offset;
 
-            /* Handle Payload */
-            switch(class) {
-
-                /* Acknowledge */
-                case UBX_ACK:
-                    if(id == UBX_ACK_NAK) {
-                        /* NAK */
-                        return UBLOX_NAK;
-                    } else if(id == UBX_ACK_ACK) {
-                        /* ACK - Do Nothing */
-                        return UBLOX_ACK;
-                    } else {
-                        return UBLOX_UNHANDLED;
-                    }
-                    break;
+    if(parser.handler == NULL && !parser.polled)
+        return;
+    if(pos < UBX_HEAD_SIZE)
+        memcpy(&parser.head[pos], buf, (n < (size_t)(UBX_HEAD_SIZE - pos)) ? n : (size_t)(UBX_HEAD_SIZE - pos));
 
-                /* Nav Payload */
-                case UBX_NAV:
-                    if(id == UBX_NAV_PVT) {
-
-                        /* Extract NAV-PVT Payload */
-                        memcpy(&pvt_data, payload, length);
-                                                
-                        /* Generate Position Packet */
-	                    chMtxLock(&pos_pkt_mutex);
-	                    
-	                    pos_pkt.lon = pvt_data.lon;
-	                    pos_pkt.lat = pvt_data.lat;
-	                    pos_pkt.height = pvt_data.height;
-	                    pos_pkt.num_sat = pvt_data.num_sv;
-                        pos_pkt.fix_type = pvt_data.fix_type;
-                        pos_pkt.year = pvt_data.year;
-                        pos_pkt.month = pvt_data.month;
-                        pos_pkt.day = pvt_data.day;
-                        pos_pkt.hour = pvt_data.hour;
-                        pos_pkt.minute = pvt_data.minute;
-                        pos_pkt.second = pvt_data.second;
-                        pos_pkt.pll_lock = cs2100_pll_status();
-                        
-                        upload_position_packet(&pos_pkt);
-        
-	                    chMtxUnlock(&pos_pkt_mutex);
-	                    
-                        return UBLOX_NAV_PVT;
-
-                    } else if(id == UBX_NAV_POSECEF){
-
-                        /* Extract NAV-POSECEF Payload */
-                        memcpy(&posecef, payload, length);
-                        return UBLOX_NAV_POSECEF;
-
-                    } else {
-                        return UBLOX_UNHANDLED;
-                    }
-                    break;
+    if(parser.polled)
+        return;
+    layout = parser.handler->layout;
+    if(layout == NULL)
+        return;
+    for(i = (pos < layout->start) ? layout->start - pos : 0; i < n; i++) {
+        offset = pos + i - layout->start;
+        parser.block[offset % layout->size] = buf[i];
+        if(offset % layout->size == layout->size - 1u)
+            layout->block(parser.block, offset / layout->size);
+    }
+}
 
-                /* Config Payload */
-                case UBX_CFG:
-                    if(id == UBX_CFG_NAV5) {
-
-                        /* NAV5 */
-                        memcpy(cfg_nav5.payload, payload, length);
-                        if(cfg_nav5.dyn_model != 2) {
-                        }
-                        return UBLOX_CFG_NAV5;
-                    } else {
-                        return UBLOX_UNHANDLED;
-                    }
+
+/* Run the parser over n received bytes, stopping after the end of a
+ * frame. Payload bytes are checksummed and captured a run at a time.
+ * Returns the number of bytes used and sets *result at a frame end.
+ */
+static size_t ublox_parse(const uint8_t *buf, size_t n, enum ublox_result *result)
+{
+    const uint8_t *sync;
+    size_t i = 0, run;
+    uint8_t b;
+
+    while(i < n) {
+        switch(parser.state) {
+
+            /* Skip to the Next Sync Byte */
+            case UBX_STATE_SYNC1:
+                sync = memchr(&buf[i], UBX_SYNC1, n - i);
+                if(sync == NULL)
+                    return n;
+                i = sync - buf + 1;
+                parser.state = UBX_STATE_SYNC2;
+                break;
+
+            case UBX_STATE_SYNC2:
+                b = buf[i++];
+                if(b == UBX_SYNC2) {
+                    parser.header_len = 0;
+                    parser.ck = 0;
+                    parser.state = UBX_STATE_HEADER;
+                } else if(b != UBX_SYNC1) {
+                    parser.state = UBX_STATE_SYNC1;
+                }
+                break;
+
+            /* Class, ID & Length */
+            case UBX_STATE_HEADER:
+                b = buf[i++];
+                parser.header[parser.header_len++] = b;
+                parser.ck = gps_fletcher_8(parser.ck, &b, 1);
+                if(parser.header_len < 4)
                     break;
+                parser.length = parser.header[2] | (parser.header[3] << 8);
+                if(parser.length > UBX_MAX_LENGTH) {
+                    parser.state = UBX_STATE_SYNC1;
+                    *result = UBLOX_RXLEN_TOO_LONG;
+                    return i;
+                }
+                parser.pos = 0;
+                parser.handler = ubx_find_handler(parser.header[0], parser.header[1]);
+                parser.polled = poll.active && parser.header[0] == poll.class &&
+                                parser.header[1] == poll.id;
+                if(parser.handler && parser.handler->layout && !parser.polled)
+                    parser.handler->layout->begin();
+                parser.state = parser.length ? UBX_STATE_PAYLOAD : UBX_STATE_CK_A;
+                break;
+
+            /* Payload - Checksum Every Byte, Keep Only What is Needed */
+            case UBX_STATE_PAYLOAD:
+                run = parser.length - parser.pos;
+                if(run > n - i)
+                    run = n - i;
+                parser.ck = gps_fletcher_8(parser.ck, &buf[i], run);
+                ublox_capture(&buf[i], run, parser.pos);
+                parser.pos += run;
+                i += run;
+                if(parser.pos == parser.length)
+                    parser.state = UBX_STATE_CK_A;
+                break;
+
+            case UBX_STATE_CK_A:
+                parser.ck_a = buf[i++];
+                parser.state = UBX_STATE_CK_B;
+                break;
+
+            /* Frame End - Handled Only if the Checksum Holds */
+            case UBX_STATE_CK_B:
+                b = buf[i++];
+                parser.state = UBX_STATE_SYNC1;
+                if(parser.ck_a != (parser.ck & 0xFF) || b != (parser.ck >> 8))
+                    *result = UBLOX_BAD_CHECKSUM;
+                else if(parser.polled)
+                    *result = UBLOX_POLLED;
+                else if(parser.handler == NULL || parser.length < parser.handler->min_len)
+                    *result = UBLOX_UNHANDLED;
+                else
+                    *result = parser.handler->handle(parser.head, parser.length);
+                return i;
+        }
+    }
+    return i;
+}
 
-                /* Unhandled */
-                default:
-                    return UBLOX_UNHANDLED;
-            }
-            break;
 
-        default:
-            state = STATE_IDLE;
-            return UBLOX_ERROR;
+/* Feed received bytes straight from the ring to the parser until a
+ * frame ends. Returns UBLOX_WAIT once everything received is used.
+ */
+static enum ublox_result ublox_next_frame(void)
+{
+    enum ublox_result result = UBLOX_WAIT;
+    const uint8_t *span;
+    size_t n;
+
+    while(result == UBLOX_WAIT && (n = gps_link_span(&span)) > 0)
+        gps_link_consume(ublox_parse(span, n, &result));
+
+    return result;
+}
+
+
+/* Poll a setting, the request payload being the n bytes at req, and
+ * copy up to size bytes of the reply into reply. CFG polls are ACKed
+ * after the reply, so the ACK is waited for too, leaving nothing to be
+ * taken for the next command's. Returns the bytes copied, 0 if no reply.
+ */
+static uint16_t gps_poll(uint8_t class, uint8_t id, const uint8_t *req, uint16_t n,
+                         uint8_t *reply, uint16_t size, uint16_t timeout)
+{
+    uint8_t buf[8 + GPS_POLL_MAX_REQ];
+    enum ublox_result r;
+    systime_t start;
+    uint16_t got = 0;
+
+    if(n > GPS_POLL_MAX_REQ)
+        return 0;
+
+    buf[0] = UBX_SYNC1;
+    buf[1] = UBX_SYNC2;
+    buf[2] = class;
+    buf[3] = id;
+    buf[4] = n;
+    buf[5] = 0;
+    if(n)
+        memcpy(&buf[6], req, n);
+
+    poll.class = class;
+    poll.id = id;
+    poll.active = true;
+
+    if(!gps_transmit(buf)) {
+        poll.active = false;
+        return 0;
+    }
+
+    /* Parse Frames as they Arrive until the ACK/NAK */
+    start = chVTGetSystemTime();
+    while(chVTTimeElapsedSinceX(start) < MS2ST(timeout)) {
+        gps_link_wait(MS2ST(100));
+        while((r = ublox_next_frame()) != UBLOX_WAIT) {
+            if(r == UBLOX_POLLED && poll.active) {
+                poll.active = false;
+                got = (parser.length < size) ? parser.length : size;
+                if(got > UBX_HEAD_SIZE)
+                    got = UBX_HEAD_SIZE;
+                memcpy(reply, parser.head, got);
+            }
+            if(r == UBLOX_ACK || r == UBLOX_NAK) {
+                poll.active = false;
+                return got;
+            }
+        }
     }
-    return UBLOX_WAIT;
+    poll.active = false;
+    return got;
 }
 
 
-/* Configure uBlox GPS */
-static bool gps_configure(bool nav_pvt, bool nav_posecef, bool rising_edge) {
+/* Poll the setting a frame sets, the first n bytes of its payload
+ * being the request, into held. True if a reply of size bytes came.
+ */
+static bool gps_poll_frame(const uint8_t *frame, uint16_t n, uint8_t *held, uint16_t size)
+{
+    return gps_poll(frame[2], frame[3], &frame[6], n, held, size, GPS_ACK_TIMEOUT) == size;
+}
 
-    gps_configured = true;
 
-    ubx_cfg_prt_t prt;
-    ubx_cfg_nav5_t nav5;
-    ubx_cfg_msg_t msg;
-    ubx_cfg_msg_t msg2;
-    ubx_cfg_rate_t rate;
-    ubx_cfg_sbas_t sbas;
-    ubx_cfg_gnss_t gnss;
-    ubx_cfg_tp5_t tp5_1;
-    ubx_cfg_tp5_t tp5_2;
-
-    /* Disable NMEA on UART */
-    prt.sync1 = UBX_SYNC1;
-    prt.sync2 = UBX_SYNC2;
-    prt.class = UBX_CFG;
-    prt.id = UBX_CFG_PRT;
-    prt.length = sizeof(prt.payload);
+/* UBX-CFG-PRT for UART1 at baud, UBX Only */
+static void gps_port_setup(ubx_cfg_prt_t *prt, uint32_t baud)
+{
+    prt->sync1 = UBX_SYNC1;
+    prt->sync2 = UBX_SYNC2;
+    prt->class = UBX_CFG;
+    prt->id = UBX_CFG_PRT;
+    prt->length = sizeof(prt->payload);
     /* Program UART1 */
-    prt.port_id = 1;
+    prt->port_id = GPS_UART_PORT;
+    prt->reserved0 = 0;
     /* Don't use TXReady GPIO */
-    prt.tx_ready = 0;
+    prt->tx_ready = 0;
     /* 8 bits, no polarity, 1 stop bit */
-    prt.mode = (1<<4) | (3<<6) | (4<<9);
-    /* 9600 baud */
-    prt.baud_rate = 9600;
+    prt->mode = (1<<4) | (3<<6) | (4<<9);
+    prt->baud_rate = baud;
     /* only receive UBX protocol */
-    prt.in_proto_mask = (1<<0);
+    prt->in_proto_mask = (1<<0);
     /* only send UBX protocol */
-    prt.out_proto_mask = (1<<0);
+    prt->out_proto_mask = (1<<0);
     /* no weird timeout */
-    prt.flags = 0;
+    prt->flags = 0;
     /* must be 0 */
-    prt.reserved5 = 0;
-    gps_configured &= gps_transmit((uint8_t*)&prt);
-    if(!gps_configured) return false;
-
-    /* Wait for it to stop barfing NMEA */
-    chThdSleepMilliseconds(300);
+    prt->reserved5 = 0;
+}
 
-    /* Clear the read buffer */
-    while(sdGetTimeout(gps_seriald, TIME_IMMEDIATE) != Q_TIMEOUT);
-    
-    /* Disable non GPS systems */
-    gnss.sync1 = UBX_SYNC1;
-    gnss.sync2 = UBX_SYNC2;
-    gnss.class = UBX_CFG;
-    gnss.id = UBX_CFG_GNSS;
-    gnss.length = sizeof(gnss.payload);
 
-    gnss.msg_ver = 0;
-    gnss.num_trk_ch_hw = 32;
-    gnss.num_trk_ch_use = 32;
-    gnss.num_config_blocks = 5;
+/* UBX-CFG-GNSS - GPS & QZSS Only */
+static void gps_gnss_setup(ubx_cfg_gnss_t *gnss)
+{
+    memset(gnss, 0, sizeof(*gnss));
+    gnss->sync1 = UBX_SYNC1;
+    gnss->sync2 = UBX_SYNC2;
+    gnss->class = UBX_CFG;
+    gnss->id = UBX_CFG_GNSS;
+    gnss->length = sizeof(gnss->payload);
+
+    gnss->msg_ver = 0;
+    gnss->num_trk_ch_hw = 32;
+    gnss->num_trk_ch_use = 32;
+    gnss->num_config_blocks = 5;
 
     /* Enable GPS, use all-1 channels */
-    gnss.gps_gnss_id = 0;
-    gnss.gps_res_trk_ch = 31;
-    gnss.gps_max_trk_ch = 31;
-    gnss.gps_flags = 1+(1<<16);
+    gnss->gps_gnss_id = 0;
+    gnss->gps_res_trk_ch = 31;
+    gnss->gps_max_trk_ch = 31;
+    gnss->gps_flags = 1+(1<<16);
 
     /* Enable QZSS as per protocol spec */
-    gnss.qzss_gnss_id = 5;
-    gnss.qzss_res_trk_ch = 1;
-    gnss.qzss_max_trk_ch = 1;
-    gnss.qzss_flags = 1+(1<<16);
+    gnss->qzss_gnss_id = 5;
+    gnss->qzss_res_trk_ch = 1;
+    gnss->qzss_max_trk_ch = 1;
+    gnss->qzss_flags = 1+(1<<16);
 
     /* Leave all other GNSS systems disabled */
-    gnss.sbas_gnss_id = 1;
-    gnss.beidou_gnss_id = 3;
-    gnss.glonass_gnss_id = 6;
-    gps_configured &= gps_tx_ack((uint8_t*)&gnss);
-    if(!gps_configured) return false;
+    gnss->sbas_gnss_id = 1;
+    gnss->beidou_gnss_id = 3;
+    gnss->glonass_gnss_id = 6;
+}
 
-    /* Wait for reset */
-    chThdSleepMilliseconds(500);    
-    
-    
-    /* Re-disable NMEA Output */
-    gps_configured &= gps_transmit((uint8_t*)&prt);
-    if(!gps_configured) return false;
-    
-    /* Wait for it to stop barfing NMEA */
-    chThdSleepMilliseconds(300);
-    
-    /* Clear the read buffer */
-    while(sdGetTimeout(gps_seriald, TIME_IMMEDIATE) != Q_TIMEOUT);
 
-    
-    /* Set to Stationary mode */
-    nav5.sync1 = UBX_SYNC1;
-    nav5.sync2 = UBX_SYNC2;
-    nav5.class = UBX_CFG;
-    nav5.id = UBX_CFG_NAV5;
-    nav5.length = sizeof(nav5.payload);
+/* UBX-CFG-NAV5 - Stationary, UTC from USNO */
+static void gps_nav5_setup(ubx_cfg_nav5_t *nav5)
+{
+    memset(nav5, 0, sizeof(*nav5));
+    nav5->sync1 = UBX_SYNC1;
+    nav5->sync2 = UBX_SYNC2;
+    nav5->class = UBX_CFG;
+    nav5->id = UBX_CFG_NAV5;
+    nav5->length = sizeof(nav5->payload);
+
+    nav5->mask = 1 | (1<<10);
+    nav5->dyn_model = 2;
+    nav5->utc_standard = 3;  // USNO
+}
 
-    nav5.mask = 1 | (1<<10);
-    nav5.dyn_model = 2;
-    nav5.utc_standard = 3;  // USNO
 
-    gps_configured &= gps_tx_ack((uint8_t*)&nav5);
-    if(!gps_configured) return false;
+/* UBX-CFG-RATE - 1Hz Solutions */
+static void gps_rate_setup(ubx_cfg_rate_t *rate)
+{
+    rate->sync1 = UBX_SYNC1;
+    rate->sync2 = UBX_SYNC2;
+    rate->class = UBX_CFG;
+    rate->id = UBX_CFG_RATE;
+    rate->length = sizeof(rate->payload);
+
+    rate->meas_rate = 1000;
+    rate->nav_rate = 1;
+    rate->time_ref = 0;  // UTC
+}
 
-    /* Set solution rate to 1Hz */
-    rate.sync1 = UBX_SYNC1;
-    rate.sync2 = UBX_SYNC2;
-    rate.class = UBX_CFG;
-    rate.id = UBX_CFG_RATE;
-    rate.length = sizeof(rate.payload);
-
-    rate.meas_rate = 1000;
-    rate.nav_rate = 1;
-    rate.time_ref = 0;  // UTC
-    
-    gps_configured &= gps_tx_ack((uint8_t*)&rate);
-    if(!gps_configured) return false;
 
+/* UBX-CFG-SBAS - Disabled */
+static void gps_sbas_setup(ubx_cfg_sbas_t *sbas)
+{
+    memset(sbas, 0, sizeof(*sbas));
+    sbas->sync1 = UBX_SYNC1;
+    sbas->sync2 = UBX_SYNC2;
+    sbas->class = UBX_CFG;
+    sbas->id = UBX_CFG_SBAS;
+    sbas->length = sizeof(sbas->payload);
+    sbas->mode = 0;
+}
 
-    /* Disable sbas */
-    sbas.sync1 = UBX_SYNC1;
-    sbas.sync2 = UBX_SYNC2;
-    sbas.class = UBX_CFG;
-    sbas.id = UBX_CFG_SBAS;
-    sbas.length = sizeof(sbas.payload);
-    sbas.mode = 0;
-    
-    gps_configured &= gps_tx_ack((uint8_t*)&sbas);
-    if(!gps_configured) return false;
 
+/* Move the uBlox & USART1 to the fastest baud that is ACKed there,
+ * falling back in turn and staying put if none are. Returns the baud.
+ */
+static uint32_t gps_negotiate_baud(void)
+{
+    ubx_cfg_prt_t prt;
+    uint32_t base = gps_link_baud();
+    size_t i;
+
+    for(i=0; i<sizeof(gps_bauds)/sizeof(gps_bauds[0]); i++) {
+        if(gps_bauds[i] == base)
+            return base;
+
+        /* Request the switch - Its ACK is Lost in the Change */
+        gps_port_setup(&prt, gps_bauds[i]);
+        if(!gps_transmit((uint8_t*)&prt))
+            continue;
+        gps_link_set_baud(gps_bauds[i]);
+        chThdSleepMilliseconds(GPS_BAUD_SETTLE);
+        gps_link_flush();
+
+        /* Verify by Repeating the Setting at the New Baud */
+        if(gps_tx_ack((uint8_t*)&prt))
+            return gps_bauds[i];
+
+        /* No ACK - Send the uBlox Back in Case it did Switch */
+        gps_port_setup(&prt, base);
+        gps_transmit((uint8_t*)&prt);
+        gps_link_set_baud(base);
+        chThdSleepMilliseconds(GPS_BAUD_SETTLE);
+        gps_link_flush();
+    }
+    return base;
+}
 
-    /* Set up 1MHz timepulse on TIMEPULSE pin*/
-    tp5_1.sync1 = UBX_SYNC1;
-    tp5_1.sync2 = UBX_SYNC2;
-    tp5_1.class = UBX_CFG;
-    tp5_1.id = UBX_CFG_TP5;
-    tp5_1.length = sizeof(tp5_1.payload);
-
-    /* Outputs only when locked */
-    tp5_1.tp_idx =           0;                   // TIMEPULSE
-    tp5_1.version =          0;
-    tp5_1.ant_cable_delay =  0;
-    tp5_1.freq_period =      1;           
-    tp5_1.pulse_len_ratio =  0;   
-    tp5_1.freq_period_lock = 1000000;             // 1 MHz
-    tp5_1.pulse_len_ratio_lock = 0xffffffff >> 1; // (2^32/2)/2^32 = 50% duty cycle
-    tp5_1.user_config_delay = 0;
-    tp5_1.flags = (
-        UBX_CFG_TP5_FLAGS_ACTIVE                    |
-        UBX_CFG_TP5_FLAGS_LOCK_GNSS_FREQ            |
-        UBX_CFG_TP5_FLAGS_LOCKED_OTHER_SET          |
-        UBX_CFG_TP5_FLAGS_IS_FREQ                   |
-        UBX_CFG_TP5_FLAGS_ALIGN_TO_TOW              |
-        UBX_CFG_TP5_FLAGS_POLARITY                  |
-        UBX_CFG_TP5_FLAGS_GRID_UTC_GNSS_GPS         |
-        UBX_CFG_TP5_FLAGS_GRID_UTC_GNSS_UTC);
-    
-    gps_configured &= gps_tx_ack((uint8_t*)&tp5_1);
-    if(!gps_configured) return false;
 
+/* Find the baud the uBlox is at by polling its port settings, a few
+ * times over while it boots. From power on it is at the default, otherwise
+ * still where the last run left it, so that is tried first.
+ */
+static bool gps_find_baud(void)
+{
+    uint8_t port = GPS_UART_PORT;
+    uint8_t reply[sizeof(((ubx_cfg_prt_t*)0)->payload)];
+    uint32_t bauds[sizeof(gps_bauds)/sizeof(gps_bauds[0]) + 1];
+    size_t n = 0, i, round;
+
+    if(gps_cold)
+        bauds[n++] = GPS_DEFAULT_BAUD;
+    for(i=0; i<sizeof(gps_bauds)/sizeof(gps_bauds[0]); i++)
+        bauds[n++] = gps_bauds[i];
+    if(!gps_cold)
+        bauds[n++] = GPS_DEFAULT_BAUD;
+
+    for(round=0; round<GPS_PROBE_ROUNDS; round++) {
+        for(i=0; i<n; i++) {
+            gps_link_set_baud(bauds[i]);
+            if(gps_poll(UBX_CFG, UBX_CFG_PRT, &port, 1, reply, sizeof(reply), GPS_PROBE_TIMEOUT))
+                return true;
+        }
+    }
+    return false;
+}
+
+
+/* Rate a message gets - 1Hz if it fits the link budget, adding its
+ * frame to load (bytes/s), otherwise off. With verify the rate is only
+ * polled back and compared. Messages nothing decodes are left alone.
+ */
+static bool gps_enable_msg(uint8_t class, uint8_t id, uint16_t length, uint32_t *load, bool verify)
+{
+    ubx_cfg_msg_t msg;
+    uint8_t held[8];                                // Class, ID & a rate per port
+    uint32_t frame = length + 8;
+
+    /* Nothing Here Decodes it */
+    if(ubx_find_handler(class, id) == NULL)
+        return true;
+
+    msg.sync1 = UBX_SYNC1;
+    msg.sync2 = UBX_SYNC2;
+    msg.class = UBX_CFG;
+    msg.id = UBX_CFG_MSG;
+    msg.length = sizeof(msg.payload);
+
+    msg.msg_class = class;
+    msg.msg_id    = id;
+
+    /* 10 Bits per Byte on the Wire */
+    msg.rate = ((*load + frame) * 10 * 100 <= gps_link_baud() * GPS_LINK_BUDGET) ? 1 : 0;
+    if(msg.rate)
+        *load += frame;
+
+    if(verify)
+        return gps_poll_frame((uint8_t*)&msg, 2, held, sizeof(held)) &&
+               held[2 + GPS_UART_PORT] == msg.rate;
+    return gps_tx_ack((uint8_t*)&msg);
+}
+
+
+/* Periodic Messages, Highest Priority First */
+static bool gps_messages(bool verify)
+{
+    uint32_t load = 0;
+
+    /* Enable NAV PVT messages */
+    if(gps_msgs.nav_pvt &&
+       !gps_enable_msg(UBX_NAV, UBX_NAV_PVT, sizeof(ublox_pvt_t), &load, verify))
+        return false;
+
+    /* Enable NAV POSECEF messages */
+    if(gps_msgs.nav_posecef &&
+       !gps_enable_msg(UBX_NAV, UBX_NAV_POSECEF, sizeof(ublox_posecef_t), &load, verify))
+        return false;
+
+    /* Enable TIM TP messages - qErr per Pulse, Only if the Link has Room */
+    if(gps_msgs.tim_tp &&
+       !gps_enable_msg(UBX_TIM, UBX_TIM_TP, sizeof(ublox_tim_tp_t), &load, verify))
+        return false;
 
-    /* Set up 1Hz pulse on SAFEBOOT pin */
-    tp5_2.sync1 = UBX_SYNC1;
-    tp5_2.sync2 = UBX_SYNC2;
-    tp5_2.class = UBX_CFG;
-    tp5_2.id = UBX_CFG_TP5;
-    tp5_2.length = sizeof(tp5_2.payload);
+    /* Enable NAV SAT & MON HW messages - Signal Diagnostics, Lowest Priority */
+    if(gps_msgs.signal) {
+        if(!gps_enable_msg(UBX_NAV, UBX_NAV_SAT,
+                           UBX_NAV_SAT_HEAD + GPS_SAT_BUDGET * UBX_NAV_SAT_BLOCK, &load, verify))
+            return false;
+        if(!gps_enable_msg(UBX_MON, UBX_MON_HW, sizeof(ublox_mon_hw_t), &load, verify))
+            return false;
+    }
 
-    /* Outputs only when locked */
-    tp5_2.tp_idx               = 1;     // Safeboot pin
-    tp5_2.version              = 0;
-    tp5_2.ant_cable_delay      = 0;
-    tp5_2.freq_period          = 1;
-    tp5_2.pulse_len_ratio      = 0; 
-    tp5_2.freq_period_lock     = 1;     // 1 Hz
-    tp5_2.pulse_len_ratio_lock = 60;   // us
+    return true;
+}
 
-    if(rising_edge) {
 
-        /* Rising edge on top of second */
-        tp5_2.flags = (
+/* UBX-CFG-TP5 for a timepulse, advanced by the cable delay */
+static void gps_tp5_setup(ubx_cfg_tp5_t *tp5, uint8_t tp_idx)
+{
+    memset(tp5, 0, sizeof(*tp5));
+    tp5->sync1 = UBX_SYNC1;
+    tp5->sync2 = UBX_SYNC2;
+    tp5->class = UBX_CFG;
+    tp5->id = UBX_CFG_TP5;
+    tp5->length = sizeof(tp5->payload);
+
+    tp5->tp_idx = tp_idx;
+    tp5->version = 0;
+    tp5->ant_cable_delay = tp_cable_delay;
+    tp5->user_config_delay = 0;
+
+    if(tp_idx == 0) {
+
+        /* 1MHz on the TIMEPULSE pin - Free runs from the receiver's
+         * oscillator when unlocked, so the CS2100 keeps its input through holdover */
+        tp5->freq_period =      CS2100_CLK_IN_HZ;    // 1 MHz
+        tp5->pulse_len_ratio =  0xffffffff >> 1;     // 50% duty cycle
+        tp5->freq_period_lock = CS2100_CLK_IN_HZ;    // 1 MHz
+        tp5->pulse_len_ratio_lock = 0xffffffff >> 1; // (2^32/2)/2^32 = 50% duty cycle
+        tp5->flags = (
             UBX_CFG_TP5_FLAGS_ACTIVE                    |
             UBX_CFG_TP5_FLAGS_LOCK_GNSS_FREQ            |
             UBX_CFG_TP5_FLAGS_LOCKED_OTHER_SET          |
             UBX_CFG_TP5_FLAGS_IS_FREQ                   |
-            UBX_CFG_TP5_FLAGS_IS_LENGTH                 |
             UBX_CFG_TP5_FLAGS_ALIGN_TO_TOW              |
             UBX_CFG_TP5_FLAGS_POLARITY                  |
             UBX_CFG_TP5_FLAGS_GRID_UTC_GNSS_GPS         |
             UBX_CFG_TP5_FLAGS_GRID_UTC_GNSS_UTC);
-    } else {
+        return;
+    }
 
-        /* Falling edge on top of second */
-        tp5_2.flags = (
-            UBX_CFG_TP5_FLAGS_ACTIVE                    |
-            UBX_CFG_TP5_FLAGS_LOCK_GNSS_FREQ            |
-            UBX_CFG_TP5_FLAGS_LOCKED_OTHER_SET          |
-            UBX_CFG_TP5_FLAGS_IS_FREQ                   |
-            UBX_CFG_TP5_FLAGS_IS_LENGTH                 |
-            UBX_CFG_TP5_FLAGS_ALIGN_TO_TOW              |
-            UBX_CFG_TP5_FLAGS_GRID_UTC_GNSS_GPS         |
-            UBX_CFG_TP5_FLAGS_GRID_UTC_GNSS_UTC);
+    /* 1Hz on the SAFEBOOT pin - Outputs only when locked */
+    tp5->freq_period          = 1;
+    tp5->pulse_len_ratio      = 0;
+    tp5->freq_period_lock     = 1;     // 1 Hz
+    tp5->pulse_len_ratio_lock = tp_width_us;
+    tp5->flags = (
+        UBX_CFG_TP5_FLAGS_ACTIVE                    |
+        UBX_CFG_TP5_FLAGS_LOCK_GNSS_FREQ            |
+        UBX_CFG_TP5_FLAGS_LOCKED_OTHER_SET          |
+        UBX_CFG_TP5_FLAGS_IS_FREQ                   |
+        UBX_CFG_TP5_FLAGS_IS_LENGTH                 |
+        UBX_CFG_TP5_FLAGS_ALIGN_TO_TOW              |
+        UBX_CFG_TP5_FLAGS_GRID_UTC_GNSS_GPS         |
+        UBX_CFG_TP5_FLAGS_GRID_UTC_GNSS_UTC);
+
+    /* Rising edge on top of second, otherwise falling */
+    if(tp_rising_edge != tp_inverted)
+        tp5->flags |= UBX_CFG_TP5_FLAGS_POLARITY;
+}
+
+
+/* CLK_IN for the CS2100 & the PPS, Both Advanced by the Cable Delay */
+static bool gps_timepulses(void)
+{
+    ubx_cfg_tp5_t tp5;
+
+    gps_tp5_setup(&tp5, 0);
+    if(!gps_tx_ack((uint8_t*)&tp5))
+        return false;
+
+    gps_tp5_setup(&tp5, 1);
+    return gps_tx_ack((uint8_t*)&tp5);
+}
+
+
+/* Whether a timepulse is as gps_timepulses sets it - the RF group delay is the receiver's own */
+static bool gps_timepulse_held(uint8_t tp_idx)
+{
+    ubx_cfg_tp5_t tp5, held;
+
+    gps_tp5_setup(&tp5, tp_idx);
+    return gps_poll_frame((uint8_t*)&tp5, 1, held.payload, sizeof(held.payload)) &&
+           held.ant_cable_delay      == tp5.ant_cable_delay &&
+           held.freq_period          == tp5.freq_period &&
+           held.freq_period_lock     == tp5.freq_period_lock &&
+           held.pulse_len_ratio      == tp5.pulse_len_ratio &&
+           held.pulse_len_ratio_lock == tp5.pulse_len_ratio_lock &&
+           held.user_config_delay    == tp5.user_config_delay &&
+           held.flags                == tp5.flags;
+}
+
+
+/* Whether each system the frame sets is enabled or disabled to match -
+ * the reply lists every system the receiver has, in blocks of 8 bytes
+ */
+static bool gps_gnss_held(const ubx_cfg_gnss_t *gnss)
+{
+    uint8_t held[UBX_HEAD_SIZE];
+    const uint8_t *want;
+    uint16_t len, i, j;
+
+    len = gps_poll(UBX_CFG, UBX_CFG_GNSS, NULL, 0, held, sizeof(held), GPS_ACK_TIMEOUT);
+    if(len < 4)
+        return false;
+
+    for(i=0; i<gnss->num_config_blocks; i++) {
+        want = &gnss->payload[4 + 8*i];
+        for(j=4; j+8 <= len && held[j] != want[0]; j+=8);
+        if(j+8 > len || ((held[j+4] ^ want[4]) & 1))
+            return false;
     }
+    return true;
+}
+
+
+/* Whether the uBlox kept everything gps_configure sets, polled back
+ * setting by setting, comparing only the fields that are written.
+ */
+static bool gps_config_held(void)
+{
+    ubx_cfg_prt_t prt, held_prt;
+    ubx_cfg_gnss_t gnss;
+    ubx_cfg_nav5_t nav5, held_nav5;
+    ubx_cfg_rate_t rate, held_rate;
+    ubx_cfg_sbas_t sbas, held_sbas;
+
+    /* UBX Only, at a Faster Baud than the Default */
+    gps_port_setup(&prt, gps_link_baud());
+    if(gps_link_baud() == GPS_DEFAULT_BAUD ||
+       !gps_poll_frame((uint8_t*)&prt, 1, held_prt.payload, sizeof(held_prt.payload)) ||
+       held_prt.baud_rate != prt.baud_rate ||
+       held_prt.in_proto_mask != prt.in_proto_mask ||
+       held_prt.out_proto_mask != prt.out_proto_mask)
+        return false;
+
+    gps_gnss_setup(&gnss);
+    if(!gps_gnss_held(&gnss))
+        return false;
+
+    gps_nav5_setup(&nav5);
+    if(!gps_poll_frame((uint8_t*)&nav5, 0, held_nav5.payload, sizeof(held_nav5.payload)) ||
+       held_nav5.dyn_model != nav5.dyn_model ||
+       held_nav5.utc_standard != nav5.utc_standard)
+        return false;
+
+    gps_rate_setup(&rate);
+    if(!gps_poll_frame((uint8_t*)&rate, 0, held_rate.payload, sizeof(held_rate.payload)) ||
+       memcmp(held_rate.payload, rate.payload, sizeof(rate.payload)))
+        return false;
 
-    gps_configured &= gps_tx_ack((uint8_t*)&tp5_2);
+    gps_sbas_setup(&sbas);
+    if(!gps_poll_frame((uint8_t*)&sbas, 0, held_sbas.payload, sizeof(held_sbas.payload)) ||
+       ((held_sbas.mode ^ sbas.mode) & 1))
+        return false;
+
+    if(!gps_timepulse_held(0) || !gps_timepulse_held(1))
+        return false;
+
+    return gps_messages(true);
+}
+
+
+/* Save the Settings to BBR - this MAX-M8Q is ROM Only and V_BCKP is on 3v3,
+ * so they Last Only While Powered, e.g. Over the Recovery Reset
+ */
+static bool gps_save(void)
+{
+    ubx_cfg_cfg_t cfg;
+
+    cfg.sync1 = UBX_SYNC1;
+    cfg.sync2 = UBX_SYNC2;
+    cfg.class = UBX_CFG;
+    cfg.id = UBX_CFG_CFG;
+    cfg.length = sizeof(cfg.payload);
+
+    cfg.clear_mask = 0;
+    cfg.save_mask = UBX_CFG_CFG_IO_PORT | UBX_CFG_CFG_MSG_CONF |
+                    UBX_CFG_CFG_NAV_CONF | UBX_CFG_CFG_RXM_CONF;
+    cfg.load_mask = 0;
+    cfg.device_mask = UBX_CFG_CFG_DEV_BBR;
+
+    return gps_tx_ack((uint8_t*)&cfg);
+}
+
+
+/* Configure uBlox GPS - the Full Sequence */
+static bool gps_configure(void) {
+
+    gps_configured = true;
+
+    ubx_cfg_prt_t prt;
+    ubx_cfg_nav5_t nav5;
+    ubx_cfg_rate_t rate;
+    ubx_cfg_sbas_t sbas;
+    ubx_cfg_gnss_t gnss;
+
+    /* Disable NMEA on UART - Keeping Whatever Baud a Previous Attempt Reached.
+     * The Parser Skips NMEA Still Queued, so the ACK is Enough to Go On */
+    gps_port_setup(&prt, gps_link_baud());
+    gps_configured &= gps_tx_ack((uint8_t*)&prt);
     if(!gps_configured) return false;
 
-    
-    /* Enable NAV PVT messages */
-    if(nav_pvt){
-        msg.sync1 = UBX_SYNC1;
-        msg.sync2 = UBX_SYNC2;
-        msg.class = UBX_CFG;
-        msg.id = UBX_CFG_MSG;
-        msg.length = sizeof(msg.payload);
-
-        msg.msg_class = UBX_NAV;
-        msg.msg_id    = UBX_NAV_PVT;
-        msg.rate      = 1;
-        
-        gps_configured &= gps_tx_ack((uint8_t*)&msg);
-        if(!gps_configured) return false;
-    }
+    /* Disable non GPS systems */
+    gps_gnss_setup(&gnss);
+    gps_configured &= gps_tx_ack((uint8_t*)&gnss);
+    if(!gps_configured) return false;
 
-    
-    /* Enable NAV POSECEF messages */
-    if (nav_posecef){
-        msg2.sync1 = UBX_SYNC1;
-        msg2.sync2 = UBX_SYNC2;
-        msg2.class = UBX_CFG;
-        msg2.id = UBX_CFG_MSG;
-        msg2.length = sizeof(msg2.payload);
-
-        msg2.msg_class = UBX_NAV;
-        msg2.msg_id    = UBX_NAV_POSECEF;
-        msg2.rate      = 1;
-        
-        gps_configured &= gps_tx_ack((uint8_t*)&msg2);
-        if(!gps_configured) return false;
-    }
+    /* Wait for reset */
+    chThdSleepMilliseconds(500);
+
+    /* Re-disable NMEA Output */
+    gps_configured &= gps_tx_ack((uint8_t*)&prt);
+    if(!gps_configured) return false;
+
+    /* Speed up the Link - NAV-PVT Alone Takes ~100ms at 9600 */
+    gps_negotiate_baud();
+
+    /* Set to Stationary mode */
+    gps_nav5_setup(&nav5);
+    gps_configured &= gps_tx_ack((uint8_t*)&nav5);
+    if(!gps_configured) return false;
+
+    /* Set solution rate to 1Hz */
+    gps_rate_setup(&rate);
+    gps_configured &= gps_tx_ack((uint8_t*)&rate);
+    if(!gps_configured) return false;
+
+    /* Disable sbas */
+    gps_sbas_setup(&sbas);
+    gps_configured &= gps_tx_ack((uint8_t*)&sbas);
+    if(!gps_configured) return false;
+
+    /* Timepulses with the Cable Delay */
+    gps_configured &= gps_timepulses();
+    if(!gps_configured) return false;
+
+    /* Periodic Messages */
+    gps_configured &= gps_messages(false);
 
     return gps_configured;
 }
 
-/* Configure uBlox GPS */
-void gps_init(SerialDriver* seriald, bool nav_pvt, bool nav_posecef,
-                bool rising_edge){
 
-    /* Set global serial driver */
-    gps_seriald = seriald;
-
-    /* Reset uBlox */
+/* Hardware Reset - Only for a uBlox that Stops Answering */
+static void gps_reset(void)
+{
     palClearLine(LINE_GPS_RST);
     chThdSleepMilliseconds(300);
     palSetLine(LINE_GPS_RST);
 
     /* Wait for GPS to restart */
     chThdSleepMilliseconds(500);
+}
 
-    /* Start Serial Driver */
-    sdStart(gps_seriald, &serial_cfg);
 
-    while(!gps_configure(nav_pvt, nav_posecef, rising_edge)){
-        
-        chThdSleepMilliseconds(1000);
+/* Bring the uBlox Up - After an MCU Only Reset it Still Holds its Settings,
+ * so Nothing Needs Sending and the Timepulses Run On. From Power On it
+ * Needs the Full Sequence.
+ */
+static void gps_start(void)
+{
+    /* Both Paths Send the Delay & Shape as they Stand */
+    tp_pending = false;
+
+    while(true) {
+        if(gps_find_baud()) {
+            if(gps_config_held())
+                return;
+            if(gps_configure() && gps_save())
+                return;
+        }
+        gps_reset();
     }
-    
-    return;
 }
 
 
-/* Thread to Run State Machine */
+/* Thread to Configure the uBlox then Run the Parser */
 static THD_WORKING_AREA(gps_thd_wa, 2048);
 static THD_FUNCTION(gps_thd, arg) {
 
     (void)arg;
     chRegSetThreadName("GPS");
-    
-    /* Clear Buffer */
-    while(sdGetTimeout(gps_seriald, TIME_IMMEDIATE) != Q_TIMEOUT);
-
-    /* Run State Machine */
-    while(true){    
-        if(gps_configured){            
-            ublox_state_machine(sdGet(gps_seriald));
+
+    /* Start Serial Link */
+    gps_link_start(GPS_DEFAULT_BAUD);
+    gps_start();
+
+    /* Parse Every Complete Frame Each Time the Link Goes Idle -
+     * NAV-PVT Comes Once a Second, so a New Delay Goes Out Within One
+     */
+    while(true){
+        gps_link_wait(TIME_INFINITE);
+        while(ublox_next_frame() != UBLOX_WAIT);
+
+        /* Saved Too, so a Recovery Reset Keeps the New Delay & Shape */
+        if(tp_pending) {
+            tp_pending = false;
+            if(!gps_timepulses() || !gps_save())
+                tp_pending = true;
         }
     }
 }
 
 
-/* Init GPS Thread */
-void gps_thd_init(void) {
+/* Move Both Timepulses Earlier by ns - Sent by the GPS Thread */
+void gps_cable_delay(int16_t ns) {
+
+    if(ns == tp_cable_delay)
+        return;
+    tp_cable_delay = ns;
+    tp_pending = true;
+}
+
+
+/* Set the SAFEBOOT Pulse Width (us) & Invert its Edges - Sent by the GPS Thread */
+void gps_pps_shape(uint32_t width_us, bool inverted) {
+
+    if(width_us == tp_width_us && inverted == tp_inverted)
+        return;
+    tp_width_us = width_us;
+    tp_inverted = inverted;
+    tp_pending = true;
+}
+
+
+/* Configure uBlox GPS from its Own Thread - Returns at Once */
+void gps_init(bool nav_pvt, bool nav_posecef, bool tim_tp, bool signal, bool rising_edge){
+
+    gps_msgs.nav_pvt = nav_pvt;
+    gps_msgs.nav_posecef = nav_posecef;
+    gps_msgs.tim_tp = tim_tp;
+    gps_msgs.signal = signal;
+    tp_rising_edge = rising_edge;
+
+    /* Power On Resets Both, Anything Else Only the MCU */
+    gps_cold = (RCC->CSR & (RCC_CSR_PORRSTF | RCC_CSR_BORRSTF)) != 0;
+    RCC->CSR |= RCC_CSR_RMVF;
 
     chThdCreateStatic(gps_thd_wa, sizeof(gps_thd_wa), NORMALPRIO, gps_thd, NULL);
 }
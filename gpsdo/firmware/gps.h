@@ -41,17 +41,59 @@ typedef struct __attribute__((packed)) {
 } ublox_pvt_t;
 
 
+/* TIM-TP Payload Data - Timing of the Next Pulse */
+typedef struct __attribute__((packed)) {
+    uint32_t tow_ms;
+    uint32_t tow_sub_ms;
+    int32_t q_err;
+    uint16_t week;
+    uint8_t flags;
+    uint8_t ref_info;
+} ublox_tim_tp_t;
+
+
+/* NAV-SAT Block - One per Satellite */
+typedef struct __attribute__((packed)) {
+    uint8_t gnss_id;
+    uint8_t sv_id;
+    uint8_t cno;
+    int8_t elev;
+    int16_t azim;
+    int16_t pr_res;
+    uint32_t flags;
+} ublox_nav_sat_block_t;
+
+
+/* MON-HW Payload Data */
+typedef struct __attribute__((packed)) {
+    uint32_t pin_sel, pin_bank, pin_dir, pin_val;
+    uint16_t noise_per_ms;
+    uint16_t agc_cnt;
+    uint8_t a_status;
+    uint8_t a_power;
+    uint8_t flags;
+    uint8_t reserved1;
+    uint32_t used_mask;
+    uint8_t vp[17];
+    uint8_t jam_ind;
+    uint8_t reserved2[2];
+    uint32_t pin_irq, pull_h, pull_l;
+} ublox_mon_hw_t;
+
+
 /* Global Position Packet */
 extern position_packet pos_pkt;
 
 /* Position Packet Mutex */
 extern mutex_t pos_pkt_mutex;
 
-/* Configure uBlox GPS */
-void gps_init(SerialDriver* seriald, bool nav_pvt, bool nav_posecef,
-                bool rising_edge);
+/* Start the GPS Thread - Configures the uBlox Unless it Still Holds its Settings, then Parses */
+void gps_init(bool nav_pvt, bool nav_posecef, bool tim_tp, bool signal, bool rising_edge);
+
+/* Set the Antenna Cable Delay (ns) - Before gps_init, or Applied by the GPS Thread */
+void gps_cable_delay(int16_t ns);
 
-/* Init GPS Thread */
-void gps_thd_init(void);
+/* Set the PPS Timepulse Width (us) & Polarity - Before gps_init, or Applied by the GPS Thread */
+void gps_pps_shape(uint32_t width_us, bool inverted);
 
 #endif /*__GPS_H__*/
@@ -0,0 +1,246 @@
+#include <string.h>
+#include "gps_link.h"
+
+/* DMA Streams - the Disabled UART Driver's USART1 Settings in mcuconf.h */
+#define GPS_LINK_RX_DMA STM32_DMA_STREAM(STM32_UART_USART1_RX_DMA_STREAM)
+#define GPS_LINK_TX_DMA STM32_DMA_STREAM(STM32_UART_USART1_TX_DMA_STREAM)
+#define GPS_LINK_RX_CHN STM32_DMA_GETCHANNEL(STM32_UART_USART1_RX_DMA_STREAM, STM32_USART1_RX_DMA_CHN)
+#define GPS_LINK_TX_CHN STM32_DMA_GETCHANNEL(STM32_UART_USART1_TX_DMA_STREAM, STM32_USART1_TX_DMA_CHN)
+#define GPS_LINK_RX_MASK (GPS_LINK_RX_SIZE - 1)
+
+/* Function Prototypes */
+static void gps_link_rx_dma_isr(void *p, uint32_t flags);
+static void gps_link_tx_dma_isr(void *p, uint32_t flags);
+static uint32_t gps_link_written(void);
+
+/* DMA Buffers - Must Not be in CCM */
+static uint8_t rx_ring[GPS_LINK_RX_SIZE];
+static uint8_t tx_buf[GPS_LINK_TX_SIZE];
+
+/* Ring Positions - Absolute Byte Counts */
+static volatile uint32_t rx_halves;                     // Half rings completed by the DMA
+static uint32_t rx_consumed;
+static uint32_t rx_overruns;
+static uint32_t link_baud;
+
+/* Reader & Writer Wakeups */
+static binary_semaphore_t rx_sem;
+static binary_semaphore_t tx_sem;
+
+
+/* Half or Full Ring - Wake the Reader Before the DMA Laps it */
+static void gps_link_rx_dma_isr(void *p, uint32_t flags)
+{
+    (void)p;
+
+    if(flags & (STM32_DMA_ISR_HTIF | STM32_DMA_ISR_TCIF)) {
+        rx_halves++;
+        chSysLockFromISR();
+        chBSemSignalI(&rx_sem);
+        chSysUnlockFromISR();
+    }
+}
+
+
+/* Transmission Complete */
+static void gps_link_tx_dma_isr(void *p, uint32_t flags)
+{
+    (void)p;
+    (void)flags;
+
+    dmaStreamDisable(GPS_LINK_TX_DMA);
+    chSysLockFromISR();
+    chBSemSignalI(&tx_sem);
+    chSysUnlockFromISR();
+}
+
+
+/* Idle Line - End of a Burst of Messages */
+OSAL_IRQ_HANDLER(STM32_USART1_HANDLER)
+{
+    uint16_t sr;
+
+    OSAL_IRQ_PROLOGUE();
+
+    /* SR then DR Read Clears IDLE & Errors */
+    sr = USART1->SR;
+    (void)USART1->DR;
+
+    if(sr & USART_SR_IDLE) {
+        chSysLockFromISR();
+        chBSemSignalI(&rx_sem);
+        chSysUnlockFromISR();
+    }
+
+    OSAL_IRQ_EPILOGUE();
+}
+
+
+/* Bytes Written by the DMA Since Start - Exact While the Reader is Less than a Ring Behind */
+static uint32_t gps_link_written(void)
+{
+    uint32_t halves, pos;
+
+    chSysLock();
+    halves = rx_halves * (GPS_LINK_RX_SIZE / 2);
+    pos = GPS_LINK_RX_SIZE - dmaStreamGetTransactionSize(GPS_LINK_RX_DMA);
+    chSysUnlock();
+
+    return halves + ((pos - halves) & GPS_LINK_RX_MASK);
+}
+
+
+void gps_link_start(uint32_t baud)
+{
+    chBSemObjectInit(&rx_sem, true);
+    chBSemObjectInit(&tx_sem, true);
+    rx_halves = 0;
+    rx_consumed = 0;
+    rx_overruns = 0;
+
+    rccEnableUSART1(FALSE);
+
+    /* Circular Receive */
+    dmaStreamAllocate(GPS_LINK_RX_DMA, STM32_UART_USART1_IRQ_PRIORITY,
+                      gps_link_rx_dma_isr, NULL);
+    dmaStreamSetPeripheral(GPS_LINK_RX_DMA, &USART1->DR);
+    dmaStreamSetMemory0(GPS_LINK_RX_DMA, rx_ring);
+    dmaStreamSetTransactionSize(GPS_LINK_RX_DMA, GPS_LINK_RX_SIZE);
+    dmaStreamSetMode(GPS_LINK_RX_DMA,
+                     STM32_DMA_CR_CHSEL(GPS_LINK_RX_CHN)                   |
+                     STM32_DMA_CR_PL(STM32_UART_USART1_DMA_PRIORITY)       |
+                     STM32_DMA_CR_DIR_P2M | STM32_DMA_CR_MINC              |
+                     STM32_DMA_CR_CIRC | STM32_DMA_CR_HTIE | STM32_DMA_CR_TCIE);
+
+    /* One Shot Transmit */
+    dmaStreamAllocate(GPS_LINK_TX_DMA, STM32_UART_USART1_IRQ_PRIORITY,
+                      gps_link_tx_dma_isr, NULL);
+    dmaStreamSetPeripheral(GPS_LINK_TX_DMA, &USART1->DR);
+
+    /* 8N1, DMA Both Ways, Interrupt on Idle Line */
+    link_baud = baud;
+    USART1->BRR = (STM32_PCLK2 + baud / 2) / baud;
+    USART1->CR2 = 0;
+    USART1->CR3 = USART_CR3_DMAR | USART_CR3_DMAT;
+    USART1->CR1 = USART_CR1_UE | USART_CR1_TE | USART_CR1_RE | USART_CR1_IDLEIE;
+
+    dmaStreamEnable(GPS_LINK_RX_DMA);
+    nvicEnableVector(STM32_USART1_NUMBER, STM32_UART_USART1_IRQ_PRIORITY);
+}
+
+
+void gps_link_set_baud(uint32_t baud)
+{
+    systime_t start = chVTGetSystemTime();
+
+    /* Let the Last Byte Out - At Most a Character Time After the DMA Finishes */
+    while(!(USART1->SR & USART_SR_TC) && chVTTimeElapsedSinceX(start) < MS2ST(10))
+        chThdSleepMilliseconds(1);
+
+    USART1->CR1 &= ~USART_CR1_UE;
+    USART1->BRR = (STM32_PCLK2 + baud / 2) / baud;
+    USART1->CR1 |= USART_CR1_UE;
+    link_baud = baud;
+
+    /* Anything Received Around the Switch is Garbage */
+    gps_link_flush();
+}
+
+
+uint32_t gps_link_baud(void)
+{
+    return link_baud;
+}
+
+
+bool gps_link_write(const uint8_t *buf, size_t n, systime_t timeout)
+{
+    if(n > GPS_LINK_TX_SIZE)
+        return false;
+
+    memcpy(tx_buf, buf, n);
+    chBSemReset(&tx_sem, true);
+
+    dmaStreamSetMemory0(GPS_LINK_TX_DMA, tx_buf);
+    dmaStreamSetTransactionSize(GPS_LINK_TX_DMA, n);
+    dmaStreamSetMode(GPS_LINK_TX_DMA,
+                     STM32_DMA_CR_CHSEL(GPS_LINK_TX_CHN)                   |
+                     STM32_DMA_CR_PL(STM32_UART_USART1_DMA_PRIORITY)       |
+                     STM32_DMA_CR_DIR_M2P | STM32_DMA_CR_MINC | STM32_DMA_CR_TCIE);
+
+    /* TC Still Set from the Last Frame would Let gps_link_set_baud Cut this One Short -
+     * rc_w0, so Writing the Other Bits as 1 Leaves Them Alone
+     */
+    USART1->SR = ~USART_SR_TC;
+    dmaStreamEnable(GPS_LINK_TX_DMA);
+
+    if(chBSemWaitTimeout(&tx_sem, timeout) != MSG_OK) {
+        dmaStreamDisable(GPS_LINK_TX_DMA);
+        return false;
+    }
+    return true;
+}
+
+
+bool gps_link_wait(systime_t timeout)
+{
+    return chBSemWaitTimeout(&rx_sem, timeout) == MSG_OK;
+}
+
+
+size_t gps_link_available(void)
+{
+    uint32_t written = gps_link_written();
+
+    /* Fell a Whole Ring Behind - Data Lost, Restart from the Newest Byte */
+    if(written - rx_consumed > GPS_LINK_RX_SIZE - 1) {
+        rx_overruns++;
+        rx_consumed = written;
+    }
+    return written - rx_consumed;
+}
+
+
+size_t gps_link_span(const uint8_t **data)
+{
+    size_t n = gps_link_available();
+    size_t tail = rx_consumed & GPS_LINK_RX_MASK;
+
+    *data = &rx_ring[tail];
+    if(tail + n > GPS_LINK_RX_SIZE)
+        n = GPS_LINK_RX_SIZE - tail;
+    return n;
+}
+
+
+void gps_link_copy(uint8_t *dst, size_t n)
+{
+    size_t tail = rx_consumed & GPS_LINK_RX_MASK;
+    size_t first = GPS_LINK_RX_SIZE - tail;
+
+    if(n <= first) {
+        memcpy(dst, &rx_ring[tail], n);
+    } else {
+        memcpy(dst, &rx_ring[tail], first);
+        memcpy(dst + first, rx_ring, n - first);
+    }
+}
+
+
+void gps_link_consume(size_t n)
+{
+    rx_consumed += n;
+}
+
+
+void gps_link_flush(void)
+{
+    chBSemReset(&rx_sem, true);
+    rx_consumed = gps_link_written();
+}
+
+
+uint32_t gps_link_overruns(void)
+{
+    return rx_overruns;
+}
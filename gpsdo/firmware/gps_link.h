@@ -0,0 +1,54 @@
+#ifndef GPS_LINK_H
+#define GPS_LINK_H
+
+#include "ch.h"
+#include "hal.h"
+
+/* Receive Ring Size - Power of 2, Must Hold Several Messages */
+#define GPS_LINK_RX_SIZE 1024
+
+/* Largest Single Transmission */
+#define GPS_LINK_TX_SIZE 128
+
+
+/* USART1 <-> uBlox Link
+ * Receive runs as circular DMA into a ring in SRAM. The reader thread is
+ * woken by the idle line after each burst of messages, or when half the
+ * ring has filled, rather than once per byte. Transmit goes through DMA
+ * from a static SRAM buffer, as the main stack lives in CCM.
+ */
+
+/* Start USART1 & DMA */
+void gps_link_start(uint32_t baud);
+
+/* Change baud once the last byte has left the shift register */
+void gps_link_set_baud(uint32_t baud);
+
+/* Current baud */
+uint32_t gps_link_baud(void);
+
+/* Transmit n bytes, blocking until sent or timeout */
+bool gps_link_write(const uint8_t *buf, size_t n, systime_t timeout);
+
+/* Wait for data received since the last wait, false on timeout */
+bool gps_link_wait(systime_t timeout);
+
+/* Bytes received and not yet consumed */
+size_t gps_link_available(void);
+
+/* Longest contiguous run of unconsumed bytes, returns its length */
+size_t gps_link_span(const uint8_t **data);
+
+/* Copy n unconsumed bytes without consuming them */
+void gps_link_copy(uint8_t *dst, size_t n);
+
+/* Consume n bytes */
+void gps_link_consume(size_t n);
+
+/* Discard everything received so far */
+void gps_link_flush(void);
+
+/* Number of times the reader fell a whole ring behind */
+uint32_t gps_link_overruns(void);
+
+#endif
@@ -0,0 +1,210 @@
+#include "ch.h"
+#include "hal.h"
+
+#include "holdover.h"
+#include "pll_monitor.h"
+#include "usb_serial_link.h"
+
+/* Seconds of Measurement Before the Period is Believed */
+#define HOLDOVER_MIN_WINDOW     8
+
+/* Function Prototypes */
+static void holdover_enter(uint8_t next);
+static void holdover_report(void);
+static int32_t holdover_clamp(int32_t v, int32_t limit);
+static int64_t holdover_period(void);
+
+/* Set by the GPS Thread */
+static volatile bool fix_ok;
+
+/* Everything Else Runs on the FREQ Thread */
+static uint8_t state = HOLDOVER_STARTUP;
+static uint32_t state_secs;
+static uint32_t good_secs;
+
+static uint32_t count_hz;                               // Nominal second in counts
+static int64_t period_q16;                              // Output second in counts
+static int64_t corr_q16;                                // Phase correction for the next pulse
+static int64_t frac_q16;                                // Fraction of a count carried forward
+static uint32_t last_rise, next_rise;
+static bool realign;                                    // Retuned, step onto the next good PPS
+
+static int32_t phase_err;                               // GPS - output, counts
+static int32_t drift_ppt;                               // Reference against GPS, when last measured
+static uint32_t jitter_ps;
+static uint32_t drift_sigma_ps;                         // Uncertainty of the held period, ps per s
+
+
+static int32_t holdover_clamp(int32_t v, int32_t limit)
+{
+    return v > limit ? limit : v < -limit ? -limit : v;
+}
+
+
+/* Nominal Second Plus the Measured Drift, Q16 */
+static int64_t holdover_period(void)
+{
+    return ((int64_t)count_hz << 16) +
+           (int64_t)drift_ppt * ((int64_t)count_hz * 65536 / 1000000) / 1000000;
+}
+
+
+static void holdover_enter(uint8_t next)
+{
+    /* Keep CLK_OUT Driven Should the CS2100 Slip While the GPS is Away */
+    if(next == HOLDOVER_HOLDOVER || state == HOLDOVER_HOLDOVER)
+        pll_holdover(next == HOLDOVER_HOLDOVER);
+
+    state = next;
+    state_secs = 0;
+}
+
+
+/* Log the Output PPS Quality */
+static void holdover_report(void)
+{
+    holdover_packet pkt;
+
+    pkt.state = state;
+    pkt.state_secs = state_secs;
+    pkt.drift_ppt = drift_ppt;
+    pkt.phase_err_ns = (int64_t)phase_err * 1000000000 / count_hz;
+
+    /* Error in the Held Period Integrates Over the Holdover */
+    if(state == HOLDOVER_HOLDOVER)
+        pkt.est_err_ns = ((uint64_t)state_secs * drift_sigma_ps + jitter_ps) / 1000;
+    else
+        pkt.est_err_ns = jitter_ps / 1000;
+
+    upload_holdover_packet(&pkt);
+}
+
+
+void holdover_init(uint32_t hz)
+{
+    count_hz = hz;
+    period_q16 = holdover_period();
+}
+
+
+void holdover_fix(bool ok)
+{
+    fix_ok = ok;
+}
+
+
+bool holdover_capture(uint32_t capture, const freq_packet *freq, uint32_t *rise)
+{
+    bool good = fix_ok && !freq->flags;
+    good_secs = good ? good_secs + 1 : 0;
+
+    /* Feed the Measured Period Forward - Held Once the GPS is Lost */
+    if(good && freq->window >= HOLDOVER_MIN_WINDOW && state != HOLDOVER_HOLDOVER) {
+        drift_ppt = freq->freq_err_avg_ppt;
+        period_q16 = holdover_period();
+        jitter_ps = freq->jitter_ps;
+
+        /* Mean of n Seconds has Phase Noise at Both Ends */
+        drift_sigma_ps = (uint64_t)jitter_ps * 1414 / 1000 / freq->window;
+    }
+
+    if(state == HOLDOVER_STARTUP) {
+        state_secs++;
+        if(good_secs < HOLDOVER_SETTLE_S) {
+            holdover_report();
+            return false;
+        }
+
+        /* First Output Pulse a Second after this GPS Pulse */
+        last_rise = capture;
+        next_rise = capture + (uint32_t)(period_q16 >> 16);
+        *rise = next_rise;
+        holdover_enter(HOLDOVER_DISCIPLINED);
+        return true;
+    }
+
+    if(!fix_ok && state != HOLDOVER_HOLDOVER) {
+        holdover_enter(HOLDOVER_HOLDOVER);
+        return false;
+    }
+    if(!good || (state == HOLDOVER_HOLDOVER && good_secs < HOLDOVER_SETTLE_S))
+        return false;
+
+    /* Error to Whichever Output Pulse is Nearest */
+    int32_t err_last = (int32_t)(capture - last_rise);
+    int32_t err_next = (int32_t)(capture - next_rise);
+    phase_err = (err_last < 0 ? -err_last : err_last) < (err_next < 0 ? -err_next : err_next) ?
+                err_last : err_next;
+
+    /* Back from Holdover - phase_err is What Holdover Lost */
+    if(state == HOLDOVER_HOLDOVER)
+        holdover_enter(HOLDOVER_RECOVERING);
+
+    /* Retuned - the Output has Already Stepped, so Step Straight Back */
+    if(realign) {
+        realign = false;
+        corr_q16 = (int64_t)phase_err << 16;
+        if(state == HOLDOVER_RECOVERING)
+            holdover_enter(HOLDOVER_DISCIPLINED);
+        return false;
+    }
+
+    if(state == HOLDOVER_RECOVERING) {
+        corr_q16 = (int64_t)holdover_clamp(phase_err, HOLDOVER_SLEW_MAX) << 16;
+        if(phase_err <= HOLDOVER_SLEW_MAX && phase_err >= -HOLDOVER_SLEW_MAX)
+            holdover_enter(HOLDOVER_DISCIPLINED);
+    } else {
+        corr_q16 = ((int64_t)phase_err << 16) >> HOLDOVER_GAIN_SHIFT;
+        if(corr_q16 > (int64_t)HOLDOVER_SLEW_MAX << 16)
+            corr_q16 = (int64_t)HOLDOVER_SLEW_MAX << 16;
+        if(corr_q16 < -((int64_t)HOLDOVER_SLEW_MAX << 16))
+            corr_q16 = -((int64_t)HOLDOVER_SLEW_MAX << 16);
+    }
+    return false;
+}
+
+
+void holdover_no_pps(void)
+{
+    good_secs = 0;
+    if(state == HOLDOVER_DISCIPLINED || state == HOLDOVER_RECOVERING)
+        holdover_enter(HOLDOVER_HOLDOVER);
+    else if(state == HOLDOVER_STARTUP)
+        holdover_report();
+}
+
+
+uint32_t holdover_rise(uint32_t rise)
+{
+    int64_t step_q16 = period_q16 + corr_q16 + frac_q16;
+    int64_t step = step_q16 >> 16;
+
+    frac_q16 = step_q16 - (step << 16);
+    corr_q16 = 0;
+
+    last_rise = rise;
+    next_rise = rise + (uint32_t)step;
+    state_secs++;
+    holdover_report();
+
+    return next_rise;
+}
+
+
+/* The Drift is a Property of the Oscillator, so Holds Across the Retune */
+uint32_t holdover_retune(uint32_t hz, uint32_t now)
+{
+    int32_t left = (int32_t)(next_rise - now);
+
+    /* Whatever was Left of this Second, at the New Rate */
+    if(left > 0)
+        next_rise = now + (uint32_t)((uint64_t)left * hz / count_hz);
+
+    count_hz = hz;
+    period_q16 = holdover_period();
+    corr_q16 = 0;
+    frac_q16 = 0;
+    realign = state != HOLDOVER_STARTUP;
+
+    return next_rise;
+}
@@ -0,0 +1,52 @@
+#ifndef HOLDOVER_H
+#define HOLDOVER_H
+
+#include "ch.h"
+#include "hal.h"
+#include "packets.h"
+
+/* Good Seconds Before Trusting the GPS Again */
+#define HOLDOVER_SETTLE_S       10
+
+/* Largest Output PPS Correction per Second, in Reference Counts */
+#define HOLDOVER_SLEW_MAX       4
+
+/* Phase Servo Gain While Disciplined - Correction is Error / 2^n */
+#define HOLDOVER_GAIN_SHIFT     2
+
+/* Holdover States */
+#define HOLDOVER_STARTUP        0                       // No output PPS yet
+#define HOLDOVER_DISCIPLINED    1                       // Output PPS servoed to GPS
+#define HOLDOVER_HOLDOVER       2                       // Free running on the last period
+#define HOLDOVER_RECOVERING     3                       // Slewing back to GPS
+
+
+/* Output PPS State Machine
+ * The output PPS is scheduled in reference counts by freq_monitor. While
+ * the fix is good each pulse is one measured period after the last, plus
+ * a fraction of the phase error to the GPS PPS. On fix loss the period is
+ * held, and on return the error is slewed out at a bounded rate rather
+ * than stepped.
+ */
+
+/* Start Counting Seconds of hz Reference Counts */
+void holdover_init(uint32_t hz);
+
+/* Fix State from NAV-PVT */
+void holdover_fix(bool fix_ok);
+
+/* A GPS PPS Capture & its Second's Measurement - True to Start the Output at *rise */
+bool holdover_capture(uint32_t capture, const freq_packet *freq, uint32_t *rise);
+
+/* The GPS PPS Went Away */
+void holdover_no_pps(void);
+
+/* An Output Pulse Rose at rise - Returns When the Next Should */
+uint32_t holdover_rise(uint32_t rise);
+
+/* The Reference Now Counts hz a Second from now - Returns When the Next
+ * Output Pulse Should Rise. The Next Good GPS PPS Realigns in One Step.
+ */
+uint32_t holdover_retune(uint32_t hz, uint32_t now);
+
+#endif
@@ -2,37 +2,46 @@
 #include "hal.h"
 
 #include "status.h"
+#include "settings.h"
 #include "cs2100.h"
+#include "pll_monitor.h"
+#include "freq_monitor.h"
 #include "gps.h"
 #include "usb_serial_link.h"
 
 
 int main(void) {
 
+    settings_t set;
+    cs2100_ratio_t ratio;
+
     /* Allow debug access during WFI sleep */
     DBGMCU->CR |= DBGMCU_CR_DBG_SLEEP;
 
     /* Initialise ChibiOS */
     halInit();
     chSysInit();
+
+    /* Load Settings - May Erase Flash, so Before Anything Else Runs */
+    settings_init();
+    settings_get(&set);
+    cs2100_ratio(set.out_freq_hz, &ratio);
     
     /* Enable Active Antenna */
     palClearPad(GPIOB, GPIOB_ANT_EN);
     
-    /* Start USB System */
+    /* Start USB System - Logs Queue Until the Host Connects */
     usb_serial_init();
     
-    /* Wait for USB Connect */
-    chThdSleepMilliseconds(3000);
-    
-    /* Configure GPS to Produce 1MHz Reference */
-    gps_init(&SD1, true, false, true);
+    /* Configure CS2100 to Produce the Output & Watch its Lock */
+    pll_monitor_init(&I2CD1, &ratio);
 
-    /* Configure CS2100 to Produce 10MHz Output */
-    cs2100_configure(&I2CD1);
+    /* Measure the Output Against the PPS */
+    freq_monitor_init(true, &set);
     
-    /* Start GPS State Machine */
-    gps_thd_init();
+    /* Configure GPS to Produce 1MHz Reference - Alongside the Others */
+    gps_cable_delay(set.cable_delay_ns);
+    gps_init(true, false, true, true, true);
     
     /* Start Stsus Thread */
     start_status_thread();
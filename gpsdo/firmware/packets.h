@@ -14,4 +14,92 @@ typedef struct __attribute__((packed)) {
     
 } position_packet;
 
+/* Timing Packet - TIM-TP for the Next Pulse */
+typedef struct __attribute__((packed)) {
+
+    uint32_t tow_ms;
+    uint32_t tow_sub_ms;
+    int32_t q_err;
+    uint16_t week;
+    uint8_t flags;
+    uint8_t ref_info;
+
+} timing_packet;
+
+/* Timing Flags - TIM-TP's Own, Plus Whether P2 is the Output PPS */
+#define TIMING_FLAGS_QERR_INVALID (1<<4)
+#define TIMING_FLAGS_OUTPUT_PPS (1<<7)                  // qErr is the uBlox pulse's, not P2's
+
+/* Signal Packet - NAV-SAT Tally & the Last MON-HW */
+typedef struct __attribute__((packed)) {
+
+    uint8_t num_tracked;
+    uint8_t num_used;
+    uint8_t cno_mean, cno_max;
+    uint16_t noise_per_ms;
+    uint16_t agc_cnt;
+    uint8_t ant_status;
+    uint8_t jam_state;
+    uint8_t jam_ind;
+
+} signal_packet;
+
+/* PLL Packet - CS2100 Lock Transitions */
+#define PLL_SOURCE_POLL     0                           // Lock bit read over I2C
+#define PLL_SOURCE_AUX      1                           // AUX_OUT edge interrupt
+
+typedef struct __attribute__((packed)) {
+
+    bool locked;
+    uint32_t event_time;
+    uint32_t unlocks;
+    uint32_t i2c_errors;
+    uint8_t source;
+
+} pll_packet;
+
+/* Frequency Packet - Reference Counted Between PPS Edges */
+#define FREQ_FLAGS_NO_PPS   (1 << 0)                    // No pulse for 1.5 s
+#define FREQ_FLAGS_BAD_PPS  (1 << 1)                    // Missed, extra or late pulse
+#define FREQ_FLAGS_NO_REF   (1 << 2)                    // Reference not counting
+
+typedef struct __attribute__((packed)) {
+
+    uint32_t ref_counts;
+    int32_t freq_err_ppb;
+    int32_t freq_err_avg_ppt;
+    uint32_t jitter_ps;
+    uint8_t window;
+    uint8_t flags;
+
+} freq_packet;
+
+/* Holdover Packet - Output PPS State & Quality, Once per Output Second */
+typedef struct __attribute__((packed)) {
+
+    uint8_t state;
+    uint32_t state_secs;
+    int32_t drift_ppt;
+    int32_t phase_err_ns;
+    uint32_t est_err_ns;
+
+} holdover_packet;
+
+/* Config Packet - Runtime Settings, on Each Host Command & When They Take Effect */
+#define CONFIG_FLAGS_PENDING    (1 << 0)                // Waiting for the next output PPS
+#define CONFIG_FLAGS_REJECTED   (1 << 1)                // Last command refused, settings unchanged
+#define CONFIG_FLAGS_NOT_SAVED  (1 << 2)                // Lost on reset
+
+typedef struct __attribute__((packed)) {
+
+    uint32_t out_freq_hz;
+    uint32_t pps_width_us;
+    int16_t cable_delay_ns;
+    uint8_t pps_inverted;
+    int32_t ratio_err_ppt;
+    uint8_t command;
+    uint8_t flags;
+
+} config_packet;
+
 #endif
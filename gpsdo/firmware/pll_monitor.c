@@ -0,0 +1,223 @@
+#include "ch.h"
+#include "hal.h"
+
+#include "cs2100.h"
+#include "pll_monitor.h"
+#include "usb_serial_link.h"
+
+/* Consecutive Failed Polls Before Reconfiguring */
+#define PLL_MONITOR_MAX_FAILS 10
+
+/* Lock State - Written by the Edge Interrupt or the Poll */
+static volatile bool pll_lock;
+static volatile systime_t pll_event_time;               // Last transition
+static volatile uint32_t pll_unlocks;
+
+static binary_semaphore_t pll_sem;
+static I2CDriver *pll_i2cd;
+
+/* Holdover Request from the FREQ Thread & What the CS2100 Has */
+static volatile bool holdover_req;
+static bool holdover_set;
+
+/* Ratio the CS2100 Should Have, Written by the FREQ Thread */
+static cs2100_ratio_t pll_ratio;
+static volatile bool retune_req;
+static binary_semaphore_t retune_sem;
+static binary_semaphore_t retune_done;
+
+
+#if PLL_MONITOR_USE_AUX
+/* AUX_OUT is High While Unlocked */
+static void pll_lock_edge(EXTDriver *extp, expchannel_t channel)
+{
+    (void)extp;
+    (void)channel;
+
+    bool locked = palReadLine(LINE_PLL_LOCK) == PAL_LOW;
+
+    chSysLockFromISR();
+    if(locked != pll_lock) {
+        pll_lock = locked;
+        pll_event_time = chVTGetSystemTimeX();
+        if(!locked)
+            pll_unlocks++;
+        chBSemSignalI(&pll_sem);
+    }
+    chSysUnlockFromISR();
+}
+
+static const EXTConfig ext_cfg = {
+    {
+        [10] = {EXT_CH_MODE_BOTH_EDGES | EXT_CH_MODE_AUTOSTART | EXT_MODE_GPIOB, pll_lock_edge},
+    }
+};
+#endif
+
+
+/* Record a Polled Transition */
+static void pll_update(bool locked)
+{
+    chSysLock();
+    if(locked != pll_lock) {
+        pll_lock = locked;
+        pll_event_time = chVTGetSystemTimeX();
+        if(!locked)
+            pll_unlocks++;
+        chBSemSignalI(&pll_sem);
+    }
+    chSysUnlock();
+}
+
+
+/* Configure Until the CS2100 Answers - Takes Any Pending Ratio */
+static void pll_configure(void)
+{
+    cs2100_ratio_t ratio;
+
+    do {
+        chSysLock();
+        ratio = pll_ratio;
+        retune_req = false;
+        chSysUnlock();
+        if(cs2100_configure(pll_i2cd, PLL_MONITOR_USE_AUX, &ratio))
+            break;
+        chThdSleepMilliseconds(PLL_MONITOR_POLL_MS);
+    } while(true);
+    holdover_set = false;
+}
+
+
+/* Apply a Ratio Change, Retried Next Pass if the Write Fails */
+static void pll_apply_ratio(void)
+{
+    cs2100_ratio_t ratio;
+
+    chSysLock();
+    if(!retune_req) {
+        chSysUnlock();
+        return;
+    }
+    ratio = pll_ratio;
+    retune_req = false;
+    chSysUnlock();
+
+    if(!cs2100_set_ratio(&ratio)) {
+        retune_req = true;
+        return;
+    }
+    chBSemSignal(&retune_done);
+}
+
+
+/* Apply a Holdover Change, Retried Next Pass if the Write Fails */
+static void pll_apply_holdover(void)
+{
+    bool req = holdover_req;
+    if(req != holdover_set && cs2100_output_unlocked(req))
+        holdover_set = req;
+}
+
+
+/* Upload the State on Every Change */
+static void pll_report(void)
+{
+    pll_packet pkt;
+
+    chSysLock();
+    pkt.locked = pll_lock;
+    pkt.event_time = pll_event_time;
+    pkt.unlocks = pll_unlocks;
+    chSysUnlock();
+    pkt.i2c_errors = cs2100_i2c_errors();
+    pkt.source = PLL_MONITOR_USE_AUX ? PLL_SOURCE_AUX : PLL_SOURCE_POLL;
+
+    upload_pll_packet(&pkt);
+}
+
+
+/* PLL Thread - Owns the I2C Bus */
+static THD_WORKING_AREA(pll_thd_wa, 512);
+static THD_FUNCTION(pll_thd, arg) {
+
+    (void)arg;
+    chRegSetThreadName("PLL");
+
+    pll_configure();
+
+#if PLL_MONITOR_USE_AUX
+    /* Catch Up with Any Edge Before the Interrupt was Enabled */
+    extStart(&EXTD1, &ext_cfg);
+    pll_update(palReadLine(LINE_PLL_LOCK) == PAL_LOW);
+#endif
+    pll_report();
+
+#if !PLL_MONITOR_USE_AUX
+    uint32_t fails = 0;
+#endif
+    while(true) {
+        pll_apply_ratio();
+        pll_apply_holdover();
+#if PLL_MONITOR_USE_AUX
+        if(chBSemWaitTimeout(&pll_sem, MS2ST(PLL_MONITOR_POLL_MS)) == MSG_OK)
+            pll_report();
+#else
+        bool locked;
+        if(cs2100_pll_status(&locked)) {
+            fails = 0;
+            pll_update(locked);
+        } else if(++fails >= PLL_MONITOR_MAX_FAILS) {
+            fails = 0;
+            pll_update(false);
+            pll_configure();
+        }
+
+        if(chBSemWaitTimeout(&pll_sem, TIME_IMMEDIATE) == MSG_OK)
+            pll_report();
+        chBSemWaitTimeout(&retune_sem, MS2ST(PLL_MONITOR_POLL_MS));
+#endif
+    }
+}
+
+
+void pll_monitor_init(I2CDriver *i2cd, const cs2100_ratio_t *ratio)
+{
+    pll_i2cd = i2cd;
+    pll_ratio = *ratio;
+    retune_req = false;
+    chBSemObjectInit(&retune_sem, true);
+    chBSemObjectInit(&retune_done, true);
+    pll_lock = false;
+    pll_event_time = chVTGetSystemTime();
+    pll_unlocks = 0;
+    chBSemObjectInit(&pll_sem, true);
+
+    chThdCreateStatic(pll_thd_wa, sizeof(pll_thd_wa), NORMALPRIO, pll_thd, NULL);
+}
+
+
+bool pll_locked(void)
+{
+    return pll_lock;
+}
+
+
+void pll_holdover(bool holdover)
+{
+    holdover_req = holdover;
+}
+
+
+/* The Lock Indicator Wakes the Thread Only on an Edge, so Also Signal pll_sem */
+bool pll_retune(const cs2100_ratio_t *ratio)
+{
+    chSysLock();
+    pll_ratio = *ratio;
+    retune_req = true;
+    chBSemResetI(&retune_done, true);
+    chBSemSignalI(PLL_MONITOR_USE_AUX ? &pll_sem : &retune_sem);
+    chSchRescheduleS();
+    chSysUnlock();
+
+    return chBSemWaitTimeout(&retune_done, MS2ST(PLL_MONITOR_RETUNE_MS)) == MSG_OK;
+}
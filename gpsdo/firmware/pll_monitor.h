@@ -0,0 +1,35 @@
+#ifndef PLL_MONITOR_H
+#define PLL_MONITOR_H
+
+#include "ch.h"
+#include "hal.h"
+#include "cs2100.h"
+
+/* Lock Indicator on AUX_OUT - Needs a Wire from P4 to PB10, and P4 no
+ * Longer Carries the Clock. Without it the Lock Bit is Polled over I2C.
+ */
+#if !defined(PLL_MONITOR_USE_AUX)
+#define PLL_MONITOR_USE_AUX FALSE
+#endif
+
+/* I2C Poll Interval Without the Lock Indicator */
+#define PLL_MONITOR_POLL_MS 100
+
+/* Longest a Retune Waits for the Write */
+#define PLL_MONITOR_RETUNE_MS 250
+
+/* Configure the CS2100 at ratio & Start Watching its Lock */
+void pll_monitor_init(I2CDriver *i2cd, const cs2100_ratio_t *ratio);
+
+/* Last Known Lock State - Does Not Touch the Bus */
+bool pll_locked(void);
+
+/* Keep CLK_OUT Driven Through Unlock While in Holdover - Applied by the PLL Thread */
+void pll_holdover(bool holdover);
+
+/* Move CLK_OUT to ratio - Waits for the PLL Thread to Write it, or Leaves it
+ * Retrying. False if not Written Yet.
+ */
+bool pll_retune(const cs2100_ratio_t *ratio);
+
+#endif
@@ -0,0 +1,274 @@
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+
+#include "settings.h"
+#include "cs2100.h"
+#include "freq_monitor.h"
+#include "usb_serial_link.h"
+
+/* Flash Unlock Sequence */
+#define FLASH_KEY1          0x45670123
+#define FLASH_KEY2          0xCDEF89AB
+#define FLASH_SR_ERRORS     (FLASH_SR_SOP | FLASH_SR_WRPERR | FLASH_SR_PGAERR | \
+                             FLASH_SR_PGPERR | FLASH_SR_PGSERR)
+
+#define SETTINGS_MAGIC      0x31534447                  // "GDS1"
+#define SETTINGS_ERASED     0xFFFFFFFF
+
+/* One Log Entry, Programmed a Word at a Time */
+typedef struct {
+    uint32_t magic;
+    settings_t set;
+    uint32_t check;
+} settings_record_t;
+
+#define SETTINGS_RECORD_WORDS   (sizeof(settings_record_t) / 4)
+#define SETTINGS_LOG            ((const settings_record_t*)SETTINGS_FLASH_BASE)
+#define SETTINGS_LOG_END        (SETTINGS_LOG + SETTINGS_FLASH_SIZE / sizeof(settings_record_t))
+
+/* Function Prototypes */
+static uint32_t settings_check(const settings_record_t *rec);
+static bool settings_valid(const settings_t *set);
+static bool settings_erased(const settings_record_t *rec);
+static bool settings_flash_wait(void);
+static bool settings_erase(void);
+static bool settings_save(const settings_t *set);
+static void settings_report(uint8_t flags);
+
+/* Written by the USB Thread, Read by the FREQ Thread */
+static settings_t current;
+static bool pending;
+static bool saved;
+static uint8_t last_command;
+
+/* Next Free Log Entry, NULL Once Full */
+static const settings_record_t *next;
+
+
+static uint32_t settings_check(const settings_record_t *rec)
+{
+    uint32_t words[SETTINGS_RECORD_WORDS - 1];
+    uint32_t sum = 0;
+    size_t i;
+
+    memcpy(words, rec, sizeof(words));
+    for(i = 0; i < SETTINGS_RECORD_WORDS - 1; i++)
+        sum += words[i];
+    return ~sum;
+}
+
+
+/* Something the Hardware can Do */
+static bool settings_valid(const settings_t *set)
+{
+    cs2100_ratio_t ratio;
+#if FREQ_MONITOR_USE_TIM8
+    uint64_t width;
+#endif
+
+    if(!cs2100_ratio(set->out_freq_hz, &ratio) ||
+       set->pps_width_us == 0 || set->pps_width_us > SETTINGS_WIDTH_MAX_US)
+        return false;
+
+#if FREQ_MONITOR_USE_TIM8
+    /* TIM8 Must Count a Whole Number of Each Second */
+    if(set->out_freq_hz % FREQ_MONITOR_ETR_DIV)
+        return false;
+
+    /* The Fall is Armed a Whole Counter Wrap After the Rise */
+    width = (uint64_t)set->pps_width_us * (set->out_freq_hz / FREQ_MONITOR_ETR_DIV) / 1000000;
+    if(width < 0x10000)
+        return false;
+#endif
+
+    return set->pps_inverted <= 1;
+}
+
+
+static bool settings_erased(const settings_record_t *rec)
+{
+    const uint32_t *word = (const uint32_t*)rec;
+    size_t i;
+
+    for(i = 0; i < SETTINGS_RECORD_WORDS; i++)
+        if(word[i] != SETTINGS_ERASED)
+            return false;
+    return true;
+}
+
+
+/* Code Runs from Flash, so the CPU Stalls Here Anyway */
+static bool settings_flash_wait(void)
+{
+    uint32_t sr;
+
+    while(FLASH->SR & FLASH_SR_BSY);
+
+    sr = FLASH->SR;
+    FLASH->SR = sr & (FLASH_SR_ERRORS | FLASH_SR_EOP);
+    return !(sr & FLASH_SR_ERRORS);
+}
+
+
+static bool settings_erase(void)
+{
+    bool ok;
+
+    FLASH->KEYR = FLASH_KEY1;
+    FLASH->KEYR = FLASH_KEY2;
+    FLASH->CR = FLASH_CR_PSIZE_1 | FLASH_CR_SER | (SETTINGS_FLASH_SECTOR * FLASH_CR_SNB_0);
+    FLASH->CR |= FLASH_CR_STRT;
+    ok = settings_flash_wait();
+    FLASH->CR = FLASH_CR_LOCK;
+
+    /* The Data Cache May Still Hold the Old Log */
+    FLASH->ACR &= ~FLASH_ACR_DCEN;
+    FLASH->ACR |= FLASH_ACR_DCRST;
+    FLASH->ACR &= ~FLASH_ACR_DCRST;
+    FLASH->ACR |= FLASH_ACR_DCEN;
+
+    next = ok ? SETTINGS_LOG : NULL;
+    return ok;
+}
+
+
+/* Append a Record - Each Word Stalls the Bus for Tens of us */
+static bool settings_save(const settings_t *set)
+{
+    settings_record_t rec;
+    uint32_t words[SETTINGS_RECORD_WORDS];
+    volatile uint32_t *dst;
+    bool ok = true;
+    size_t i;
+
+    if(next == NULL)
+        return false;
+
+    rec.magic = SETTINGS_MAGIC;
+    rec.set = *set;
+    rec.check = settings_check(&rec);
+    memcpy(words, &rec, sizeof(words));
+
+    /* A Failed Entry is Skipped by the Check */
+    dst = (volatile uint32_t*)next;
+    next = next + 1 < SETTINGS_LOG_END ? next + 1 : NULL;
+
+    FLASH->KEYR = FLASH_KEY1;
+    FLASH->KEYR = FLASH_KEY2;
+    FLASH->CR = FLASH_CR_PSIZE_1 | FLASH_CR_PG;
+    for(i = 0; i < SETTINGS_RECORD_WORDS && ok; i++) {
+        dst[i] = words[i];
+        ok = settings_flash_wait();
+    }
+    FLASH->CR = FLASH_CR_LOCK;
+
+    return ok;
+}
+
+
+/* Log the Settings & How the Last Command Went */
+static void settings_report(uint8_t flags)
+{
+    config_packet pkt;
+    cs2100_ratio_t ratio;
+
+    chSysLock();
+    pkt.out_freq_hz = current.out_freq_hz;
+    pkt.pps_width_us = current.pps_width_us;
+    pkt.cable_delay_ns = current.cable_delay_ns;
+    pkt.pps_inverted = current.pps_inverted;
+    pkt.command = last_command;
+    pkt.flags = flags | (pending ? CONFIG_FLAGS_PENDING : 0) | (saved ? 0 : CONFIG_FLAGS_NOT_SAVED);
+    chSysUnlock();
+
+    cs2100_ratio(pkt.out_freq_hz, &ratio);
+    pkt.ratio_err_ppt = cs2100_ratio_error_ppt(pkt.out_freq_hz, &ratio);
+
+    upload_config_packet(&pkt);
+}
+
+
+void settings_init(void)
+{
+    const settings_record_t *rec;
+    const settings_record_t *last = NULL;
+
+    /* Newest Good Entry - the Log Ends at the First Erased Word */
+    for(rec = SETTINGS_LOG; rec < SETTINGS_LOG_END && rec->magic != SETTINGS_ERASED; rec++)
+        if(rec->magic == SETTINGS_MAGIC && rec->check == settings_check(rec) &&
+           settings_valid(&rec->set))
+            last = rec;
+
+    if(last != NULL) {
+        current = last->set;
+        saved = true;
+    } else {
+        current.out_freq_hz = SETTINGS_DEFAULT_FREQ_HZ;
+        current.pps_width_us = SETTINGS_DEFAULT_WIDTH_US;
+        current.cable_delay_ns = 0;
+        current.pps_inverted = 0;
+        current.reserved = 0;
+        saved = false;
+    }
+    pending = false;
+    last_command = 0;
+
+    next = rec < SETTINGS_LOG_END && settings_erased(rec) ? rec : NULL;
+    if(next != NULL && (uint32_t)(next - SETTINGS_LOG) < (uint32_t)(SETTINGS_LOG_END - SETTINGS_LOG) / 2)
+        return;
+
+    /* Compact - Nothing is Counting off the Bus Yet */
+    if(settings_erase() && saved)
+        saved = settings_save(&current);
+}
+
+
+void settings_get(settings_t *set)
+{
+    chSysLock();
+    *set = current;
+    chSysUnlock();
+}
+
+
+void settings_command(uint8_t command, const uint8_t *payload, size_t length)
+{
+    settings_t set;
+    uint8_t flags = 0;
+
+    if(command == SETTINGS_SET) {
+        if(length != sizeof(set))
+            return;
+        memcpy(&set, payload, sizeof(set));
+        set.reserved = 0;
+
+        if(settings_valid(&set)) {
+            bool ok = settings_save(&set);
+            chSysLock();
+            current = set;
+            pending = true;
+            saved = ok;
+            chSysUnlock();
+            freq_monitor_configure(&set);
+        } else {
+            /* Refused - Report What Stands */
+            flags = CONFIG_FLAGS_REJECTED;
+        }
+    } else if(command != SETTINGS_GET) {
+        return;
+    }
+
+    last_command = command;
+    settings_report(flags);
+}
+
+
+void settings_applied(void)
+{
+    chSysLock();
+    pending = false;
+    chSysUnlock();
+    settings_report(0);
+}
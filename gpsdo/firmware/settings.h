@@ -0,0 +1,51 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include "ch.h"
+#include "hal.h"
+
+/* Flash Sector 11 - Left out of the Image by STM32F405xG.ld */
+#define SETTINGS_FLASH_BASE     0x080E0000
+#define SETTINGS_FLASH_SIZE     0x20000
+#define SETTINGS_FLASH_SECTOR   11
+
+/* Used Without a Saved Record */
+#define SETTINGS_DEFAULT_FREQ_HZ    40000000
+#define SETTINGS_DEFAULT_WIDTH_US   100000
+
+/* Output PPS Width - the Fall Needs a Whole Counter Wrap to be Armed */
+#define SETTINGS_WIDTH_MAX_US   900000
+
+/* Host Commands */
+#define SETTINGS_GET            0x01                    // Report the settings
+#define SETTINGS_SET            0x02                    // Payload is a settings_t
+
+
+/* Runtime Settings
+ * Each change is appended to a log in sector 11, so saving never erases.
+ * Erasing stalls the flash for seconds, so the log is compacted only at
+ * boot, once over half full, before anything is timing off the bus.
+ */
+typedef struct __attribute__((packed)) {
+
+    uint32_t out_freq_hz;                               // CS2100 CLK_OUT
+    uint32_t pps_width_us;                              // Output PPS
+    int16_t cable_delay_ns;                             // Antenna cable, both timepulses
+    uint8_t pps_inverted;                               // Output PPS active low
+    uint8_t reserved;
+
+} settings_t;
+
+/* Load the Newest Saved Settings, Compacting the Log if Due */
+void settings_init(void);
+
+/* Settings as Loaded or Last Set */
+void settings_get(settings_t *set);
+
+/* Handle a Host Command, Reporting the Outcome */
+void settings_command(uint8_t command, const uint8_t *payload, size_t length);
+
+/* The Last Set Settings are in Effect */
+void settings_applied(void);
+
+#endif
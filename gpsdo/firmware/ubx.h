@@ -29,12 +29,16 @@
 #define UBX_CFG_PRT     0x00
 #define UBX_CFG_MSG     0x01
 #define UBX_CFG_RATE    0x08
+#define UBX_CFG_CFG     0x09
 #define UBX_CFG_SBAS    0x16
 #define UBX_CFG_NAV5    0x24
 #define UBX_CFG_TP5     0x31
 #define UBX_CFG_GNSS    0x3E
 #define UBX_NAV_POSECEF 0x01
 #define UBX_NAV_PVT     0x07
+#define UBX_NAV_SAT     0x35
+#define UBX_MON_HW      0x09
+#define UBX_TIM_TP      0x01
 #define NMEA_GGA 0x00
 #define NMEA_GLL 0x01
 #define NMEA_GSA 0x02
@@ -44,15 +48,29 @@
 
 
 
+/* UBX-NAV-SAT Layout - Header then One Block per Satellite */
+#define UBX_NAV_SAT_HEAD 8
+#define UBX_NAV_SAT_BLOCK 12
+#define UBX_NAV_SAT_FLAGS_USED (1<<3)
+
+
+/* UBX-NAV-PVT Fix */
+#define UBX_NAV_PVT_FIX_3D 3
+#define UBX_NAV_PVT_FIX_TIME 5
+#define UBX_NAV_PVT_FLAGS_GNSS_FIX_OK (1<<0)
+
+
 /* U-Blox results for state machine output */
 enum ublox_result {
     UBLOX_WAIT,
     UBLOX_RXLEN_TOO_LONG,
     UBLOX_BAD_CHECKSUM,
     UBLOX_ACK, UBLOX_NAK,
-    UBLOX_NAV_PVT, UBLOX_NAV_POSECEF, UBLOX_NAV_TIMELS,
+    UBLOX_NAV_PVT, UBLOX_NAV_POSECEF, UBLOX_NAV_TIMELS, UBLOX_NAV_SAT,
+    UBLOX_MON_HW,
     UBLOX_TIM_TP,
     UBLOX_CFG_NAV5,
+    UBLOX_POLLED,
     UBLOX_UNHANDLED,
     UBLOX_ERROR
 };
@@ -101,6 +119,36 @@ typedef struct __attribute__((packed)) {
 } ubx_cfg_msg_t;
 
 
+/* UBX-CFG-CFG
+ * Clear, save or load the configuration in non-volatile storage.
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t sync1, sync2, class, id;
+    uint16_t length;
+    union {
+        uint8_t payload[13];
+        struct {
+            uint32_t clear_mask;
+            uint32_t save_mask;
+            uint32_t load_mask;
+            uint8_t device_mask;
+        } __attribute__((packed));
+    };
+    uint8_t ck_a, ck_b;
+} ubx_cfg_cfg_t;
+
+/* Sections for cfg-cfg */
+#define UBX_CFG_CFG_IO_PORT     (1<<0)
+#define UBX_CFG_CFG_MSG_CONF    (1<<1)
+#define UBX_CFG_CFG_INF_MSG     (1<<2)
+#define UBX_CFG_CFG_NAV_CONF    (1<<3)
+#define UBX_CFG_CFG_RXM_CONF    (1<<4)
+
+/* Devices for cfg-cfg */
+#define UBX_CFG_CFG_DEV_BBR     (1<<0)
+#define UBX_CFG_CFG_DEV_FLASH   (1<<1)
+
+
 /* UBX-CFG-RATE
  * Change solution rate
  */
@@ -0,0 +1,249 @@
+#include <string.h>
+#include "gps.h"
+#include "packets.h"
+#include "pll_monitor.h"
+#include "holdover.h"
+#include "freq_monitor.h"
+#include "usb_serial_link.h"
+#include "ubx_handlers.h"
+
+
+/*  ACK / NAK - Always Decoded, gps_tx_ack Waits on Them  */
+
+static enum ublox_result ubx_ack_ack(const uint8_t *payload, uint16_t length)
+{
+    (void)payload;
+    (void)length;
+    return UBLOX_ACK;
+}
+
+static enum ublox_result ubx_ack_nak(const uint8_t *payload, uint16_t length)
+{
+    (void)payload;
+    (void)length;
+    return UBLOX_NAK;
+}
+
+static const ubx_handler_t ubx_ack_ack_entry = {UBX_ACK, UBX_ACK_ACK, 2, ubx_ack_ack, NULL};
+static const ubx_handler_t ubx_ack_nak_entry = {UBX_ACK, UBX_ACK_NAK, 2, ubx_ack_nak, NULL};
+
+
+/*  NAV-PVT - Position Packet  */
+
+#if UBX_USE_NAV_PVT
+static enum ublox_result ubx_nav_pvt(const uint8_t *payload, uint16_t length)
+{
+    const ublox_pvt_t *pvt_data = (const ublox_pvt_t*)payload;
+
+    (void)length;
+
+    /* Generate Position Packet */
+    chMtxLock(&pos_pkt_mutex);
+
+    pos_pkt.lon = pvt_data->lon;
+    pos_pkt.lat = pvt_data->lat;
+    pos_pkt.height = pvt_data->height;
+    pos_pkt.num_sat = pvt_data->num_sv;
+    pos_pkt.fix_type = pvt_data->fix_type;
+    pos_pkt.year = pvt_data->year;
+    pos_pkt.month = pvt_data->month;
+    pos_pkt.day = pvt_data->day;
+    pos_pkt.hour = pvt_data->hour;
+    pos_pkt.minute = pvt_data->minute;
+    pos_pkt.second = pvt_data->second;
+    pos_pkt.pll_lock = pll_locked();
+
+    /* Holdover Follows the Fix */
+    holdover_fix((pvt_data->flags & UBX_NAV_PVT_FLAGS_GNSS_FIX_OK) &&
+                 (pvt_data->fix_type == UBX_NAV_PVT_FIX_3D ||
+                  pvt_data->fix_type == UBX_NAV_PVT_FIX_TIME));
+
+    upload_position_packet(&pos_pkt);
+
+    chMtxUnlock(&pos_pkt_mutex);
+
+    return UBLOX_NAV_PVT;
+}
+
+static const ubx_handler_t ubx_nav_pvt_entry = {
+    UBX_NAV, UBX_NAV_PVT, sizeof(ublox_pvt_t), ubx_nav_pvt, NULL
+};
+#endif
+
+
+/*  NAV-POSECEF - Recognised, Not Used Yet  */
+
+#if UBX_USE_NAV_POSECEF
+static enum ublox_result ubx_nav_posecef(const uint8_t *payload, uint16_t length)
+{
+    (void)payload;
+    (void)length;
+    return UBLOX_NAV_POSECEF;
+}
+
+static const ubx_handler_t ubx_nav_posecef_entry = {
+    UBX_NAV, UBX_NAV_POSECEF, sizeof(ublox_posecef_t), ubx_nav_posecef, NULL
+};
+#endif
+
+
+/*  MON-HW - Kept for the Next NAV-SAT  */
+
+/* Latest MON-HW */
+#if UBX_USE_MON_HW || UBX_USE_NAV_SAT
+static signal_packet sig_state;
+#endif
+
+#if UBX_USE_MON_HW
+static enum ublox_result ubx_mon_hw(const uint8_t *payload, uint16_t length)
+{
+    const ublox_mon_hw_t *mon_hw = (const ublox_mon_hw_t*)payload;
+
+    (void)length;
+
+    sig_state.noise_per_ms = mon_hw->noise_per_ms;
+    sig_state.agc_cnt = mon_hw->agc_cnt;
+    sig_state.ant_status = mon_hw->a_status;
+    sig_state.jam_state = (mon_hw->flags >> 2) & 0x03;
+    sig_state.jam_ind = mon_hw->jam_ind;
+
+    return UBLOX_MON_HW;
+}
+
+static const ubx_handler_t ubx_mon_hw_entry = {
+    UBX_MON, UBX_MON_HW, sizeof(ublox_mon_hw_t), ubx_mon_hw, NULL
+};
+#endif
+
+
+/*  NAV-SAT - Satellites Tallied Block by Block, Published with the Last MON-HW  */
+
+#if UBX_USE_NAV_SAT
+
+/* Tally - Staged Until the Checksum */
+static struct {
+    uint8_t num_tracked, num_used, cno_max;
+    uint16_t cno_sum;
+} sat_tally;
+
+static void ubx_nav_sat_begin(void)
+{
+    memset(&sat_tally, 0, sizeof(sat_tally));
+}
+
+static void ubx_nav_sat_block(const uint8_t *block, uint16_t index)
+{
+    const ublox_nav_sat_block_t *sv = (const ublox_nav_sat_block_t*)block;
+
+    (void)index;
+    if(sv->cno == 0)
+        return;
+    sat_tally.num_tracked++;
+    if(sv->cno > sat_tally.cno_max)
+        sat_tally.cno_max = sv->cno;
+    if(sv->flags & UBX_NAV_SAT_FLAGS_USED) {
+        sat_tally.num_used++;
+        sat_tally.cno_sum += sv->cno;
+    }
+}
+
+static enum ublox_result ubx_nav_sat(const uint8_t *payload, uint16_t length)
+{
+    signal_packet sig_pkt;
+
+    (void)payload;
+    if((length - UBX_NAV_SAT_HEAD) % UBX_NAV_SAT_BLOCK != 0)
+        return UBLOX_UNHANDLED;
+
+    sig_pkt = sig_state;
+    sig_pkt.num_tracked = sat_tally.num_tracked;
+    sig_pkt.num_used = sat_tally.num_used;
+    sig_pkt.cno_mean = sat_tally.num_used ? sat_tally.cno_sum / sat_tally.num_used : 0;
+    sig_pkt.cno_max = sat_tally.cno_max;
+
+    upload_signal_packet(&sig_pkt);
+
+    return UBLOX_NAV_SAT;
+}
+
+static const ubx_block_layout_t ubx_nav_sat_layout = {
+    UBX_NAV_SAT_HEAD, UBX_NAV_SAT_BLOCK, ubx_nav_sat_begin, ubx_nav_sat_block
+};
+
+static const ubx_handler_t ubx_nav_sat_entry = {
+    UBX_NAV, UBX_NAV_SAT, UBX_NAV_SAT_HEAD, ubx_nav_sat, &ubx_nav_sat_layout
+};
+#endif
+
+
+/*  TIM-TP - qErr of the Coming Pulse  */
+
+#if UBX_USE_TIM_TP
+static enum ublox_result ubx_tim_tp(const uint8_t *payload, uint16_t length)
+{
+    const ublox_tim_tp_t *tim_tp = (const ublox_tim_tp_t*)payload;
+    timing_packet tim_pkt;
+
+    (void)length;
+
+    tim_pkt.tow_ms = tim_tp->tow_ms;
+    tim_pkt.tow_sub_ms = tim_tp->tow_sub_ms;
+    tim_pkt.q_err = tim_tp->q_err;
+    tim_pkt.week = tim_tp->week;
+    tim_pkt.flags = tim_tp->flags;
+#if FREQ_MONITOR_USE_TIM8
+    /* P2 is Servoed onto the Count Grid, so the uBlox qErr does not Apply */
+    tim_pkt.flags |= TIMING_FLAGS_QERR_INVALID | TIMING_FLAGS_OUTPUT_PPS;
+#endif
+    tim_pkt.ref_info = tim_tp->ref_info;
+
+    upload_timing_packet(&tim_pkt);
+
+    return UBLOX_TIM_TP;
+}
+
+static const ubx_handler_t ubx_tim_tp_entry = {
+    UBX_TIM, UBX_TIM_TP, sizeof(ublox_tim_tp_t), ubx_tim_tp, NULL
+};
+#endif
+
+
+/*  CFG-NAV5 - Poll Response, Recognised Only  */
+
+#if UBX_USE_CFG_NAV5
+static enum ublox_result ubx_cfg_nav5(const uint8_t *payload, uint16_t length)
+{
+    (void)payload;
+    (void)length;
+    return UBLOX_CFG_NAV5;
+}
+
+static const ubx_handler_t ubx_cfg_nav5_entry = {
+    UBX_CFG, UBX_CFG_NAV5, sizeof(((ubx_cfg_nav5_t*)0)->payload), ubx_cfg_nav5, NULL
+};
+#endif
+
+
+/* Registered Handlers by Slot */
+const ubx_handler_t *const ubx_slots[UBX_SLOTS] = {
+    [UBX_SLOT(UBX_ACK, UBX_ACK_ACK)]     = &ubx_ack_ack_entry,
+    [UBX_SLOT(UBX_ACK, UBX_ACK_NAK)]     = &ubx_ack_nak_entry,
+#if UBX_USE_NAV_PVT
+    [UBX_SLOT(UBX_NAV, UBX_NAV_PVT)]     = &ubx_nav_pvt_entry,
+#endif
+#if UBX_USE_NAV_POSECEF
+    [UBX_SLOT(UBX_NAV, UBX_NAV_POSECEF)] = &ubx_nav_posecef_entry,
+#endif
+#if UBX_USE_NAV_SAT
+    [UBX_SLOT(UBX_NAV, UBX_NAV_SAT)]     = &ubx_nav_sat_entry,
+#endif
+#if UBX_USE_TIM_TP
+    [UBX_SLOT(UBX_TIM, UBX_TIM_TP)]      = &ubx_tim_tp_entry,
+#endif
+#if UBX_USE_MON_HW
+    [UBX_SLOT(UBX_MON, UBX_MON_HW)]      = &ubx_mon_hw_entry,
+#endif
+#if UBX_USE_CFG_NAV5
+    [UBX_SLOT(UBX_CFG, UBX_CFG_NAV5)]    = &ubx_cfg_nav5_entry,
+#endif
+};
@@ -0,0 +1,52 @@
+#ifndef UBX_HANDLERS_H
+#define UBX_HANDLERS_H
+
+#include "ch.h"
+#include "hal.h"
+#include "ubx.h"
+#include "ubxconf.h"
+
+/* Payload Bytes Kept for the Handlers - Larger Messages are Taken in Blocks */
+#define UBX_HEAD_SIZE 128
+
+/* Largest Repeated Block */
+#define UBX_BLOCK_SIZE 32
+
+/* Handler Slots - Power of 2 */
+#define UBX_SLOTS 32
+
+/* Slot of a Message - Perfect over the Registered Set, a
+ * Collision Overrides an Initialiser and Fails the Build
+ */
+#define UBX_SLOT(class, id) (((class) + (id)) & (UBX_SLOTS - 1))
+
+
+/* Repeated Blocks of a Payload - Each Handed Over as it Completes */
+typedef struct {
+    uint16_t start;                                 // Payload offset of the first block
+    uint16_t size;                                  // At most UBX_BLOCK_SIZE
+    void (*begin)(void);
+    void (*block)(const uint8_t *block, uint16_t index);
+} ubx_block_layout_t;
+
+/* Decoded Message - payload Holds the First UBX_HEAD_SIZE Bytes */
+typedef struct {
+    uint8_t class, id;
+    uint16_t min_len;                               // Shorter frames are not handed over, <= UBX_HEAD_SIZE
+    enum ublox_result (*handle)(const uint8_t *payload, uint16_t length);
+    const ubx_block_layout_t *layout;               // NULL unless the payload has repeated blocks
+} ubx_handler_t;
+
+/* Registered Handlers by Slot */
+extern const ubx_handler_t *const ubx_slots[UBX_SLOTS];
+
+
+/* Handler for a message, NULL if this build does not decode it */
+static inline const ubx_handler_t *ubx_find_handler(uint8_t class, uint8_t id)
+{
+    const ubx_handler_t *h = ubx_slots[UBX_SLOT(class, id)];
+
+    return (h != NULL && h->class == class && h->id == id) ? h : NULL;
+}
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef UBXCONF_H
+#define UBXCONF_H
+
+/*
+ * Messages decoded by this build. A handler left out costs no flash,
+ * and gps_configure does not ask the uBlox for its message.
+ * ACK/NAK are always decoded.
+ */
+
+#define UBX_USE_NAV_PVT         TRUE
+#define UBX_USE_NAV_POSECEF     FALSE
+#define UBX_USE_NAV_SAT         TRUE
+#define UBX_USE_TIM_TP          TRUE
+#define UBX_USE_MON_HW          TRUE
+#define UBX_USE_CFG_NAV5        FALSE
+
+#endif
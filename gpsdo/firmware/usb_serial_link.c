@@ -5,6 +5,7 @@
 #include "chprintf.h"
 #include <string.h>
 #include "packets.h"
+#include "settings.h"
 #include "usb_serial_link.h"
 
 #define USB_MEMPOOL_ITEMS 64
@@ -12,6 +13,7 @@
 /* Function Prototypes */
 static void mem_init(void);
 static void usb_driver_init(void);
+static bool usb_read_command(uint8_t *header, uint8_t *payload);
 
 /* Memory pool to store incoming data 
  * before being spat out over USB.
@@ -30,6 +32,60 @@ static volatile char usb_mempool_buffer[USB_MEMPOOL_ITEMS * sizeof(packet_log)]
 static volatile msg_t usb_mailbox_buffer[USB_MEMPOOL_ITEMS]
                       __attribute__((section(".ccm")));
                                                 
+
+/* Read the Next Good Command Frame - header is Command & Length */
+static bool usb_read_command(uint8_t *header, uint8_t *payload)
+{
+    msg_t b;
+    uint8_t last = 0;
+    uint8_t ck[2], ck_a = 0, ck_b = 0;
+    uint16_t length, i;
+
+    /* Hunt for the Sync Pair - the Queue Resets on Disconnect */
+    while(true) {
+        if((b = chnGetTimeout(&SDU1, TIME_INFINITE)) < 0) {
+            chThdSleepMilliseconds(COMMAND_TIMEOUT_MS);
+            return false;
+        }
+        if(last == COMMAND_SYNC1 && b == COMMAND_SYNC2)
+            break;
+        last = b;
+    }
+
+    /* The Rest Must Follow Promptly */
+    if(chnReadTimeout(&SDU1, header, 3, MS2ST(COMMAND_TIMEOUT_MS)) != 3)
+        return false;
+    length = header[1] | (header[2] << 8);
+    if(length > COMMAND_MAX_LENGTH)
+        return false;
+    if(chnReadTimeout(&SDU1, payload, length, MS2ST(COMMAND_TIMEOUT_MS)) != length ||
+       chnReadTimeout(&SDU1, ck, 2, MS2ST(COMMAND_TIMEOUT_MS)) != 2)
+        return false;
+
+    for(i = 0; i < 3 + length; i++) {
+        ck_a += i < 3 ? header[i] : payload[i - 3];
+        ck_b += ck_a;
+    }
+    return ck[0] == ck_a && ck[1] == ck_b;
+}
+
+
+/* USB Command Thread */
+static THD_WORKING_AREA(waUSBRxThread, 512);
+static THD_FUNCTION(USBRxThread, arg) {
+
+    (void)arg;
+    chRegSetThreadName("USBRX");
+
+    static uint8_t header[3];
+    static uint8_t payload[COMMAND_MAX_LENGTH];
+
+    while (true) {
+        if (usb_read_command(header, payload))
+            settings_command(header[0], payload, header[1] | (header[2] << 8));
+    }
+}
+
     
 /* USB Serial Thread */
 static THD_WORKING_AREA(waUSBThread, 1024);
@@ -45,11 +101,11 @@ static THD_FUNCTION(USBThread, arg) {
     msg_t mailbox_res;       
     intptr_t data_msg;     
 
-    /* Initalise Memory */
-    mem_init();
-    
     /* Initalise USB Serial */
     usb_driver_init();
+
+    /* Take Commands Once the Driver is Up */
+    chThdCreateStatic(waUSBRxThread, sizeof(waUSBRxThread), NORMALPRIO, USBRxThread, NULL);
     
     
     while (true) {
@@ -96,6 +152,9 @@ static void usb_driver_init(void) {
 /* Start USB Serial Thread */
 void usb_serial_init(void) {    
     
+    /* Initalise Memory - Others Log Before the Thread Runs */
+    mem_init();
+
     chThdCreateStatic(waUSBThread, sizeof(waUSBThread), NORMALPRIO, USBThread, NULL);
 }
 
@@ -133,3 +192,69 @@ void upload_position_packet(position_packet *pos_data) {
     memcpy(pkt.payload, pos_data, sizeof(position_packet));
     _upload_log(&pkt);
 }
+
+/* Log a TIM-TP Message */
+void upload_timing_packet(timing_packet *tim_data) {
+
+    packet_log pkt;
+    pkt.type = MESSAGE_TIMING;
+    pkt.timestamp = chVTGetSystemTime();
+    memset(pkt.payload, 0, 123);
+    memcpy(pkt.payload, tim_data, sizeof(timing_packet));
+    _upload_log(&pkt);
+}
+
+/* Log a NAV-SAT Tally */
+void upload_signal_packet(signal_packet *sig_data) {
+
+    packet_log pkt;
+    pkt.type = MESSAGE_SIGNAL;
+    pkt.timestamp = chVTGetSystemTime();
+    memset(pkt.payload, 0, 123);
+    memcpy(pkt.payload, sig_data, sizeof(signal_packet));
+    _upload_log(&pkt);
+}
+
+/* Log a PLL Lock Transition */
+void upload_pll_packet(pll_packet *pll_data) {
+
+    packet_log pkt;
+    pkt.type = MESSAGE_PLL;
+    pkt.timestamp = chVTGetSystemTime();
+    memset(pkt.payload, 0, 123);
+    memcpy(pkt.payload, pll_data, sizeof(pll_packet));
+    _upload_log(&pkt);
+}
+
+/* Log a Second of Reference Counts */
+void upload_freq_packet(freq_packet *freq_data) {
+
+    packet_log pkt;
+    pkt.type = MESSAGE_FREQ;
+    pkt.timestamp = chVTGetSystemTime();
+    memset(pkt.payload, 0, 123);
+    memcpy(pkt.payload, freq_data, sizeof(freq_packet));
+    _upload_log(&pkt);
+}
+
+/* Log the Output PPS State */
+void upload_holdover_packet(holdover_packet *hold_data) {
+
+    packet_log pkt;
+    pkt.type = MESSAGE_HOLDOVER;
+    pkt.timestamp = chVTGetSystemTime();
+    memset(pkt.payload, 0, 123);
+    memcpy(pkt.payload, hold_data, sizeof(holdover_packet));
+    _upload_log(&pkt);
+}
+
+/* Log the Runtime Settings */
+void upload_config_packet(config_packet *config_data) {
+
+    packet_log pkt;
+    pkt.type = MESSAGE_CONFIG;
+    pkt.timestamp = chVTGetSystemTime();
+    memset(pkt.payload, 0, 123);
+    memcpy(pkt.payload, config_data, sizeof(config_packet));
+    _upload_log(&pkt);
+}
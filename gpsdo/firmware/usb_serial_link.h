@@ -6,6 +6,20 @@
 
 /* Log Message Types */
 #define MESSAGE_POS         0x01
+#define MESSAGE_TIMING      0x02
+#define MESSAGE_SIGNAL      0x03
+#define MESSAGE_PLL         0x04
+#define MESSAGE_FREQ        0x05
+#define MESSAGE_HOLDOVER    0x06
+#define MESSAGE_CONFIG      0x07
+
+/* Host Commands - Sync, Command, Length (LE), Payload, then the
+ * UBX Fletcher-8 over Command to Payload.
+ */
+#define COMMAND_SYNC1       0x47                        // 'G'
+#define COMMAND_SYNC2       0x44                        // 'D'
+#define COMMAND_MAX_LENGTH  64
+#define COMMAND_TIMEOUT_MS  100                         // Within a frame
 
 /* Log Message */
 typedef struct __attribute__((packed)) {
@@ -19,6 +33,12 @@ typedef struct __attribute__((packed)) {
 
 /* Logging Functions */
 void upload_position_packet(position_packet *pos_data);
+void upload_timing_packet(timing_packet *tim_data);
+void upload_signal_packet(signal_packet *sig_data);
+void upload_pll_packet(pll_packet *pll_data);
+void upload_freq_packet(freq_packet *freq_data);
+void upload_holdover_packet(holdover_packet *hold_data);
+void upload_config_packet(config_packet *config_data);
 
 /* Start USB Serial Thread */
 void usb_serial_init(void);
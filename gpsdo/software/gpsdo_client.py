@@ -6,17 +6,43 @@ import serial
 import datetime
 
 # Useage
-if len(sys.argv) != 2:
-    print("Usage: {} /dev/ttyACMx".format(sys.argv[0]))
+if len(sys.argv) != 2 and len(sys.argv) != 6:
+    print("Usage: {} /dev/ttyACMx [freq_hz pps_width_us pps_inverted cable_delay_ns]".format(sys.argv[0]))
     sys.exit(1)
 
 # Message Type Definitions          
 MESSAGE_POSITION = 1
+MESSAGE_TIMING = 2
+MESSAGE_SIGNAL = 3
+MESSAGE_PLL = 4
+MESSAGE_FREQ = 5
+MESSAGE_HOLDOVER = 6
+MESSAGE_CONFIG = 7
+
+# Host Commands
+COMMAND_GET = 1
+COMMAND_SET = 2
+
+# Frame a Command - Sync, Command, Length, Payload & the UBX Checksum
+def command(cmd, payload=b''):
+    body = struct.pack('<BH', cmd, len(payload)) + payload
+    ck_a = ck_b = 0
+    for b in body:
+        ck_a = (ck_a + b) & 0xff
+        ck_b = (ck_b + ck_a) & 0xff
+    return b'GD' + body + bytes([ck_a, ck_b])
   
 # Open Serial Port
 ser = serial.Serial(sys.argv[1])
 print("Listening on", ser.name)
 
+# Change the Settings, or Just Ask for Them
+if len(sys.argv) == 6:
+    settings = struct.pack('<IIhBB', int(sys.argv[2]), int(sys.argv[3]), int(sys.argv[5]), int(sys.argv[4]), 0)
+    ser.write(command(COMMAND_SET, settings))
+else:
+    ser.write(command(COMMAND_GET))
+
 # Fetch & Decode
 while True:
 
@@ -47,4 +73,99 @@ while True:
         else:
             print("PLL Status   Unlocked")
         print("\n\n\n\n\n\n\n\n\n\n\n")
+
+    # Handle Timing Packet - qErr of the Next Pulse
+    elif (log_type == MESSAGE_TIMING):
+        payload = data[5:21]
+        tp = struct.unpack('<IIiHBB', payload)
+        print("TIMEPULSE:")
+        print("Timestamp   ", systick, " s")
+        print("Week / TOW  ", tp[3], "/", tp[0] / 1000.0, "s", "(UTC)" if tp[4] & 1 else "(GNSS)")
+        if (tp[4] & (1 << 7)):
+            print("qErr         Not applicable, PPS output is disciplined")
+        elif (tp[4] & (1 << 4)):
+            print("qErr         Invalid")
+        else:
+            print("qErr        ", tp[2] / 1000.0, "ns")
+        print("\n")
+
+    # Handle Signal Packet - NAV-SAT Tally & MON-HW
+    elif (log_type == MESSAGE_SIGNAL):
+        payload = data[5:16]
+        sig = struct.unpack('<BBBBHHBBB', payload)
+        antenna = ["Init", "Unknown", "OK", "Short", "Open"]
+        jamming = ["Unknown", "OK", "Warning", "Critical"]
+        print("SIGNAL:")
+        print("Timestamp   ", systick, " s")
+        print("Satellites  ", sig[1], "used of", sig[0], "tracked")
+        print("C/N0        ", sig[2], "dBHz mean,", sig[3], "dBHz max")
+        print("Noise / AGC ", sig[4], "/", sig[5])
+        print("Antenna     ", antenna[sig[6]] if sig[6] < len(antenna) else sig[6])
+        print("Jamming     ", jamming[sig[7]] if sig[7] < len(jamming) else sig[7], "( indicator", sig[8], ")")
+        print("\n")
+
+    # Handle PLL Packet - CS2100 Lock Transition
+    elif (log_type == MESSAGE_PLL):
+        payload = data[5:19]
+        pll = struct.unpack('<?IIIB', payload)
+        print("PLL:")
+        print("Timestamp   ", systick, " s")
+        print("PLL Status  ", "Locked" if pll[0] else "Unlocked", "since", pll[1] / 10000.0, "s")
+        print("Unlocks     ", pll[2])
+        print("I2C Errors  ", pll[3])
+        print("Source      ", "AUX_OUT" if pll[4] else "I2C Poll")
+        print("\n")
+
+    # Handle Frequency Packet - Reference Counted Between PPS Edges
+    elif (log_type == MESSAGE_FREQ):
+        payload = data[5:23]
+        freq = struct.unpack('<IiiIBB', payload)
+        print("FREQUENCY:")
+        print("Timestamp   ", systick, " s")
+        if (freq[5] & 1):
+            print("PPS          Missing")
+        elif (freq[5] & 2):
+            print("PPS          Missed or Extra Pulse")
+        elif (freq[5] & 4):
+            print("Reference    Not Counting")
+        else:
+            print("Counts      ", freq[0])
+            print("Error 1 s   ", freq[1], "ppb")
+        if (freq[4] >= 1):
+            print("Error", freq[4], "s ", freq[2] / 1000.0, "ppb")
+        if (freq[4] >= 2):
+            print("PPS Jitter  ", freq[3] / 1000.0, "ns RMS")
+        print("\n")
+
+    # Handle Holdover Packet - Output PPS State & Quality
+    elif (log_type == MESSAGE_HOLDOVER):
+        payload = data[5:22]
+        hold = struct.unpack('<BIiiI', payload)
+        states = ["Startup", "Disciplined", "Holdover", "Recovering"]
+        print("HOLDOVER:")
+        print("Timestamp   ", systick, " s")
+        print("State       ", states[hold[0]] if hold[0] < len(states) else hold[0], "for", hold[1], "s")
+        print("Drift       ", hold[2] / 1000.0, "ppb")
+        print("Phase Error ", hold[3], "ns")
+        print("Est. Error  ", hold[4], "ns")
+        print("\n")
+
+    # Handle Config Packet - Runtime Settings
+    elif (log_type == MESSAGE_CONFIG):
+        payload = data[5:22]
+        cfg = struct.unpack('<IIhBiBB', payload)
+        print("CONFIG:")
+        print("Timestamp   ", systick, " s")
+        print("Output      ", cfg[0] / 1e6, "MHz (ratio error", cfg[4] / 1000.0, "ppb)")
+        print("PPS Width   ", cfg[1] / 1000.0, "ms", "active low" if cfg[3] else "active high")
+        print("Cable Delay ", cfg[2], "ns")
+        if (cfg[6] & 2):
+            print("Status       Rejected")
+        elif (cfg[6] & 1):
+            print("Status       Pending Next PPS")
+        else:
+            print("Status       In Effect")
+        if (cfg[6] & 4):
+            print("Flash        Not Saved")
+        print("\n")
  
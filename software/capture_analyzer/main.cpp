@@ -0,0 +1,242 @@
+#include <map>
+#include <cmath>
+#include <ctime>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "string.h"
+#include "../common/iq_convert.h"
+#include "../common/capture_file.h"
+
+using namespace std;
+
+// g++ main.cpp -std=c++11 -O3 -pthread -o capture-analyzer.out
+
+/* Analyzer Config */
+const int64_t pps_tolerance = 2;                        // Samples Between PPS Flagged Beyond +/- this of Nominal
+
+/* One Capture File - <prefix><unix><suffix>.bin, Stream is Prefix & Suffix */
+class capture_result {
+    public:
+        string name;
+        string stream;                                  // e.g. "" / "1_" / "_ch2" - Device & Channel
+        time_t stamp;
+        bool valid;
+        file_header header;
+        uint64_t num_samples;
+        int64_t pps_offset;                             // PPS sample from the start of the file
+        int64_t pps_delta;                              // Samples since the previous second's PPS, -1 if not consecutive
+        uint64_t clipped;                               // Samples with I or Q at full scale
+        double rms;                                     // dBFS
+        double dc_i, dc_q;                              // Fraction of full scale
+};
+
+/* Integer Accumulators - Plain Loops the Compiler Vectorises */
+static void sample_statistics(const int16_t* s, size_t num_samples, capture_result& r){
+
+    int64_t sum_i = 0, sum_q = 0, power = 0;
+    uint64_t clipped = 0;
+
+    /* Blocks Small Enough for 32-bit Lane Sums */
+    const size_t block = 256;
+    for (size_t b = 0; b < num_samples; b += block){
+        size_t n = min(block, num_samples - b);
+        const int16_t* p = s + b * 2;
+        int32_t bi = 0, bq = 0, clip = 0;
+        int64_t bp = 0;
+        for (size_t k = 0; k < n; k++){
+            int32_t i = p[2 * k], q = p[2 * k + 1];
+            bi += i;
+            bq += q;
+            bp += i * i + q * q;
+            clip += (i >= I12_MAX || i <= I12_MIN || q >= I12_MAX || q <= I12_MIN);
+        }
+        sum_i += bi;
+        sum_q += bq;
+        power += bp;
+        clipped += clip;
+    }
+
+    r.clipped = clipped;
+    if (num_samples == 0){
+        r.rms = -INFINITY;
+        r.dc_i = r.dc_q = 0;
+        return;
+    }
+    double full_scale = -I12_MIN;
+    r.rms = 10 * log10((double)power / num_samples / (full_scale * full_scale) + 1e-30);
+    r.dc_i = sum_i / (double)num_samples / full_scale;
+    r.dc_q = sum_q / (double)num_samples / full_scale;
+}
+
+
+/* Map & Analyse One File */
+static void analyse(const string& dir, capture_result& r){
+
+    r.valid = false;
+    int fd = open((dir + "/" + r.name).c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(file_header)){
+        close(fd);
+        return;
+    }
+
+    /* Populated Up Front - One Fault per File Instead of per Page */
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return;
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+    memcpy(&r.header, map, sizeof(file_header));
+    r.num_samples = (st.st_size - sizeof(file_header)) / (2 * sizeof(int16_t));
+    r.pps_offset = (int64_t)(r.header.pps_index - r.header.buffer_index);
+    sample_statistics((const int16_t*)((const char*)map + sizeof(file_header)), r.num_samples, r);
+    munmap(map, st.st_size);
+    r.valid = true;
+}
+
+
+/* Split <prefix><unix><suffix>.bin - Prefix is Empty or "<device>_" */
+static bool parse_name(const string& name, string& stream, time_t& stamp){
+    if (name.size() < 5 || name.compare(name.size() - 4, 4, ".bin") != 0)
+        return false;
+    size_t start = 0;
+    size_t underscore = name.find('_');
+    if (underscore != string::npos && underscore > 0 &&
+        name.find_first_not_of("0123456789") == underscore &&
+        isdigit(name[underscore + 1]))
+        start = underscore + 1;                         // Device Prefix
+    size_t end = name.find_first_not_of("0123456789", start);
+    if (end == start || end - start < 9)                // Unix Stamps Have at Least 9 Digits
+        return false;
+    stamp = (time_t)atoll(name.substr(start, end - start).c_str());
+    stream = name.substr(0, start) + name.substr(end, name.size() - 4 - end);
+    return true;
+}
+
+
+/* Entry Point */
+int main(int argc, char** argv){
+
+    /* Useage */
+    if (argc < 2){
+        cout << "Usage: " << argv[0] << " <capture dir> [summary.csv]" << endl;
+        return 1;
+    }
+    string dir = argv[1];
+    string out_name = (argc > 2) ? argv[2] : dir + "/summary.csv";
+
+    /* Find Captures */
+    vector<capture_result> results;
+    DIR* d = opendir(dir.c_str());
+    if (d == NULL){
+        cout << "Cannot open " << dir << endl;
+        return 1;
+    }
+    dirent* entry;
+    while ((entry = readdir(d)) != NULL){
+        capture_result r;
+        r.name = entry->d_name;
+        if (parse_name(r.name, r.stream, r.stamp))
+            results.push_back(r);
+    }
+    closedir(d);
+    if (results.empty()){
+        cout << "No captures in " << dir << endl;
+        return 1;
+    }
+    sort(results.begin(), results.end(), [](const capture_result& a, const capture_result& b){
+        return (a.stream != b.stream) ? a.stream < b.stream : a.stamp < b.stamp;
+    });
+
+    /* Analyse on All Cores */
+    timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    atomic<size_t> next(0);
+    int num_threads = max(1u, thread::hardware_concurrency());
+    vector<thread> threads;
+    for (int t = 0; t < num_threads; t++){
+        threads.push_back(thread([&](){
+            size_t i;
+            while ((i = next++) < results.size())
+                analyse(dir, results[i]);
+        }));
+    }
+    for (thread& t : threads)
+        t.join();
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    /* PPS Spacing Within Each Stream */
+    map<string, map<int64_t, size_t>> spacing;
+    for (size_t i = 0; i < results.size(); i++){
+        capture_result& r = results[i];
+        map<int64_t, size_t>& histogram = spacing[r.stream];
+        r.pps_delta = -1;
+        if (i > 0 && results[i - 1].valid && r.valid && results[i - 1].stream == r.stream && results[i - 1].stamp + 1 == r.stamp){
+            r.pps_delta = (int64_t)(r.header.pps_index - results[i - 1].header.pps_index);
+            histogram[r.pps_delta]++;
+        }
+    }
+
+    /* Summary Table */
+    ofstream out(out_name);
+    out << "file,unix,samples,pps_offset,pps_delta,clipped,rms_dbfs,dc_i,dc_q" << endl;
+    out << fixed;
+    uint64_t total_bytes = 0;
+    for (const capture_result& r : results){
+        if (!r.valid)
+            continue;
+        total_bytes += sizeof(file_header) + r.num_samples * 4;
+        out << r.name << "," << r.stamp << "," << r.num_samples << "," << r.pps_offset << ",";
+        if (r.pps_delta >= 0)
+            out << r.pps_delta;
+        out << "," << r.clipped << "," << setprecision(2) << r.rms << "," << setprecision(5) << r.dc_i << "," << r.dc_q << endl;
+    }
+    out.close();
+
+    /* Per Stream Report - Nominal Spacing is the Most Common */
+    cout << fixed;
+    for (auto& s : spacing){
+        size_t files = 0, flagged = 0, missing = 0;
+        uint64_t clipped = 0;
+        int64_t nominal = s.second.empty() ? -1 : max_element(s.second.begin(), s.second.end(),
+                          [](const pair<const int64_t, size_t>& a, const pair<const int64_t, size_t>& b){ return a.second < b.second; })->first;
+        time_t previous = 0;
+        for (const capture_result& r : results){
+            if (r.stream != s.first || !r.valid)
+                continue;
+            files++;
+            clipped += r.clipped;
+            if (previous && r.stamp > previous + 1)
+                missing += r.stamp - previous - 1;
+            previous = r.stamp;
+            if (r.pps_delta >= 0 && llabs(r.pps_delta - nominal) > pps_tolerance)
+                flagged++;
+        }
+        cout << "Stream '" << s.first << "': " << files << " files, " << missing << " seconds missing, "
+             << nominal << " samples between PPS, " << flagged << " irregular, " << clipped << " clipped samples" << endl;
+    }
+
+    size_t invalid = count_if(results.begin(), results.end(), [](const capture_result& r){ return !r.valid; });
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+    cout << setprecision(2) << "\nAnalysed " << results.size() - invalid << " files (" << total_bytes / 1e6 << " MB) in "
+         << elapsed << " s on " << num_threads << " threads, " << invalid << " unreadable" << endl;
+    cout << "Summary written to " << out_name << endl;
+
+    return 0;
+}
@@ -0,0 +1,258 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <string>
+#include "../common/capture_reader.h"
+
+using namespace std;
+
+// g++ ppscapture.cpp ../common/capture_reader.cpp -std=c++11 -O2 -shared -fPIC $(python3-config --includes) -o ppscapture$(python3-config --extension-suffix)
+
+/* Python Capture Object
+ * Samples are exported through the buffer protocol straight from the
+ * mapping - np.asarray(capture) is an int16 view, never a copy:
+ *   raw / pps captures   (num_samples, 2)
+ *   frame containers     (num_frames, frame_length, num_devices, 2), strided over the frame headers
+ */
+class capture_object {
+    public:
+        PyObject_HEAD
+        capture_reader* reader;
+        Py_ssize_t exports;                             // Live buffer views, the mapping is pinned while > 0
+        Py_ssize_t shape[4];
+        Py_ssize_t strides[4];
+        int ndim;
+};
+
+
+static void capture_dealloc(capture_object* self){
+    delete self->reader;
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+
+/* Buffer Protocol */
+static int capture_getbuffer(capture_object* self, Py_buffer* view, int flags){
+
+    if (self->reader == NULL){
+        PyErr_SetString(PyExc_ValueError, "capture is closed");
+        view->obj = NULL;
+        return -1;
+    }
+    if (flags & PyBUF_WRITABLE){
+        PyErr_SetString(PyExc_BufferError, "capture is read only");
+        view->obj = NULL;
+        return -1;
+    }
+    bool frames = (self->reader->format() == CAPTURE_FRAMES);
+    if (frames && (flags & PyBUF_STRIDES) != PyBUF_STRIDES){
+        PyErr_SetString(PyExc_BufferError, "frame containers are strided over the frame headers");
+        view->obj = NULL;
+        return -1;
+    }
+
+    const int16_t* data = frames ? self->reader->frame_samples(0) : self->reader->samples();
+    view->buf = (void*)data;
+    view->obj = (PyObject*)self;
+    Py_INCREF(self);
+    view->len = sizeof(int16_t);
+    for (int i = 0; i < self->ndim; i++)
+        view->len *= self->shape[i];
+    view->readonly = 1;
+    view->itemsize = sizeof(int16_t);
+    view->format = (flags & PyBUF_FORMAT) ? (char*)"h" : NULL;
+    view->ndim = self->ndim;
+    view->shape = ((flags & PyBUF_ND) == PyBUF_ND) ? self->shape : NULL;
+    view->strides = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES) ? self->strides : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+    self->exports++;
+    return 0;
+}
+
+
+static void capture_releasebuffer(capture_object* self, Py_buffer* view){
+    (void)view;
+    self->exports--;
+}
+
+
+static PyBufferProcs capture_buffer_procs = {
+    (getbufferproc)capture_getbuffer,
+    (releasebufferproc)capture_releasebuffer
+};
+
+
+/* Methods */
+static PyObject* capture_close(capture_object* self, PyObject* args){
+    (void)args;
+    if (self->exports > 0){
+        PyErr_SetString(PyExc_BufferError, "cannot close a capture with exported views");
+        return NULL;
+    }
+    delete self->reader;
+    self->reader = NULL;
+    Py_RETURN_NONE;
+}
+
+
+/* (gps_second, offset, valid_mask, (index per device)) of Frame i */
+static PyObject* capture_frame_header(capture_object* self, PyObject* args){
+    Py_ssize_t i;
+    if (!PyArg_ParseTuple(args, "n", &i))
+        return NULL;
+    if (self->reader == NULL || self->reader->format() != CAPTURE_FRAMES){
+        PyErr_SetString(PyExc_ValueError, "not an open frame container");
+        return NULL;
+    }
+    const frame_header* h = (i >= 0) ? self->reader->frame(i) : NULL;
+    if (h == NULL){
+        PyErr_SetString(PyExc_IndexError, "frame out of range");
+        return NULL;
+    }
+    uint32_t num_devices = self->reader->frames_header().num_devices;
+    const uint64_t* indices = self->reader->frame_indices(i);
+    PyObject* index_tuple = PyTuple_New(num_devices);
+    for (uint32_t d = 0; d < num_devices; d++)
+        PyTuple_SET_ITEM(index_tuple, d, PyLong_FromUnsignedLongLong(indices[d]));
+    return Py_BuildValue("(LkkN)", (long long)h->gps_second, (unsigned long)h->offset,
+                         (unsigned long)h->valid_mask, index_tuple);
+}
+
+
+static PyObject* capture_enter(capture_object* self, PyObject* args){
+    (void)args;
+    Py_INCREF(self);
+    return (PyObject*)self;
+}
+
+
+static PyObject* capture_exit(capture_object* self, PyObject* args){
+    (void)args;
+    return capture_close(self, NULL);
+}
+
+
+static PyMethodDef capture_methods[] = {
+    { "close", (PyCFunction)capture_close, METH_NOARGS, "Unmap the file - fails while views are alive" },
+    { "frame_header", (PyCFunction)capture_frame_header, METH_VARARGS, "(gps_second, offset, valid_mask, indices) of a frame" },
+    { "__enter__", (PyCFunction)capture_enter, METH_NOARGS, NULL },
+    { "__exit__", (PyCFunction)capture_exit, METH_VARARGS, NULL },
+    { NULL, NULL, 0, NULL }
+};
+
+
+/* Header Fields */
+static const char* format_names[] = { "raw", "pps", "frames" };
+
+static PyObject* capture_getattro(capture_object* self, PyObject* name){
+
+    const char* n = PyUnicode_AsUTF8(name);
+    const capture_reader* r = self->reader;
+    if (n && r){
+        const file_header& h = r->header();
+        const frame_file_header& f = r->frames_header();
+        if (strcmp(n, "format") == 0)           return PyUnicode_FromString(format_names[r->format()]);
+        if (strcmp(n, "file_size") == 0)        return PyLong_FromSize_t(r->file_size());
+        if (strcmp(n, "num_samples") == 0)      return PyLong_FromSize_t(r->num_samples());
+        if (strcmp(n, "unix_stamp") == 0)       return PyLong_FromLongLong(h.unix_stamp);
+        if (strcmp(n, "buffer_index") == 0)     return PyLong_FromUnsignedLongLong(h.buffer_index);
+        if (strcmp(n, "pps_index") == 0)        return PyLong_FromUnsignedLongLong(h.pps_index);
+        if (strcmp(n, "pps_offset") == 0)       return PyLong_FromLongLong((long long)(h.pps_index - h.buffer_index));
+        if (strcmp(n, "num_frames") == 0)       return PyLong_FromSize_t(r->num_frames());
+        if (strcmp(n, "num_devices") == 0)      return PyLong_FromUnsignedLong(f.num_devices);
+        if (strcmp(n, "frame_length") == 0)     return PyLong_FromUnsignedLong(f.frame_length);
+        if (strcmp(n, "sample_rate") == 0)      return PyFloat_FromDouble(f.sample_rate);
+    }
+    return PyObject_GenericGetAttr((PyObject*)self, name);
+}
+
+
+static PyTypeObject capture_type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "ppscapture.Capture"
+};
+
+
+/* ppscapture.open(name, header=True) */
+static PyObject* ppscapture_open(PyObject* module, PyObject* args, PyObject* kwargs){
+    (void)module;
+    const char* name;
+    int has_header = 1;
+    static const char* keywords[] = { "name", "header", NULL };
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s|p", (char**)keywords, &name, &has_header))
+        return NULL;
+
+    capture_reader* reader = new capture_reader(name, has_header);
+    if (!reader->is_open()){
+        delete reader;
+        return PyErr_SetFromErrnoWithFilename(PyExc_OSError, name);
+    }
+
+    capture_object* self = PyObject_New(capture_object, &capture_type);
+    if (self == NULL){
+        delete reader;
+        return NULL;
+    }
+    self->reader = reader;
+    self->exports = 0;
+
+    /* View Shape */
+    if (reader->format() == CAPTURE_FRAMES){
+        const frame_file_header& f = reader->frames_header();
+        Py_ssize_t frame_size = (reader->num_frames() > 1) ? (const char*)reader->frame(1) - (const char*)reader->frame(0) : 0;
+        self->ndim = 4;
+        self->shape[0] = reader->num_frames();
+        self->shape[1] = f.frame_length;
+        self->shape[2] = f.num_devices;
+        self->shape[3] = 2;
+        self->strides[0] = frame_size;
+        self->strides[1] = f.num_devices * 2 * sizeof(int16_t);
+        self->strides[2] = 2 * sizeof(int16_t);
+        self->strides[3] = sizeof(int16_t);
+    }
+    else {
+        self->ndim = 2;
+        self->shape[0] = reader->num_samples();
+        self->shape[1] = 2;
+        self->strides[0] = 2 * sizeof(int16_t);
+        self->strides[1] = sizeof(int16_t);
+    }
+    return (PyObject*)self;
+}
+
+
+static PyMethodDef ppscapture_methods[] = {
+    { "open", (PyCFunction)ppscapture_open, METH_VARARGS | METH_KEYWORDS,
+      "open(name, header=True) - map a capture, header=False for raw I/Q such as wfm.bin" },
+    { NULL, NULL, 0, NULL }
+};
+
+
+static PyModuleDef ppscapture_module = {
+    PyModuleDef_HEAD_INIT,
+    "ppscapture",
+    "Zero copy access to PPS capture files and frame containers",
+    -1,
+    ppscapture_methods
+};
+
+
+PyMODINIT_FUNC PyInit_ppscapture(void){
+
+    capture_type.tp_basicsize = sizeof(capture_object);
+    capture_type.tp_dealloc = (destructor)capture_dealloc;
+    capture_type.tp_getattro = (getattrofunc)capture_getattro;
+    capture_type.tp_as_buffer = &capture_buffer_procs;
+    capture_type.tp_flags = Py_TPFLAGS_DEFAULT;
+    capture_type.tp_doc = "Memory mapped capture - use ppscapture.open()";
+    capture_type.tp_methods = capture_methods;
+    if (PyType_Ready(&capture_type) < 0)
+        return NULL;
+
+    PyObject* module = PyModule_Create(&ppscapture_module);
+    if (module == NULL)
+        return NULL;
+    Py_INCREF(&capture_type);
+    PyModule_AddObject(module, "Capture", (PyObject*)&capture_type);
+    return module;
+}
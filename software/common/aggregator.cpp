@@ -0,0 +1,274 @@
+#include <cmath>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include "aggregator.h"
+
+using namespace std;
+
+
+/*  CONTAINER FILE  */
+
+frame_file_sink::frame_file_sink(const string& name, int num_devices, int frame_length, double sample_rate)
+    : num_devices(num_devices), frame_length(frame_length){
+    frame_file_header header;
+    header.magic = FRAME_FILE_MAGIC;
+    header.version = FRAME_FILE_VERSION;
+    header.num_devices = num_devices;
+    header.frame_length = frame_length;
+    header.sample_rate = sample_rate;
+    file.open(name, std::ofstream::binary);
+    file.write((char*)&header, sizeof(header));
+}
+
+frame_file_sink::~frame_file_sink(){
+    file.close();
+}
+
+void frame_file_sink::write(const frame_header& header, const uint64_t* indices, const int16_t* samples){
+    file.write((char*)&header, sizeof(header));
+    file.write((char*)indices, num_devices * sizeof(uint64_t));
+    file.write((char*)samples, (size_t)frame_length * num_devices * 2 * sizeof(int16_t));
+}
+
+
+/*  DEVICE STREAM  */
+
+device_stream::device_stream(const string& name, packet_source* source, size_t ring_packets)
+    : name(name), source(source), ring(ring_packets), anchored(false),
+      anchor_second(0), anchor_index(0), window_index(0), num_missing(0){
+}
+
+
+/*  AGGREGATOR  */
+
+aggregator::aggregator(aggregator_configuration config, const vector<packet_source*>& sources, frame_sink& sink)
+    : config(config), sink(sink), num_frames(0){
+
+    samples_per_second = (uint64_t)llround(config.sample_rate);
+    if (sources.empty() || sources.size() > FRAME_MAX_DEVICES || sources.size() != config.names.size())
+        throw invalid_argument("aggregator: 1 to 32 devices");
+    if (config.frame_length <= 0 || samples_per_second % config.frame_length != 0)
+        throw invalid_argument("aggregator: frame length must divide the sample rate");
+
+    for (size_t d = 0; d < sources.size(); d++)
+        devices.push_back(unique_ptr<device_stream>(new device_stream(config.names[d], sources[d], config.ring_packets)));
+}
+
+aggregator::~aggregator(){
+    for (auto& dev : devices)
+        if (dev->receiver.joinable())
+            dev->receiver.join();
+}
+
+
+/* Reader Thread - Packet Source -> Bounded Device Ring */
+void aggregator::receive(device_stream* dev){
+    while (true){
+        rx_packet* packet = dev->ring.claim();
+        bool ring_full = (packet == NULL);
+        if (ring_full)
+            packet = &dev->overflow_packet;
+
+        int status = dev->source->read(packet, 100);
+        if (status == 1){
+            if (ring_full)
+                dev->ring.drop();
+            else
+                dev->ring.publish();
+        } else if (status == 0 && dev->source->closed()){
+            break;
+        }
+    }
+    dev->ring.close();
+}
+
+
+/* Track PPS Events - Second is Counted from the Previous Anchor */
+void aggregator::update_anchor(device_stream* dev, const rx_packet& packet){
+    int64_t elapsed = (int64_t)(packet.pps_index - dev->anchor_index);
+    int64_t seconds = llround((double)elapsed / samples_per_second);
+    int64_t error = elapsed - seconds * (int64_t)samples_per_second;
+    if (error > 1 || error < -1)
+        cout << dev->name << ": PPS at sample " << packet.pps_index << " is " << error
+             << " samples from prediction, re-anchored" << endl;
+    dev->anchor_second += seconds;
+    dev->anchor_index = packet.pps_index;
+}
+
+/* Wait for the First PPS - Keeps a Few Packets so a PPS Flagged Late is Still Covered */
+bool aggregator::anchor(device_stream* dev){
+    const size_t packet_size = RX_PACKET_SAMPLES * 2;
+    rx_packet* packet;
+    while (!dev->anchored && (packet = dev->ring.peek(0)) != NULL){
+        uint64_t window_end = dev->window_index + dev->window.size() / 2;
+        if (dev->window.empty() || packet->index != window_end){
+            dev->window.clear();
+            dev->window_index = packet->index;
+        }
+        dev->window.insert(dev->window.end(), packet->samples, packet->samples + packet_size);
+        if (dev->window.size() > 4 * packet_size){
+            dev->window.erase(dev->window.begin(), dev->window.begin() + packet_size);
+            dev->window_index += RX_PACKET_SAMPLES;
+        }
+
+        if (packet->pps){
+            dev->anchored = true;
+            dev->anchor_second = packet->unix_stamp;
+            dev->anchor_index = packet->pps_index;
+            cout << dev->name << ": first PPS at sample " << packet->pps_index
+                 << " (unix " << packet->unix_stamp << ")" << endl;
+        }
+        dev->ring.release();
+    }
+    return dev->anchored;
+}
+
+/* Cover [start, start + frame_length) - 1 Ready, 0 Not Yet, -1 Unavailable */
+int aggregator::fill(device_stream* dev, uint64_t start){
+    const size_t packet_size = RX_PACKET_SAMPLES * 2;
+    const uint64_t end = start + config.frame_length;
+
+    while (true){
+
+        /* Discard Samples Before the Frame */
+        if (start > dev->window_index){
+            size_t n = min((size_t)(start - dev->window_index) * 2, dev->window.size());
+            dev->window.erase(dev->window.begin(), dev->window.begin() + n);
+            dev->window_index += n / 2;
+        }
+        uint64_t window_end = dev->window_index + dev->window.size() / 2;
+        if (!dev->window.empty() && window_end >= end)
+            break;
+
+        rx_packet* packet = dev->ring.peek(0);
+        if (packet == NULL){
+            if (!dev->ring.closed())
+                return 0;
+            if ((packet = dev->ring.peek(0)) == NULL)
+                return -1;
+        }
+
+        if (packet->pps)
+            update_anchor(dev, *packet);
+
+        /* Stale Packet, or Restart After a Gap */
+        if (!dev->window.empty() && packet->index < window_end){
+            dev->ring.release();
+            continue;
+        }
+        if (dev->window.empty() || packet->index != window_end){
+            dev->window.clear();
+            dev->window_index = packet->index;
+        }
+        dev->window.insert(dev->window.end(), packet->samples, packet->samples + packet_size);
+        dev->ring.release();
+    }
+
+    /* Start of the Frame Lost to a Gap */
+    return (start >= dev->window_index) ? 1 : -1;
+}
+
+
+/* Build Frames Until All Devices Close */
+void aggregator::run(){
+
+    const int num_devices = devices.size();
+    const int frame_length = config.frame_length;
+
+    for (auto& dev : devices)
+        dev->receiver = thread(&aggregator::receive, this, dev.get());
+
+    /* Anchor Every Device */
+    while (true){
+        bool all_anchored = true, any_closed = false;
+        for (auto& dev : devices){
+            all_anchored &= anchor(dev.get());
+            any_closed |= (!dev->anchored && dev->ring.closed());
+        }
+        if (all_anchored)
+            break;
+        if (any_closed){
+            cout << "Device closed before its first PPS" << endl;
+            return;
+        }
+        this_thread::sleep_for(chrono::microseconds(100));
+    }
+
+    /* Start at the Latest First Second */
+    time_t second = 0;
+    for (auto& dev : devices)
+        second = max(second, dev->anchor_second);
+    uint64_t offset = 0;
+
+    vector<int16_t> samples((size_t)frame_length * num_devices * 2);
+    vector<uint64_t> indices(num_devices);
+    vector<int> state(num_devices);
+    size_t lag_packets = (size_t)(config.lag_threshold * config.ring_packets);
+
+    while (true){
+
+        /* Position of the Frame in each Device's Sample Count */
+        bool waiting = false, all_closed = true;
+        for (int d = 0; d < num_devices; d++){
+            device_stream* dev = devices[d].get();
+            indices[d] = dev->anchor_index + (int64_t)(second - dev->anchor_second) * (int64_t)samples_per_second + offset;
+            state[d] = fill(dev, indices[d]);
+            waiting |= (state[d] == 0);
+            all_closed &= (state[d] == -1 && dev->ring.closed());
+        }
+        if (all_closed)
+            break;
+
+        /* Wait for Lagging Devices Until a Leading Ring Fills */
+        if (waiting){
+            bool force = false;
+            for (auto& dev : devices)
+                force |= (dev->ring.count() >= lag_packets);
+            if (!force){
+                this_thread::sleep_for(chrono::microseconds(100));
+                continue;
+            }
+        }
+
+        /* Interleave */
+        frame_header header;
+        header.gps_second = second;
+        header.offset = offset;
+        header.valid_mask = 0;
+        for (int d = 0; d < num_devices; d++){
+            device_stream* dev = devices[d].get();
+            if (state[d] == 1){
+                header.valid_mask |= 1u << d;
+                const int16_t* src = &dev->window[(indices[d] - dev->window_index) * 2];
+                for (int i = 0; i < frame_length; i++){
+                    samples[(i * num_devices + d) * 2] = src[i * 2];
+                    samples[(i * num_devices + d) * 2 + 1] = src[i * 2 + 1];
+                }
+            } else {
+                dev->num_missing++;
+                for (int i = 0; i < frame_length; i++){
+                    samples[(i * num_devices + d) * 2] = 0;
+                    samples[(i * num_devices + d) * 2 + 1] = 0;
+                }
+            }
+        }
+        sink.write(header, indices.data(), samples.data());
+        num_frames++;
+
+        /* Next Frame */
+        offset += frame_length;
+        if (offset >= samples_per_second){
+            offset = 0;
+            second++;
+            cout << "Second " << second - 1 << " complete, frames " << num_frames;
+            for (auto& dev : devices)
+                cout << "  " << dev->name << " missing " << dev->num_missing << " dropped " << dev->ring.dropped();
+            cout << endl;
+        }
+    }
+
+    for (auto& dev : devices)
+        dev->receiver.join();
+}
@@ -0,0 +1,92 @@
+#ifndef AGGREGATOR_H
+#define AGGREGATOR_H
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include "rx_ring.h"
+#include "frame_file.h"
+using namespace std;
+
+/* Aggregator Configuration */
+class aggregator_configuration {
+    public:
+        vector<string> names;                           // Device names for reporting
+        size_t ring_packets;                            // Bounded buffer per device
+        double lag_threshold;                           // Ring fill that stops waiting for a lagging device
+        int frame_length;                               // Samples per device per frame, divides the sample rate
+        double sample_rate;
+};
+
+/* Frame Consumer */
+class frame_sink {
+    public:
+        virtual ~frame_sink() {}
+        virtual void write(const frame_header& header, const uint64_t* indices, const int16_t* samples) = 0;
+};
+
+/* Container File Sink */
+class frame_file_sink : public frame_sink {
+    public:
+        frame_file_sink(const string& name, int num_devices, int frame_length, double sample_rate);
+        ~frame_file_sink();
+        void write(const frame_header& header, const uint64_t* indices, const int16_t* samples);
+
+    private:
+        ofstream file;
+        int num_devices;
+        int frame_length;
+};
+
+/* One Device - Reader Thread Fills the Ring, the Aligner Drains it into the Window */
+class device_stream {
+    public:
+        device_stream(const string& name, packet_source* source, size_t ring_packets);
+
+        string name;
+        packet_source* source;
+        rx_ring ring;
+        rx_packet overflow_packet;
+        thread receiver;
+
+        /* Aligner State */
+        bool anchored;
+        time_t anchor_second;                           // Second of the most recent PPS event
+        uint64_t anchor_index;                          // Its sample index
+        vector<int16_t> window;                         // Contiguous samples from window_index
+        uint64_t window_index;
+        uint64_t num_missing;                           // Frames without this device
+};
+
+/* PPS Aligned Multi-Device Frame Builder
+ * Each device's samples are placed on a common (GPS second, offset) grid
+ * from its latest PPS sample index. A frame is emitted once every device
+ * covers it, or early with lagging devices marked missing when another
+ * device's ring passes the lag threshold - so a stalled device costs only
+ * its own samples and memory stays bounded by the rings.
+ */
+class aggregator {
+    public:
+        aggregator(aggregator_configuration config, const vector<packet_source*>& sources, frame_sink& sink);
+        ~aggregator();
+
+        void run();                                     // Until every device closes
+
+        uint64_t frames() const { return num_frames; }
+
+    private:
+        void receive(device_stream* dev);
+        bool anchor(device_stream* dev);
+        int fill(device_stream* dev, uint64_t start);
+        void update_anchor(device_stream* dev, const rx_packet& packet);
+
+        aggregator_configuration config;
+        frame_sink& sink;
+        vector<unique_ptr<device_stream>> devices;
+        uint64_t samples_per_second;
+        uint64_t num_frames;
+};
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef CAPTURE_FILE_H
+#define CAPTURE_FILE_H
+
+#include <ctime>
+#include <stdint.h>
+
+/* Output File Header
+ * Followed by interleaved int16_t I/Q samples. For decimated captures both
+ * indices are in the decimated timebase.
+ */
+class file_header {
+    public:
+        time_t unix_stamp;
+        uint64_t buffer_index;
+        uint64_t pps_index;
+};
+
+#endif
@@ -0,0 +1,326 @@
+#include <cstdio>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/stat.h>
+#include "capture_journal.h"
+
+using namespace std;
+
+
+uint64_t journal_checksum(uint64_t hash, const void* data, size_t bytes){
+    const uint8_t* p = (const uint8_t*)data;
+    size_t words = bytes / 8;
+    for (size_t i = 0; i < words; i++){
+        uint64_t w;
+        memcpy(&w, p + i * 8, 8);
+        hash = (hash ^ w) * 1099511628211ULL;
+    }
+    for (size_t i = words * 8; i < bytes; i++)
+        hash = (hash ^ p[i]) * 1099511628211ULL;
+    return hash;
+}
+
+/* Record Checksum Covers Everything Before it */
+static uint32_t record_checksum(const journal_record& record){
+    uint64_t hash = journal_checksum(JOURNAL_CHECKSUM_SEED, &record, offsetof(journal_record, record_checksum));
+    return (uint32_t)(hash ^ (hash >> 32));
+}
+
+static journal_record make_record(uint32_t type, uint64_t sequence){
+    journal_record record;
+    memset(&record, 0, sizeof(record));
+    record.magic = CAPTURE_JOURNAL_MAGIC;
+    record.type = type;
+    record.sequence = sequence;
+    return record;
+}
+
+
+/*  FILE HELPERS  */
+
+static string directory_of(const string& file){
+    size_t slash = file.find_last_of('/');
+    return (slash == string::npos) ? "." : (slash == 0) ? "/" : file.substr(0, slash);
+}
+
+/* Flush a File's Data, or a Directory's Entries */
+static bool sync_path(const string& name, bool data_only){
+    int f = open(name.c_str(), O_RDONLY);
+    if (f < 0)
+        return false;
+    bool ok = (data_only ? fdatasync(f) : fsync(f)) == 0;
+    close(f);
+    return ok;
+}
+
+static bool write_all(int f, const void* data, size_t bytes){
+    const char* p = (const char*)data;
+    while (bytes > 0){
+        ssize_t n = ::write(f, p, bytes);
+        if (n <= 0)
+            return false;
+        p += n;
+        bytes -= n;
+    }
+    return true;
+}
+
+/* Size & Checksum of a File on Disk Against its Record */
+static bool file_matches(const journal_record& record){
+    int f = open(record.path, O_RDONLY);
+    if (f < 0)
+        return false;
+    struct stat st;
+    bool ok = (fstat(f, &st) == 0 && (uint64_t)st.st_size == record.size && record.head_bytes <= record.size);
+    if (ok){
+        vector<char> contents(record.size);
+        ok = (pread(f, contents.data(), contents.size(), 0) == (ssize_t)contents.size());
+        uint64_t hash = journal_checksum(JOURNAL_CHECKSUM_SEED, contents.data(), record.head_bytes);
+        hash = journal_checksum(hash, contents.data() + record.head_bytes, record.size - record.head_bytes);
+        ok = ok && (hash == record.checksum);
+    }
+    close(f);
+    return ok;
+}
+
+
+/*  JOURNAL  */
+
+capture_journal::capture_journal(const string& path, uint64_t segment_bytes)
+    : path(path), segment_bytes(segment_bytes), fd(-1), next_sequence(0), pending_bytes(0), num_segments(0),
+      commit_due(false), stopping(false){
+    memset(&recovered, 0, sizeof(recovered));
+    recover();
+    fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0)
+        cout << "Unable to open capture journal " << path << endl;
+    committer = thread(&capture_journal::run, this);
+}
+
+capture_journal::~capture_journal(){
+    {
+        lock_guard<mutex> lock(journal_mutex);
+        stopping = true;
+    }
+    commit_cv.notify_all();
+    committer.join();
+    if (fd < 0)
+        return;
+    commit();
+    close(fd);
+}
+
+
+/* Commit Thread - Syncs Stall Here, Not in the Writer that Filled the Segment */
+void capture_journal::run(){
+    unique_lock<mutex> lock(journal_mutex);
+    while (true){
+        commit_cv.wait(lock, [&]{ return stopping || commit_due; });
+        if (stopping)
+            return;
+        commit_due = false;
+        lock.unlock();
+        commit();
+        lock.lock();
+    }
+}
+
+
+/* Replay the Journal - Trust Committed Records, Check the Rest */
+void capture_journal::recover(){
+
+    /* Records up to the First Torn One */
+    vector<journal_record> records;
+    int f = open(path.c_str(), O_RDONLY);
+    if (f < 0)
+        return;
+    struct stat st;
+    fstat(f, &st);
+    records.resize(st.st_size / sizeof(journal_record));
+    ssize_t got = pread(f, records.data(), records.size() * sizeof(journal_record), 0);
+    close(f);
+    size_t valid = (got > 0) ? got / sizeof(journal_record) : 0;
+    for (size_t i = 0; i < valid; i++)
+        if (records[i].magic != CAPTURE_JOURNAL_MAGIC || records[i].record_checksum != record_checksum(records[i])){
+            valid = i;
+            break;
+        }
+    recovered.torn = (st.st_size - valid * sizeof(journal_record) + sizeof(journal_record) - 1) / sizeof(journal_record);
+    records.resize(valid);
+
+    /* Commit Point & Discards */
+    uint64_t committed = 0;
+    set<uint64_t> discarded;
+    for (const journal_record& r : records){
+        if (r.type == JOURNAL_COMMIT)
+            committed = max(committed, r.sequence);
+        else if (r.type == JOURNAL_DISCARD)
+            discarded.insert(r.sequence);
+        next_sequence = max(next_sequence, r.sequence + 1);
+    }
+
+    /* Uncommitted Captures are Checked, Intact Ones Synced Now */
+    vector<journal_record> kept;
+    bool uncommitted = false;
+    for (journal_record& r : records){
+        if (r.type != JOURNAL_CAPTURE || discarded.count(r.sequence))
+            continue;
+        r.path[CAPTURE_JOURNAL_PATH - 1] = 0;
+        if (r.sequence < committed){
+            recovered.committed++;
+            kept.push_back(r);
+            continue;
+        }
+        uncommitted = true;
+        if (file_matches(r) && sync_path(r.path, true)){
+            recovered.verified++;
+            kept.push_back(r);
+        } else {
+            recovered.damaged++;
+            rename(r.path, (string(r.path) + ".damaged").c_str());
+        }
+    }
+    if (!uncommitted && recovered.torn == 0)
+        return;
+
+    /* Rebuild from the Good Records, Committed as One Segment */
+    string rebuilt = path + ".tmp";
+    f = open(rebuilt.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (f < 0){
+        cout << "Unable to rebuild capture journal " << path << endl;
+        return;
+    }
+    for (const journal_record& r : kept)
+        sync_path(directory_of(r.path), false);
+    journal_record commit_record = make_record(JOURNAL_COMMIT, next_sequence);
+    commit_record.record_checksum = record_checksum(commit_record);
+    kept.push_back(commit_record);
+    bool ok = write_all(f, kept.data(), kept.size() * sizeof(journal_record)) && fdatasync(f) == 0;
+    close(f);
+    if (ok && rename(rebuilt.c_str(), path.c_str()) == 0)
+        sync_path(directory_of(path), false);
+    else
+        cout << "Unable to rebuild capture journal " << path << endl;
+}
+
+
+bool capture_journal::append(journal_record& record){
+    record.record_checksum = record_checksum(record);
+    return fd >= 0 && write_all(fd, &record, sizeof(record));
+}
+
+
+/* Record, Write & Start Writeback - Synced Later with the Segment */
+bool capture_journal::write(const string& file, time_t unix_stamp, const void* head, size_t head_bytes,
+                            const void* data, size_t data_bytes){
+
+    /* A Cut Path would Send Recovery to the Wrong File */
+    if (file.size() >= CAPTURE_JOURNAL_PATH){
+        cout << "Path too long for the capture journal: " << file << endl;
+        return false;
+    }
+
+    journal_record record = make_record(JOURNAL_CAPTURE, 0);
+    record.unix_stamp = unix_stamp;
+    record.size = head_bytes + data_bytes;
+    record.head_bytes = head_bytes;
+    record.checksum = journal_checksum(journal_checksum(JOURNAL_CHECKSUM_SEED, head, head_bytes), data, data_bytes);
+    memcpy(record.path, file.c_str(), file.size());
+    bool recorded;
+    {
+        lock_guard<mutex> lock(journal_mutex);
+        record.sequence = next_sequence++;
+        recorded = append(record);
+        if (recorded)
+            in_flight.insert(record.sequence);
+    }
+
+    /* Nothing Written Without a Record, or a Commit would Cover it Unchecked */
+    if (!recorded){
+        cout << "Capture journal record for " << file << " failed" << endl;
+        return false;
+    }
+
+    /* Data Write - Writeback Starts Now so the Segment Sync is Short */
+    bool ok = false;
+    int f = open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (f >= 0){
+        iovec parts[2] = { { (void*)head, head_bytes }, { (void*)data, data_bytes } };
+        ok = (writev(f, parts, 2) == (ssize_t)record.size) ||
+             (lseek(f, 0, SEEK_SET) == 0 && write_all(f, head, head_bytes) && write_all(f, data, data_bytes));
+        sync_file_range(f, 0, 0, SYNC_FILE_RANGE_WRITE);
+        ok = (close(f) == 0) && ok;
+    }
+
+    bool due = false;
+    {
+        lock_guard<mutex> lock(journal_mutex);
+        in_flight.erase(record.sequence);
+        if (ok){
+            written.push_back(file);
+            pending_bytes += record.size;
+        } else {
+            journal_record discard = make_record(JOURNAL_DISCARD, record.sequence);
+            if (!append(discard))
+                cout << "Capture journal discard for " << file << " failed" << endl;
+        }
+        if (pending_bytes >= segment_bytes && !commit_due){
+            commit_due = true;
+            due = true;
+        }
+    }
+    if (!ok)
+        cout << "Write to " << file << " failed" << endl;
+    if (due)
+        commit_cv.notify_one();
+    return ok;
+}
+
+
+/* Sync the Segment's Files & Directories, then Commit Everything Below the Oldest Write in Flight */
+void capture_journal::commit(){
+
+    lock_guard<mutex> commit_lock(commit_mutex);
+    vector<string> files;
+    uint64_t durable;
+    {
+        lock_guard<mutex> lock(journal_mutex);
+        files.swap(written);
+        pending_bytes = 0;
+        durable = in_flight.empty() ? next_sequence : *in_flight.begin();
+    }
+    if (files.empty())
+        return;
+
+    set<string> directories;
+    bool synced = true;
+    for (const string& file : files){
+        synced = sync_path(file, true) && synced;
+        directories.insert(directory_of(file));
+    }
+    for (const string& directory : directories)
+        synced = sync_path(directory, false) && synced;
+
+    /* Capture Records Reach the Disk Before the Commit that Covers Them */
+    synced = synced && fdatasync(fd) == 0;
+
+    /* No Commit Unless Everything it Covers is on Disk - the Next Segment Retries */
+    bool ok = false;
+    {
+        lock_guard<mutex> lock(journal_mutex);
+        if (synced){
+            journal_record record = make_record(JOURNAL_COMMIT, durable);
+            ok = append(record);
+        }
+        if (ok)
+            num_segments++;
+        else
+            written.insert(written.begin(), files.begin(), files.end());
+    }
+    if (!ok || fdatasync(fd) != 0)
+        cout << "Capture journal commit failed" << endl;
+}
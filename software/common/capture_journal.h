@@ -0,0 +1,107 @@
+#ifndef CAPTURE_JOURNAL_H
+#define CAPTURE_JOURNAL_H
+
+#include <set>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ctime>
+#include <stdint.h>
+#include <stddef.h>
+#include <condition_variable>
+using namespace std;
+
+/* Journal Record Identification */
+#define CAPTURE_JOURNAL_MAGIC 0x4C4E524A                // "JRNL"
+#define CAPTURE_JOURNAL_PATH 96                         // Including the terminator - longer paths are refused
+
+enum journal_record_type {
+    JOURNAL_CAPTURE = 1,                                // File written, checksum of its contents
+    JOURNAL_COMMIT = 2,                                 // Every capture below sequence is on disk
+    JOURNAL_DISCARD = 3                                 // Capture sequence failed, ignore its record
+};
+
+/* Journal Record - Fixed Size, Appended Only */
+class journal_record {
+    public:
+        uint32_t magic;
+        uint32_t type;
+        uint64_t sequence;
+        int64_t unix_stamp;                             // Second of the capture
+        uint64_t size;                                  // File bytes
+        uint64_t checksum;                              // journal_checksum of head, then of the rest
+        char path[CAPTURE_JOURNAL_PATH];
+        uint32_t head_bytes;
+        uint32_t record_checksum;                       // Detects a torn append
+};
+
+/* Outcome of the Startup Recovery Pass */
+class journal_recovery {
+    public:
+        uint64_t committed;                             // Captures covered by a commit, trusted
+        uint64_t verified;                              // Uncommitted captures found intact
+        uint64_t damaged;                               // Uncommitted captures truncated or corrupt
+        uint64_t torn;                                  // Partial records cut from the journal tail
+};
+
+/* Crash Consistent Capture Writer
+ * Each capture is recorded in an append-only journal before its file is
+ * written. Files are not synced one by one: once segment_bytes have been
+ * written since the last commit, the journal's own thread syncs every file
+ * of the segment together, then appends a commit record and syncs the
+ * journal. Writers only signal it, so a slow drive never holds up a writer
+ * on another.
+ *
+ * On open the journal is replayed. Records up to the last commit are
+ * trusted, later ones are checked against their file's size & checksum.
+ * Damaged files are renamed to <path>.damaged, and the journal is rebuilt
+ * from the good records if anything was uncommitted or torn.
+ */
+class capture_journal {
+    public:
+        capture_journal(const string& path, uint64_t segment_bytes);
+        ~capture_journal();                             // Commits the open segment
+
+        bool opened() const { return fd >= 0; }
+        const journal_recovery& recovery() const { return recovered; }
+        uint64_t segments() const { return num_segments; }
+
+        /* Write head then data to a new file - Safe from Any Thread, False if the Path Does not Fit a Record */
+        bool write(const string& file, time_t unix_stamp, const void* head, size_t head_bytes,
+                   const void* data, size_t data_bytes);
+
+        /* Make Every Completed Write Durable - Left for the Next Commit if a Sync Fails */
+        void commit();
+
+    private:
+        void recover();
+        void run();                                     // Commits each segment as it fills
+        bool append(journal_record& record);            // Caller holds journal_mutex
+
+        string path;
+        uint64_t segment_bytes;
+        int fd;
+        journal_recovery recovered;
+
+        /* Open Segment */
+        mutex journal_mutex;
+        mutex commit_mutex;                             // Commits run one at a time, in order
+        uint64_t next_sequence;
+        set<uint64_t> in_flight;                        // Recorded, file still being written
+        vector<string> written;                         // Complete, not yet synced
+        uint64_t pending_bytes;
+        uint64_t num_segments;
+
+        /* Commit Thread - Signalled under journal_mutex */
+        thread committer;
+        condition_variable commit_cv;
+        bool commit_due;
+        bool stopping;
+};
+
+/* FNV-1a over 64-bit Words, Tail Bytewise - Chain with the Previous Hash */
+uint64_t journal_checksum(uint64_t hash, const void* data, size_t bytes);
+#define JOURNAL_CHECKSUM_SEED 14695981039346656037ULL
+
+#endif
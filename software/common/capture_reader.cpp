@@ -0,0 +1,100 @@
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "string.h"
+#include "capture_reader.h"
+
+using namespace std;
+
+
+capture_reader::capture_reader(const string& name, bool has_header)
+    : map(NULL), size(0), layout(CAPTURE_RAW), sample_data(NULL), sample_count(0), frame_size(0), frame_count(0){
+
+    memset(&capture_header, 0, sizeof(capture_header));
+    memset(&container_header, 0, sizeof(container_header));
+
+    int fd = open(name.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+    struct stat st;
+    if (fstat(fd, &st) != 0){
+        close(fd);
+        return;
+    }
+
+    /* Nothing to Map - errno Tells the Caller Why */
+    if (st.st_size == 0){
+        close(fd);
+        errno = EINVAL;
+        return;
+    }
+    size = st.st_size;
+
+    /* Map Without Populating - Pages Fault in on Access */
+    void* m = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED){
+        size = 0;
+        return;
+    }
+    map = (const char*)m;
+
+    /* Frame Container */
+    if (size >= sizeof(frame_file_header)){
+        memcpy(&container_header, map, sizeof(container_header));
+        if (container_header.magic == FRAME_FILE_MAGIC && container_header.num_devices > 0 &&
+            container_header.num_devices <= FRAME_MAX_DEVICES){
+            layout = CAPTURE_FRAMES;
+            frame_size = sizeof(frame_header) + container_header.num_devices * sizeof(uint64_t) +
+                         (size_t)container_header.frame_length * container_header.num_devices * 2 * sizeof(int16_t);
+            frame_count = (size - sizeof(frame_file_header)) / frame_size;
+            return;
+        }
+        memset(&container_header, 0, sizeof(container_header));
+    }
+
+    /* Single Device Capture */
+    size_t offset = 0;
+    if (has_header && size < sizeof(file_header)){
+        munmap((void*)map, size);
+        map = NULL;
+        size = 0;
+        errno = EINVAL;
+        return;
+    }
+    if (has_header){
+        memcpy(&capture_header, map, sizeof(capture_header));
+        layout = CAPTURE_PPS;
+        offset = sizeof(file_header);
+    }
+    sample_data = (const int16_t*)(map + offset);
+    sample_count = (size - offset) / (2 * sizeof(int16_t));
+    madvise((void*)map, size, MADV_SEQUENTIAL);
+}
+
+
+capture_reader::~capture_reader(){
+    if (map)
+        munmap((void*)map, size);
+}
+
+
+const frame_header* capture_reader::frame(size_t i) const {
+    if (layout != CAPTURE_FRAMES || i >= frame_count)
+        return NULL;
+    return (const frame_header*)(map + sizeof(frame_file_header) + i * frame_size);
+}
+
+
+const uint64_t* capture_reader::frame_indices(size_t i) const {
+    const frame_header* f = frame(i);
+    return f ? (const uint64_t*)(f + 1) : NULL;
+}
+
+
+const int16_t* capture_reader::frame_samples(size_t i) const {
+    const uint64_t* indices = frame_indices(i);
+    return indices ? (const int16_t*)(indices + container_header.num_devices) : NULL;
+}
@@ -0,0 +1,61 @@
+#ifndef CAPTURE_READER_H
+#define CAPTURE_READER_H
+
+#include <string>
+#include <stddef.h>
+#include <stdint.h>
+#include "capture_file.h"
+#include "frame_file.h"
+using namespace std;
+
+/* Capture File Layouts */
+enum capture_format {
+    CAPTURE_RAW = 0,                                    // Interleaved int16_t I/Q only - wfm.bin, output.bin
+    CAPTURE_PPS,                                        // file_header then I/Q - pps_sync_rx / pps_sync_tx
+    CAPTURE_FRAMES                                      // Multi-device container - frame_file.h
+};
+
+/* Memory Mapped Capture Reader
+ * The file is mapped read only and never copied - pages are faulted in
+ * as samples are touched, so opening is constant time whatever the size.
+ * The frame container is recognised by its magic, other files are taken
+ * as headed captures unless has_header is false. An empty file, or one
+ * too short for its header, is not opened and errno is set to EINVAL.
+ */
+class capture_reader {
+    public:
+        capture_reader(const string& name, bool has_header = true);
+        ~capture_reader();
+
+        bool is_open() const { return map != NULL; }
+        capture_format format() const { return layout; }
+        size_t file_size() const { return size; }
+
+        /* CAPTURE_RAW & CAPTURE_PPS */
+        const file_header& header() const { return capture_header; }
+        const int16_t* samples() const { return sample_data; }
+        size_t num_samples() const { return sample_count; }
+
+        /* CAPTURE_FRAMES */
+        const frame_file_header& frames_header() const { return container_header; }
+        size_t num_frames() const { return frame_count; }
+        const frame_header* frame(size_t i) const;
+        const uint64_t* frame_indices(size_t i) const;  // num_devices sample indices
+        const int16_t* frame_samples(size_t i) const;   // frame_length x num_devices I/Q
+
+    private:
+        capture_reader(const capture_reader&);
+        capture_reader& operator=(const capture_reader&);
+
+        const char* map;
+        size_t size;
+        capture_format layout;
+        file_header capture_header;
+        const int16_t* sample_data;
+        size_t sample_count;
+        frame_file_header container_header;
+        size_t frame_size;
+        size_t frame_count;
+};
+
+#endif
@@ -0,0 +1,192 @@
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include "capture_stripe.h"
+
+using namespace std;
+
+/* Write Rate Assumed for a Target Before its First Job (bytes/s) */
+#define STRIPE_INITIAL_RATE 1e9
+#define STRIPE_RATE_SMOOTHING 0.2
+
+
+void stripe_job::add(const string& name, time_t unix_stamp, const void* head, size_t head_bytes,
+                     const void* data, size_t data_bytes){
+    files.push_back(stripe_file());
+    stripe_file& file = files.back();
+    file.name = name;
+    file.unix_stamp = unix_stamp;
+    file.head_bytes = head_bytes;
+    file.contents.resize(head_bytes + data_bytes);
+    if (head_bytes)
+        memcpy(file.contents.data(), head, head_bytes);
+    if (data_bytes)
+        memcpy(file.contents.data() + head_bytes, data, data_bytes);
+    bytes += file.contents.size();
+}
+
+
+static bool write_all(int fd, const void* data, size_t bytes){
+    const char* p = (const char*)data;
+    while (bytes > 0){
+        ssize_t n = ::write(fd, p, bytes);
+        if (n <= 0)
+            return false;
+        p += n;
+        bytes -= n;
+    }
+    return true;
+}
+
+
+bool write_capture_file(const string& path, time_t unix_stamp, const void* head, size_t head_bytes,
+                        const void* data, size_t data_bytes, capture_journal* journal){
+    if (journal)
+        return journal->write(path, unix_stamp, head, head_bytes, data, data_bytes);
+
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+    bool ok = write_all(fd, head, head_bytes) && write_all(fd, data, data_bytes);
+    return (close(fd) == 0) && ok;
+}
+
+
+bool write_stripe_file(const string& prefix, const stripe_file& file, capture_journal* journal){
+    const char* contents = file.contents.data();
+    return write_capture_file(prefix + file.name, file.unix_stamp, contents, file.head_bytes,
+                              contents + file.head_bytes, file.contents.size() - file.head_bytes, journal);
+}
+
+
+/*  STRIPER  */
+
+capture_striper::capture_striper(const vector<string>& paths, stripe_policy policy, uint64_t max_queue_bytes,
+                                 capture_journal* journal)
+    : policy(policy), max_queue_bytes(max_queue_bytes), journal(journal), next_target(0), stopping(false){
+
+    for (const string& path : paths){
+        stripe_target* target = new stripe_target;
+        target->path = path;
+        target->queued_bytes = 0;
+        target->rate = STRIPE_INITIAL_RATE;
+        target->written_bytes = 0;
+        target->num_jobs = 0;
+        target->num_skipped = 0;
+        targets.push_back(unique_ptr<stripe_target>(target));
+    }
+    for (unique_ptr<stripe_target>& target : targets)
+        target->writer = thread(&capture_striper::run, this, target.get());
+}
+
+capture_striper::~capture_striper(){
+    stop();
+}
+
+
+/* Pick a Target with Room - Either the Next in Turn or the One Expected to Finish First */
+int capture_striper::choose(uint64_t bytes){
+
+    int best = -1;
+    double best_time = 0;
+    vector<stripe_target*> full;
+    for (size_t i = 0; i < targets.size(); i++){
+        size_t t = (next_target + i) % targets.size();
+        stripe_target* target = targets[t].get();
+
+        /* A Job Always Fits an Empty Queue */
+        if (target->queued_bytes > 0 && target->queued_bytes + bytes > max_queue_bytes){
+            full.push_back(target);
+            continue;
+        }
+        if (policy == STRIPE_ROUND_ROBIN){
+            best = t;
+            break;
+        }
+        double finish_time = (target->queued_bytes + bytes) / target->rate;
+        if (best < 0 || finish_time < best_time){
+            best = t;
+            best_time = finish_time;
+        }
+    }
+    if (best < 0)
+        return -1;
+
+    /* Skipped Only Once the Job Goes Elsewhere, Not on Each Pass While Waiting */
+    for (stripe_target* target : full)
+        target->num_skipped++;
+    next_target = (best + 1) % targets.size();
+    return best;
+}
+
+
+/* Queue a Job - Waits Only While Every Target is Full */
+void capture_striper::write(stripe_job* job){
+    {
+        unique_lock<mutex> lock(stripe_mutex);
+        int t;
+        while ((t = choose(job->bytes)) < 0)
+            space_cv.wait(lock);
+        targets[t]->queue.push_back(job);
+        targets[t]->queued_bytes += job->bytes;
+    }
+    work_cv.notify_all();
+}
+
+
+/* Writer Thread - One per Target */
+void capture_striper::run(stripe_target* target){
+    while (true){
+        stripe_job* job;
+        {
+            unique_lock<mutex> lock(stripe_mutex);
+            work_cv.wait(lock, [&]{ return stopping || !target->queue.empty(); });
+            if (target->queue.empty())
+                return;
+            job = target->queue.front();
+        }
+
+        /* Write & Measure */
+        auto t0 = chrono::steady_clock::now();
+        for (const stripe_file& file : job->files)
+            if (!write_stripe_file(target->path, file, journal) && !journal)
+                cout << "Write to " << target->path + file.name << " failed" << endl;
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+        {
+            lock_guard<mutex> lock(stripe_mutex);
+            target->queue.pop_front();
+            target->queued_bytes -= job->bytes;
+            target->written_bytes += job->bytes;
+            target->num_jobs++;
+            double rate = job->bytes / max(seconds, 1e-6);
+            target->rate += STRIPE_RATE_SMOOTHING * (rate - target->rate);
+        }
+        space_cv.notify_all();
+        delete job;
+    }
+}
+
+
+void capture_striper::stop(){
+    {
+        lock_guard<mutex> lock(stripe_mutex);
+        stopping = true;
+    }
+    work_cv.notify_all();
+    for (unique_ptr<stripe_target>& target : targets)
+        if (target->writer.joinable())
+            target->writer.join();
+}
+
+
+void capture_striper::report(){
+    lock_guard<mutex> lock(stripe_mutex);
+    for (const unique_ptr<stripe_target>& target : targets)
+        cout << "Stripe " << target->path << ": " << target->num_jobs << " captures, " << fixed << setprecision(1)
+             << target->written_bytes / 1e6 << " MB at " << target->rate / 1e6 << " MB/s, skipped "
+             << target->num_skipped << " times while full" << endl;
+}
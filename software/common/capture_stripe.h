@@ -0,0 +1,95 @@
+#ifndef CAPTURE_STRIPE_H
+#define CAPTURE_STRIPE_H
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <ctime>
+#include <stdint.h>
+#include <condition_variable>
+#include "capture_journal.h"
+using namespace std;
+
+/* File Waiting to be Written - name is Relative to the Target */
+class stripe_file {
+    public:
+        string name;
+        time_t unix_stamp;
+        size_t head_bytes;                              // Leading bytes, checksummed apart by the journal
+        vector<char> contents;
+};
+
+/* Files that Land on the Same Target, e.g. a SigMF Data & Meta Pair */
+class stripe_job {
+    public:
+        stripe_job() : bytes(0) {}
+        void add(const string& name, time_t unix_stamp, const void* head, size_t head_bytes,
+                 const void* data, size_t data_bytes);
+
+        vector<stripe_file> files;
+        uint64_t bytes;
+};
+
+/* Write Head then Data to a New File, Through the Journal if There is One */
+bool write_capture_file(const string& path, time_t unix_stamp, const void* head, size_t head_bytes,
+                        const void* data, size_t data_bytes, capture_journal* journal);
+
+/* Write a File Under a Path Prefix, Through the Journal if There is One */
+bool write_stripe_file(const string& prefix, const stripe_file& file, capture_journal* journal);
+
+/* How Jobs are Spread Over the Targets */
+enum stripe_policy {
+    STRIPE_ROUND_ROBIN = 0,                             // In turn, skipping targets with a full queue
+    STRIPE_LEAST_LOADED                                 // Earliest expected completion at the measured rate
+};
+
+/* Output Target - Directory & File Prefix with its Own Queue & Writer Thread */
+class stripe_target {
+    public:
+        string path;
+        deque<stripe_job*> queue;
+        uint64_t queued_bytes;
+        double rate;                                    // Smoothed write rate (bytes/s)
+        uint64_t written_bytes;
+        uint64_t num_jobs;
+        uint64_t num_skipped;                           // Times passed over with a full queue
+        thread writer;
+};
+
+/* Capture Striper
+ * Spreads capture jobs over several targets, typically one per drive, each
+ * written by its own thread. A target whose queue holds max_queue_bytes is
+ * skipped, so a slow drive only slows itself. write() blocks only when every
+ * queue is full. All files go through the one journal, which therefore
+ * indexes every target.
+ */
+class capture_striper {
+    public:
+        capture_striper(const vector<string>& paths, stripe_policy policy, uint64_t max_queue_bytes,
+                        capture_journal* journal);
+        ~capture_striper();
+
+        void write(stripe_job* job);                    // Takes ownership
+        void stop();                                    // Drains every queue
+        void report();
+
+    private:
+        int choose(uint64_t bytes);                     // Caller holds stripe_mutex, -1 if all full
+        void run(stripe_target* target);
+
+        stripe_policy policy;
+        uint64_t max_queue_bytes;
+        capture_journal* journal;
+        vector<unique_ptr<stripe_target>> targets;
+        size_t next_target;
+
+        mutex stripe_mutex;
+        condition_variable work_cv;
+        condition_variable space_cv;
+        bool stopping;
+};
+
+#endif
@@ -0,0 +1,98 @@
+#include <cmath>
+#include <stdexcept>
+#include "delay_estimator.h"
+
+using namespace std;
+
+/* Smallest Power of 2 >= n */
+static size_t next_power_of_2(size_t n){
+    size_t p = 1;
+    while (p < n)
+        p <<= 1;
+    return p;
+}
+
+
+delay_estimator::delay_estimator(size_t max_length, int upsample)
+    : length(max_length), upsample(upsample), n(next_power_of_2(2 * max_length)),
+      forward(n, false), inverse(n, true){
+    if (upsample < 1 || !is_power_of_2(upsample))
+        throw invalid_argument("delay_estimator: upsample must be a power of 2");
+}
+
+
+/* Estimate Delay & Phase */
+delay_estimate delay_estimator::estimate(const complex<float>* a, const complex<float>* b, size_t len) const {
+
+    if (len > length)
+        len = length;
+
+    /* Zero Padded Spectra */
+    vector<complex<float>> fa(n), fb(n);
+    double energy_a = 0, energy_b = 0;
+    for (size_t i = 0; i < len; i++){
+        fa[i] = a[i];
+        fb[i] = b[i];
+        energy_a += norm(a[i]);
+        energy_b += norm(b[i]);
+    }
+    forward.execute(fa.data());
+    forward.execute(fb.data());
+
+    /* Cross Spectrum & Integer Lag Correlation */
+    vector<complex<float>> x(n), r(n);
+    for (size_t k = 0; k < n; k++)
+        x[k] = r[k] = cmul(fb[k], conj(fa[k]));
+    inverse.execute(r.data());
+
+    size_t peak = 0;
+    float peak_power = -1;
+    for (size_t k = 0; k < n; k++){
+        float p = norm(r[k]);
+        if (p > peak_power){
+            peak_power = p;
+            peak = k;
+        }
+    }
+    double lag = (peak >= n / 2) ? (double)peak - n : (double)peak;
+
+    /* Fine Grid Within a Sample of the Peak - Direct Inverse DFT of the Cross Spectrum */
+    const int num_fine = 2 * upsample + 1;
+    vector<complex<double>> fine(num_fine);
+    for (int j = 0; j < num_fine; j++){
+        double tau = lag + (double)(j - upsample) / upsample;
+        complex<double> w = polar(1.0, 2 * M_PI * tau / n);
+        complex<double> phasor = polar(1.0, -M_PI * tau);     // Bin -n/2
+        complex<double> acc = 0;
+        for (size_t k = n / 2; k < n; k++){
+            acc += complex<double>(x[k]) * phasor;
+            phasor *= w;
+        }
+        phasor = 1.0;                                       // Bin 0
+        for (size_t k = 0; k < n / 2; k++){
+            acc += complex<double>(x[k]) * phasor;
+            phasor *= w;
+        }
+        fine[j] = acc;
+    }
+
+    /* Parabolic Refinement on Magnitude */
+    int best = 0;
+    for (int j = 1; j < num_fine; j++)
+        if (norm(fine[j]) > norm(fine[best]))
+            best = j;
+    best = min(max(best, 1), num_fine - 2);
+    complex<double> r0 = fine[best - 1], r1 = fine[best], r2 = fine[best + 1];
+    double y0 = abs(r0), y1 = abs(r1), y2 = abs(r2);
+    double denom = y0 - 2 * y1 + y2;
+    double delta = (denom != 0) ? 0.5 * (y0 - y2) / denom : 0;
+
+    /* Complex Value at the Refined Peak - Quadratic Through the Three Points */
+    complex<double> c = r1 + delta * (r2 - r0) / 2.0 + delta * delta * (r2 - 2.0 * r1 + r0) / 2.0;
+
+    delay_estimate result;
+    result.delay = lag + (best - upsample + delta) / upsample;
+    result.phase = arg(c);
+    result.peak = (energy_a > 0 && energy_b > 0) ? abs(c) / n / sqrt(energy_a * energy_b) : 0;
+    return result;
+}
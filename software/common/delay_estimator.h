@@ -0,0 +1,42 @@
+#ifndef DELAY_ESTIMATOR_H
+#define DELAY_ESTIMATOR_H
+
+#include <vector>
+#include <complex>
+#include <stddef.h>
+#include "fft.h"
+using namespace std;
+
+/* Relative Delay of b Against a */
+class delay_estimate {
+    public:
+        double delay;                                   // Samples, positive when b lags a
+        double phase;                                   // Radians, phase of b relative to a at the peak
+        double peak;                                    // Normalised correlation magnitude, 0 to 1
+};
+
+/* Sub-Sample Delay Estimator
+ * FFT cross-correlation zero padded to twice the window. The integer peak
+ * is refined by evaluating the correlation directly from the cross spectrum
+ * on a 1/upsample sample grid within one sample of it, then by parabolic
+ * interpolation on that grid. The plans are shared and estimate() is const,
+ * so one estimator can serve a thread pool.
+ */
+class delay_estimator {
+    public:
+        delay_estimator(size_t max_length, int upsample);
+
+        /* Windows of length <= max_length, shorter windows are zero padded */
+        delay_estimate estimate(const complex<float>* a, const complex<float>* b, size_t length) const;
+
+        size_t max_length() const { return length; }
+
+    private:
+        size_t length;
+        int upsample;
+        size_t n;                                       // Correlation FFT size
+        fft_plan forward;
+        fft_plan inverse;
+};
+
+#endif
@@ -0,0 +1,58 @@
+#include <math.h>
+#include <stdexcept>
+#include "fft.h"
+
+using namespace std;
+
+bool is_power_of_2(size_t n){
+    return n != 0 && (n & (n - 1)) == 0;
+}
+
+
+/* Plan FFT */
+fft_plan::fft_plan(size_t size, bool inverse) : n(size), bit_reverse(size), twiddles(size / 2){
+
+    if (!is_power_of_2(n))
+        throw invalid_argument("FFT size must be a power of 2");
+
+    /* Bit Reversal Permutation */
+    int bits = 0;
+    while (((size_t)1 << bits) < n)
+        bits++;
+    for (size_t i = 0; i < n; i++){
+        size_t r = 0;
+        for (int b = 0; b < bits; b++)
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        bit_reverse[i] = r;
+    }
+
+    /* Twiddle Factors - Computed in Double for Accuracy */
+    const double sign = inverse ? 1.0 : -1.0;
+    for (size_t k = 0; k < n / 2; k++){
+        double w = sign * 2 * M_PI * k / n;
+        twiddles[k] = complex<float>((float)cos(w), (float)sin(w));
+    }
+}
+
+
+/* Iterative Decimation in Time FFT */
+void fft_plan::execute(complex<float>* data) const {
+
+    /* Reorder Input */
+    for (size_t i = 0; i < n; i++)
+        if (bit_reverse[i] > i)
+            swap(data[i], data[bit_reverse[i]]);
+
+    /* Butterflies */
+    for (size_t len = 2; len <= n; len <<= 1){
+        size_t half = len / 2;
+        size_t stride = n / len;
+        for (size_t i = 0; i < n; i += len){
+            for (size_t j = 0; j < half; j++){
+                complex<float> t = cmul(twiddles[j * stride], data[i + j + half]);
+                data[i + j + half] = data[i + j] - t;
+                data[i + j] += t;
+            }
+        }
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <vector>
+#include <complex>
+#include <stddef.h>
+using namespace std;
+
+/* Preplanned Radix-2 FFT
+ * Twiddles and bit reversal table are computed once, execute() is const
+ * so a single plan can be shared between worker threads.
+ */
+class fft_plan {
+    public:
+        fft_plan(size_t size, bool inverse);            // size must be a power of 2
+        void execute(complex<float>* data) const;       // In place, unnormalised
+        size_t size() const { return n; }
+
+    private:
+        size_t n;
+        vector<size_t> bit_reverse;
+        vector<complex<float>> twiddles;
+};
+
+/* Complex Multiply - Avoids the NaN/Inf Handling of operator* */
+static inline complex<float> cmul(complex<float> a, complex<float> b){
+    return complex<float>(a.real() * b.real() - a.imag() * b.imag(),
+                          a.real() * b.imag() + a.imag() * b.real());
+}
+
+/* Check for Power of 2 */
+bool is_power_of_2(size_t n);
+
+#endif
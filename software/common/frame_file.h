@@ -0,0 +1,33 @@
+#ifndef FRAME_FILE_H
+#define FRAME_FILE_H
+
+#include <ctime>
+#include <stdint.h>
+
+/* Multi-Device Frame Container
+ * frame_file_header, then per frame: frame_header, num_devices uint64_t
+ * sample indices (one per device, first sample of the frame) and
+ * frame_length samples interleaved across devices - dev0 I/Q, dev1 I/Q ...
+ * as int16_t I12. Devices missing from a frame are zero filled.
+ */
+#define FRAME_FILE_MAGIC 0x46535050                     // "PPSF"
+#define FRAME_FILE_VERSION 1
+#define FRAME_MAX_DEVICES 32                            // Width of valid_mask
+
+class frame_file_header {
+    public:
+        uint32_t magic;
+        uint32_t version;
+        uint32_t num_devices;
+        uint32_t frame_length;                          // Samples per device per frame
+        double sample_rate;
+};
+
+class frame_header {
+    public:
+        time_t gps_second;                              // Second of the PPS event the offset is counted from
+        uint32_t offset;                                // Samples after the PPS event
+        uint32_t valid_mask;                            // Bit per device with data in this frame
+};
+
+#endif
@@ -0,0 +1,185 @@
+#ifndef GPSDO_LOG_H
+#define GPSDO_LOG_H
+
+#include <cstring>
+#include <stdint.h>
+#include <stddef.h>
+using namespace std;
+
+/* USB Logs from the GPSDO - packet_log (gpsdo/firmware) Carrying one of the packets.h Payloads */
+#define GPSDO_LOG_SIZE 128
+#define GPSDO_MESSAGE_POS 0x01
+#define GPSDO_MESSAGE_TIMING 0x02
+#define GPSDO_MESSAGE_SIGNAL 0x03
+#define GPSDO_MESSAGE_PLL 0x04
+#define GPSDO_MESSAGE_FREQ 0x05
+#define GPSDO_MESSAGE_HOLDOVER 0x06
+#define GPSDO_MESSAGE_CONFIG 0x07
+
+/* TIM-TP Flags */
+#define GPSDO_TIMING_UTC (1 << 0)                       // tow_ms & week are UTC, not GPS time
+#define GPSDO_TIMING_QERR_INVALID (1 << 4)
+#define GPSDO_TIMING_OUTPUT_PPS (1 << 7)                // P2 is the GPSDO's own PPS, so qErr is marked invalid
+
+class __attribute__((packed)) gpsdo_position_log {
+    public:
+        uint8_t type;
+        uint32_t timestamp;                             // systime_t, 0.1 ms ticks
+        int32_t lon, lat;                               // 1e-7 degrees
+        int32_t height;                                 // mm
+        uint8_t num_sat;
+        uint8_t fix_type;
+        uint16_t year;
+        uint8_t month, day, hour, minute, second;
+        bool pll_lock;
+};
+
+/* TIM-TP - Sent Ahead of the Pulse it Describes */
+class __attribute__((packed)) gpsdo_timing_log {
+    public:
+        uint8_t type;
+        uint32_t timestamp;                             // systime_t, 0.1 ms ticks
+        uint32_t tow_ms;                                // Time of week of the pulse
+        uint32_t tow_sub_ms;                            // 2^-32 ms
+        int32_t q_err;                                  // Quantisation error of the pulse (ps)
+        uint16_t week;
+        uint8_t flags;
+        uint8_t ref_info;
+};
+
+/* NAV-SAT Tally & the Last MON-HW */
+class __attribute__((packed)) gpsdo_signal_log {
+    public:
+        uint8_t type;
+        uint32_t timestamp;                             // systime_t, 0.1 ms ticks
+        uint8_t num_tracked;
+        uint8_t num_used;
+        uint8_t cno_mean, cno_max;                      // dBHz
+        uint16_t noise_per_ms;
+        uint16_t agc_cnt;
+        uint8_t ant_status;                             // 0 init, 1 unknown, 2 OK, 3 short, 4 open
+        uint8_t jam_state;                              // 0 unknown, 1 OK, 2 warning, 3 critical
+        uint8_t jam_ind;
+};
+
+/* CS2100 Lock Transition */
+class __attribute__((packed)) gpsdo_pll_log {
+    public:
+        uint8_t type;
+        uint32_t timestamp;                             // systime_t, 0.1 ms ticks
+        bool locked;
+        uint32_t event_time;                            // systime_t of the transition
+        uint32_t unlocks;
+        uint32_t i2c_errors;
+        uint8_t source;                                 // 0 I2C poll, 1 AUX_OUT edge
+};
+
+/* Reference Counted Between PPS Edges */
+#define GPSDO_FREQ_NO_PPS (1 << 0)
+#define GPSDO_FREQ_BAD_PPS (1 << 1)
+#define GPSDO_FREQ_NO_REF (1 << 2)
+#define GPSDO_FREQ_WINDOW 64                            // FREQ_MONITOR_WINDOW
+
+class __attribute__((packed)) gpsdo_freq_log {
+    public:
+        uint8_t type;
+        uint32_t timestamp;                             // systime_t, 0.1 ms ticks
+        uint32_t ref_counts;                            // Counts in the last second
+        int32_t freq_err_ppb;                           // Last second
+        int32_t freq_err_avg_ppt;                       // Over the window
+        uint32_t jitter_ps;                             // RMS of the seconds in the window
+        uint8_t window;                                 // Seconds
+        uint8_t flags;
+};
+
+/* Output PPS State & Quality */
+#define GPSDO_HOLDOVER_STARTUP 0
+#define GPSDO_HOLDOVER_DISCIPLINED 1
+#define GPSDO_HOLDOVER_HOLDOVER 2
+#define GPSDO_HOLDOVER_RECOVERING 3
+
+class __attribute__((packed)) gpsdo_holdover_log {
+    public:
+        uint8_t type;
+        uint32_t timestamp;                             // systime_t, 0.1 ms ticks
+        uint8_t state;
+        uint32_t state_secs;
+        int32_t drift_ppt;                              // Reference against GPS, when last measured
+        int32_t phase_err_ns;                           // GPS PPS - output PPS
+        uint32_t est_err_ns;                            // Estimated output PPS error
+};
+
+/* Runtime Settings - on Each Host Command & When They Take Effect */
+#define GPSDO_CONFIG_PENDING (1 << 0)                   // Waiting for the next output PPS
+#define GPSDO_CONFIG_REJECTED (1 << 1)                  // Last command refused
+#define GPSDO_CONFIG_NOT_SAVED (1 << 2)                 // Lost on reset
+
+class __attribute__((packed)) gpsdo_config_log {
+    public:
+        uint8_t type;
+        uint32_t timestamp;                             // systime_t, 0.1 ms ticks
+        uint32_t out_freq_hz;
+        uint32_t pps_width_us;
+        int16_t cable_delay_ns;
+        uint8_t pps_inverted;
+        int32_t ratio_err_ppt;                          // CS2100 ratio against out_freq_hz
+        uint8_t command;                                // Last host command, 0 for none
+        uint8_t flags;
+};
+
+/* Type of the Log at data, 0 if Implausible - the Stream Carries no Sync Word, but the Firmware Zeroes the Padding */
+inline uint8_t gpsdo_log_type(const uint8_t* data){
+    size_t used;
+    if (data[0] == GPSDO_MESSAGE_POS){
+        gpsdo_position_log log;
+        memcpy(&log, data, sizeof(log));
+        if (log.fix_type > 5 || log.month < 1 || log.month > 12 || log.day < 1 || log.day > 31 ||
+            log.hour >= 24 || log.minute >= 60 || log.second > 60)
+            return 0;
+        used = sizeof(log);
+    } else if (data[0] == GPSDO_MESSAGE_TIMING){
+        gpsdo_timing_log log;
+        memcpy(&log, data, sizeof(log));
+        if (log.tow_ms >= 604800000u || log.week < 1024)
+            return 0;
+        used = sizeof(log);
+    } else if (data[0] == GPSDO_MESSAGE_SIGNAL){
+        gpsdo_signal_log log;
+        memcpy(&log, data, sizeof(log));
+        if (log.num_used > log.num_tracked || log.cno_mean > log.cno_max || log.ant_status > 4 || log.jam_state > 3)
+            return 0;
+        used = sizeof(log);
+    } else if (data[0] == GPSDO_MESSAGE_PLL){
+        gpsdo_pll_log log;
+        memcpy(&log, data, sizeof(log));
+        if (data[5] > 1 || log.source > 1)
+            return 0;
+        used = sizeof(log);
+    } else if (data[0] == GPSDO_MESSAGE_FREQ){
+        gpsdo_freq_log log;
+        memcpy(&log, data, sizeof(log));
+        if (log.window > GPSDO_FREQ_WINDOW || log.flags > 7)
+            return 0;
+        used = sizeof(log);
+    } else if (data[0] == GPSDO_MESSAGE_HOLDOVER){
+        gpsdo_holdover_log log;
+        memcpy(&log, data, sizeof(log));
+        if (log.state > GPSDO_HOLDOVER_RECOVERING)
+            return 0;
+        used = sizeof(log);
+    } else if (data[0] == GPSDO_MESSAGE_CONFIG){
+        gpsdo_config_log log;
+        memcpy(&log, data, sizeof(log));
+        if (log.pps_inverted > 1 || log.command > 2 || log.flags > 7)
+            return 0;
+        used = sizeof(log);
+    } else {
+        return 0;
+    }
+    for (size_t i = used; i < GPSDO_LOG_SIZE; i++)
+        if (data[i])
+            return 0;
+    return data[0];
+}
+
+#endif
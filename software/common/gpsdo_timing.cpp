@@ -0,0 +1,106 @@
+#include <vector>
+#include <sstream>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include "gpsdo_log.h"
+#include "gpsdo_timing.h"
+
+using namespace std;
+
+/* Unix Second of the GPS Epoch, 1980-01-06 */
+#define GPS_EPOCH 315964800
+
+/* Pulses Kept for Lookup */
+#define GPSDO_TIMING_HISTORY 64
+
+
+gpsdo_timing::gpsdo_timing(const string& tty) : stopping(false), num_pulses(0){
+    fd = open(tty.c_str(), O_RDONLY | O_NOCTTY);
+    if (fd < 0)
+        return;
+    termios options;
+    if (tcgetattr(fd, &options) == 0){
+        cfmakeraw(&options);
+        tcsetattr(fd, TCSANOW, &options);
+    }
+    reader = thread(&gpsdo_timing::run, this);
+}
+
+gpsdo_timing::~gpsdo_timing(){
+    stopping = true;
+    if (reader.joinable())
+        reader.join();
+    if (fd >= 0)
+        close(fd);
+}
+
+
+bool gpsdo_timing::q_err(time_t unix_second, double& seconds){
+    lock_guard<mutex> lock(timing_mutex);
+    map<time_t, double>::const_iterator it = recent.find(unix_second);
+    if (it == recent.end())
+        return false;
+    seconds = it->second;
+    return true;
+}
+
+
+/* Follow the Logs - Polls so stopping is Seen Within 200 ms */
+void gpsdo_timing::run(){
+    vector<uint8_t> buffer;
+    while (!stopping){
+        pollfd pfd = { fd, POLLIN, 0 };
+        int ready = poll(&pfd, 1, 200);
+        if (ready < 0)
+            break;
+        if (ready == 0)
+            continue;
+        uint8_t data[GPSDO_LOG_SIZE];
+        ssize_t n = read(fd, data, sizeof(data));
+        if (n <= 0)
+            break;
+        buffer.insert(buffer.end(), data, data + n);
+
+        /* Slide Until a Log Parses */
+        while (buffer.size() >= GPSDO_LOG_SIZE){
+            uint8_t type = gpsdo_log_type(buffer.data());
+            if (type == 0){
+                buffer.erase(buffer.begin());
+                continue;
+            }
+            gpsdo_timing_log log;
+            memcpy(&log, buffer.data(), sizeof(log));
+            buffer.erase(buffer.begin(), buffer.begin() + GPSDO_LOG_SIZE);
+            if (type != GPSDO_MESSAGE_TIMING || (log.flags & GPSDO_TIMING_QERR_INVALID))
+                continue;
+
+            /* Second of the Coming Pulse */
+            time_t second = GPS_EPOCH + (time_t)log.week * 604800 + (log.tow_ms + 500) / 1000;
+            if (!(log.flags & GPSDO_TIMING_UTC))
+                second -= GPSDO_LEAP_SECONDS;
+
+            lock_guard<mutex> lock(timing_mutex);
+            recent[second] = log.q_err * 1e-12;
+            if (recent.size() > GPSDO_TIMING_HISTORY)
+                recent.erase(recent.begin());
+            num_pulses++;
+        }
+    }
+}
+
+
+double corrected_pps_index(uint64_t pps_index, double sample_rate, double q_err){
+    return pps_index + q_err * sample_rate;
+}
+
+
+string pps_sidecar(uint64_t pps_index, double sample_rate, double q_err){
+    ostringstream s;
+    s.precision(17);
+    s << "pps_index " << pps_index << "\n";
+    s << "q_err " << q_err << "\n";
+    s << "corrected_pps_index " << corrected_pps_index(pps_index, sample_rate, q_err) << "\n";
+    return s.str();
+}
@@ -0,0 +1,50 @@
+#ifndef GPSDO_TIMING_H
+#define GPSDO_TIMING_H
+
+#include <map>
+#include <ctime>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <stdint.h>
+using namespace std;
+
+/* GPS - UTC Offset, Used Only for Pulses Reported on the GPS Timebase */
+#define GPSDO_LEAP_SECONDS 18
+
+/* Per Pulse Quantisation Error from a GPSDO
+ * The GPSDO forwards the receiver's TIM-TP message ahead of each pulse. A
+ * reader thread follows its USB logs and keeps the qErr of recent pulses by
+ * the Unix second they mark, so it is in hand by the time a capture of that
+ * pulse is written.
+ */
+class gpsdo_timing {
+    public:
+        gpsdo_timing(const string& tty);
+        ~gpsdo_timing();
+
+        bool opened() const { return fd >= 0; }
+        bool q_err(time_t unix_second, double& seconds);    // False if not reported or flagged invalid
+        uint64_t pulses() const { return num_pulses; }
+
+    private:
+        void run();
+
+        int fd;
+        mutex timing_mutex;
+        map<time_t, double> recent;
+        atomic<bool> stopping;
+        atomic<uint64_t> num_pulses;
+        thread reader;
+};
+
+/* PPS Sample Index Corrected for qErr - the Pulse Left the Receiver q_err Early */
+double corrected_pps_index(uint64_t pps_index, double sample_rate, double q_err);
+
+/* <unix>.pps Sidecar of a .bin Capture - "pps_index", "q_err" (s) and
+ * "corrected_pps_index" Lines, Each a Name then its Value
+ */
+string pps_sidecar(uint64_t pps_index, double sample_rate, double q_err);
+
+#endif
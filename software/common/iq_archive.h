@@ -0,0 +1,34 @@
+#ifndef IQ_ARCHIVE_H
+#define IQ_ARCHIVE_H
+
+#include <stdint.h>
+#include "capture_file.h"
+
+/* Compressed Capture Archive
+ * iq_archive_header, then one iq_codec block per capture (one PPS each),
+ * then num_blocks iq_archive_entry records at index_offset. The index is
+ * written last, so any capture can be found and decoded on its own.
+ */
+#define IQ_ARCHIVE_MAGIC 0x5A425149                     // "IQBZ"
+#define IQ_ARCHIVE_VERSION 1
+#define IQ_ARCHIVE_NAME 48
+
+class iq_archive_header {
+    public:
+        uint32_t magic;
+        uint32_t version;
+        uint64_t num_blocks;
+        uint64_t index_offset;
+};
+
+class iq_archive_entry {
+    public:
+        char name[IQ_ARCHIVE_NAME];                     // Original file name
+        file_header header;
+        uint64_t num_samples;
+        uint64_t offset;                                // Compressed block
+        uint32_t size;
+        uint32_t checksum;                              // iq_checksum of the samples
+};
+
+#endif
@@ -0,0 +1,277 @@
+#include <cstdlib>
+#include "string.h"
+#include "iq_codec.h"
+
+using namespace std;
+
+#define MAX_ORDER 3
+#define VERBATIM_K 31                                   // Sub-block stored as raw 16-bit values
+#define ESCAPE_ZEROS 24                                 // Unary run that marks a raw residual
+#define ESCAPE_BITS 20                                  // Order 3 residuals of int16 fit in 19 bits + sign
+
+
+/*  BIT I/O  */
+
+/* LSB First Bit Writer - into a Buffer Sized for the Worst Case, 32 Bits per Store */
+class bit_writer {
+    public:
+        bit_writer(uint8_t* out) : start(out), p(out), acc(0), bits(0) {}
+
+        inline void put(uint32_t value, int n){         // n <= 32
+            acc |= (uint64_t)value << bits;
+            bits += n;
+            if (bits >= 32){
+                uint32_t word = (uint32_t)acc;
+                memcpy(p, &word, 4);                    // Little endian hosts
+                p += 4;
+                acc >>= 32;
+                bits -= 32;
+            }
+        }
+
+        size_t flush(){
+            while (bits > 0){
+                *p++ = (uint8_t)acc;
+                acc >>= 8;
+                bits -= 8;
+            }
+            bits = 0;
+            return p - start;
+        }
+
+    private:
+        uint8_t* start;
+        uint8_t* p;
+        uint64_t acc;
+        int bits;
+};
+
+
+/* LSB First Bit Reader - Pads Past the End with Zeros, Fails if Padding is Consumed */
+class bit_reader {
+    public:
+        bit_reader(const uint8_t* data, size_t size)
+            : p(data), end(data + size), acc(0), bits(0), consumed(0), available((uint64_t)size * 8) {}
+
+        inline void refill(){
+            if (bits > 56)
+                return;
+            if (end - p >= 8){
+                uint64_t word;
+                memcpy(&word, p, 8);
+                acc |= word << bits;
+                p += (63 - bits) >> 3;
+                bits |= 56;
+                return;
+            }
+            while (bits <= 56){
+                if (p < end)
+                    acc |= (uint64_t)*p++ << bits;
+                bits += 8;
+            }
+        }
+
+        inline uint32_t get(int n){                     // n <= 32
+            refill();
+            uint32_t v = (uint32_t)(acc & ((1ULL << n) - 1));
+            acc >>= n;
+            bits -= n;
+            consumed += n;
+            return v;
+        }
+
+        /* Rice Value with Escape - One Refill Covers the Longest Code (24 + 20 Bits) */
+        inline uint32_t rice(int k){
+            refill();
+            int zeros = acc ? __builtin_ctzll(acc) : 64;
+            if (zeros >= ESCAPE_ZEROS){
+                acc >>= ESCAPE_ZEROS;
+                uint32_t v = (uint32_t)(acc & ((1u << ESCAPE_BITS) - 1));
+                acc >>= ESCAPE_BITS;
+                bits -= ESCAPE_ZEROS + ESCAPE_BITS;
+                consumed += ESCAPE_ZEROS + ESCAPE_BITS;
+                return v;
+            }
+            acc >>= zeros + 1;
+            uint32_t v = ((uint32_t)zeros << k) | (uint32_t)(acc & ((1ULL << k) - 1));
+            acc >>= k;
+            bits -= zeros + 1 + k;
+            consumed += zeros + 1 + k;
+            return v;
+        }
+
+        bool failed() const { return consumed > available; }
+
+    private:
+        const uint8_t* p;
+        const uint8_t* end;
+        uint64_t acc;
+        int bits;
+        uint64_t consumed;
+        uint64_t available;
+};
+
+
+/*  PREDICTION  */
+
+static inline uint32_t zigzag(int32_t e){ return ((uint32_t)e << 1) ^ (uint32_t)(e >> 31); }
+static inline int32_t unzigzag(uint32_t u){ return (int32_t)(u >> 1) ^ -(int32_t)(u & 1); }
+
+/* Fixed Polynomial Predictors - h[0] is the Previous Sample */
+static inline int32_t predict(int order, const int32_t* h){
+    switch (order){
+        case 1: return h[0];
+        case 2: return 2 * h[0] - h[1];
+        case 3: return 3 * h[0] - 3 * h[1] + h[2];
+        default: return 0;
+    }
+}
+
+
+/* Bits for a Rice Coded Sub-block */
+static uint64_t rice_bits(const uint32_t* u, size_t n, int k){
+    uint64_t bits = (uint64_t)n * (k + 1);
+    for (size_t i = 0; i < n; i++){
+        uint32_t q = u[i] >> k;
+        bits += (q < ESCAPE_ZEROS) ? q : ESCAPE_BITS;
+    }
+    return bits;
+}
+
+
+/* Encode One Component (stride 2 through the interleaved block) */
+static void encode_subblock(const int16_t* x, size_t n, int32_t history[MAX_ORDER], bit_writer& w){
+
+    /* Residual Magnitude per Order */
+    uint32_t residual[MAX_ORDER + 1][IQ_CODEC_SUBBLOCK];
+    uint64_t cost[MAX_ORDER + 1] = { 0, 0, 0, 0 };
+    int32_t h[MAX_ORDER];
+    memcpy(h, history, sizeof(h));
+    for (size_t i = 0; i < n; i++){
+        int32_t s = x[2 * i];
+        for (int order = 0; order <= MAX_ORDER; order++){
+            uint32_t u = zigzag(s - predict(order, h));
+            residual[order][i] = u;
+            cost[order] += u;
+        }
+        h[2] = h[1];
+        h[1] = h[0];
+        h[0] = s;
+    }
+    int order = 0;
+    for (int o = 1; o <= MAX_ORDER; o++)
+        if (cost[o] < cost[order])
+            order = o;
+
+    /* Rice Parameter from the Mean, Refined Either Side */
+    uint64_t mean = cost[order] / (n ? n : 1);
+    int k = 0;
+    while (k < 20 && (2ULL << k) <= mean)
+        k++;
+    int best_k = VERBATIM_K;
+    uint64_t best_bits = (uint64_t)n * 16;
+    for (int c = max(0, k - 1); c <= min(20, k + 1); c++){
+        uint64_t bits = rice_bits(residual[order], n, c);
+        if (bits < best_bits){
+            best_bits = bits;
+            best_k = c;
+        }
+    }
+
+    w.put(order, 2);
+    w.put(best_k, 5);
+    if (best_k == VERBATIM_K){
+        for (size_t i = 0; i < n; i++)
+            w.put((uint16_t)x[2 * i], 16);
+    }
+    else {
+        const uint32_t mask = (1u << best_k) - 1;
+        for (size_t i = 0; i < n; i++){
+            uint32_t u = residual[order][i];
+            uint32_t q = u >> best_k;
+            if (q < ESCAPE_ZEROS && q + 1 + best_k <= 32)
+                w.put(((u & mask) << (q + 1)) | (1u << q), q + 1 + best_k);
+            else if (q < ESCAPE_ZEROS){
+                w.put(1u << q, q + 1);
+                w.put(u & mask, best_k);
+            }
+            else {
+                w.put(0, ESCAPE_ZEROS);
+                w.put(u, ESCAPE_BITS);
+            }
+        }
+    }
+    memcpy(history, h, sizeof(h));
+}
+
+
+static bool decode_subblock(bit_reader& r, int16_t* x, size_t n, int32_t history[MAX_ORDER]){
+
+    int order = r.get(2);
+    int k = r.get(5);
+    int32_t* h = history;
+    if (k == VERBATIM_K){
+        for (size_t i = 0; i < n; i++){
+            int32_t s = (int16_t)r.get(16);
+            x[2 * i] = s;
+            h[2] = h[1];
+            h[1] = h[0];
+            h[0] = s;
+        }
+        return !r.failed();
+    }
+    if (k > 20)
+        return false;
+
+    for (size_t i = 0; i < n; i++){
+        uint32_t u = r.rice(k);
+        int32_t s = predict(order, h) + unzigzag(u);
+        x[2 * i] = (int16_t)s;
+        h[2] = h[1];
+        h[1] = h[0];
+        h[0] = s;
+    }
+    return !r.failed();
+}
+
+
+/*  BLOCKS  */
+
+void iq_compress(const int16_t* samples, size_t num_samples, vector<uint8_t>& out){
+
+    /* Worst Case is Every Sub-block Verbatim - 16 Bits per Value + 7 Bit Headers */
+    size_t used = out.size();
+    size_t num_subblocks = (num_samples + IQ_CODEC_SUBBLOCK - 1) / IQ_CODEC_SUBBLOCK;
+    out.resize(used + num_samples * 4 + num_subblocks * 2 + 8);
+    bit_writer w(out.data() + used);
+    int32_t history_i[MAX_ORDER] = { 0, 0, 0 }, history_q[MAX_ORDER] = { 0, 0, 0 };
+    for (size_t start = 0; start < num_samples; start += IQ_CODEC_SUBBLOCK){
+        size_t n = min((size_t)IQ_CODEC_SUBBLOCK, num_samples - start);
+        encode_subblock(samples + start * 2, n, history_i, w);
+        encode_subblock(samples + start * 2 + 1, n, history_q, w);
+    }
+    out.resize(used + w.flush());
+}
+
+
+bool iq_decompress(const uint8_t* data, size_t size, int16_t* samples, size_t num_samples){
+    bit_reader r(data, size);
+    int32_t history_i[MAX_ORDER] = { 0, 0, 0 }, history_q[MAX_ORDER] = { 0, 0, 0 };
+    for (size_t start = 0; start < num_samples; start += IQ_CODEC_SUBBLOCK){
+        size_t n = min((size_t)IQ_CODEC_SUBBLOCK, num_samples - start);
+        if (!decode_subblock(r, samples + start * 2, n, history_i) ||
+            !decode_subblock(r, samples + start * 2 + 1, n, history_q))
+            return false;
+    }
+    return true;
+}
+
+
+/* FNV-1a over I/Q Pairs */
+uint32_t iq_checksum(const int16_t* samples, size_t num_samples){
+    uint32_t hash = 2166136261u;
+    const uint32_t* words = (const uint32_t*)samples;
+    for (size_t i = 0; i < num_samples; i++)
+        hash = (hash ^ words[i]) * 16777619u;
+    return hash;
+}
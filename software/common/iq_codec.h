@@ -0,0 +1,28 @@
+#ifndef IQ_CODEC_H
+#define IQ_CODEC_H
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+using namespace std;
+
+/* Lossless I/Q Codec
+ * I and Q are coded as separate streams in sub-blocks of IQ_CODEC_SUBBLOCK
+ * samples. Each sub-block picks the fixed polynomial predictor (order 0 to 3)
+ * with the smallest residual and the Rice parameter that codes it in the
+ * fewest bits, falling back to verbatim 16-bit values. Blocks are
+ * independent, so they can be coded on any number of threads and decoded
+ * from any block.
+ */
+#define IQ_CODEC_SUBBLOCK 1024
+
+/* Compress num_samples Interleaved I/Q Samples, Appending to out */
+void iq_compress(const int16_t* samples, size_t num_samples, vector<uint8_t>& out);
+
+/* Decompress a Block of num_samples I/Q Samples - false if Corrupt */
+bool iq_decompress(const uint8_t* data, size_t size, int16_t* samples, size_t num_samples);
+
+/* Block Checksum over the Raw Samples */
+uint32_t iq_checksum(const int16_t* samples, size_t num_samples);
+
+#endif
@@ -0,0 +1,428 @@
+#include <math.h>
+#include <string.h>
+#include "iq_convert.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define IQ_HAVE_X86
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__)
+#define IQ_HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace std;
+
+/* Kernel Table */
+struct iq_kernels {
+    void (*i16_to_cf32)(const int16_t*, complex<float>*, size_t, float);
+    void (*cf32_to_i12)(const complex<float>*, int16_t*, size_t, float);
+    void (*packed12_to_cf32)(const uint8_t*, complex<float>*, size_t, float);
+    void (*cf32_to_packed12)(const complex<float>*, uint8_t*, size_t, float);
+};
+
+
+/*  SCALAR KERNELS  */
+
+/* Saturate to 12 bits & Round to Nearest - NaN maps to I12_MIN, as the SIMD paths do */
+static inline int16_t saturate_i12(float x){
+    x = (x > (float)I12_MIN) ? x : (float)I12_MIN;
+    x = (x < (float)I12_MAX) ? x : (float)I12_MAX;
+    return (int16_t)lrintf(x);
+}
+
+/* Sign Extend a 12-bit Value */
+static inline int16_t sign_extend_12(uint16_t x){
+    return (int16_t)(x << 4) >> 4;
+}
+
+void iq_i16_to_cf32_scalar(const int16_t* in, complex<float>* out, size_t num_samples, float scale){
+    float* o = (float*)out;
+    for (size_t i = 0; i < 2 * num_samples; i++)
+        o[i] = (float)in[i] * scale;
+}
+
+void iq_cf32_to_i12_scalar(const complex<float>* in, int16_t* out, size_t num_samples, float scale){
+    const float* f = (const float*)in;
+    for (size_t i = 0; i < 2 * num_samples; i++)
+        out[i] = saturate_i12(f[i] * scale);
+}
+
+void iq_packed12_to_cf32_scalar(const uint8_t* in, complex<float>* out, size_t num_samples, float scale){
+    for (size_t i = 0; i < num_samples; i++){
+        const uint8_t* p = &in[PACKED12_BYTES_PER_SAMPLE * i];
+        int16_t I = sign_extend_12(p[0] | ((p[1] & 0x0F) << 8));
+        int16_t Q = sign_extend_12((p[1] >> 4) | (p[2] << 4));
+        out[i] = complex<float>((float)I * scale, (float)Q * scale);
+    }
+}
+
+void iq_cf32_to_packed12_scalar(const complex<float>* in, uint8_t* out, size_t num_samples, float scale){
+    for (size_t i = 0; i < num_samples; i++){
+        uint16_t I = (uint16_t)saturate_i12(in[i].real() * scale);
+        uint16_t Q = (uint16_t)saturate_i12(in[i].imag() * scale);
+        uint8_t* p = &out[PACKED12_BYTES_PER_SAMPLE * i];
+        p[0] = I & 0xFF;
+        p[1] = ((I >> 8) & 0x0F) | ((Q & 0x0F) << 4);
+        p[2] = (Q >> 4) & 0xFF;
+    }
+}
+
+
+/*  SSE4.1 KERNELS  */
+
+#ifdef IQ_HAVE_X86
+
+/* Shuffle 4 packed samples (12 bytes) into 8 words: I = bytes(3s,3s+1), Q = bytes(3s+1,3s+2) */
+#define PACKED12_UNPACK_MASK 11, 10, 10, 9, 8, 7, 7, 6, 5, 4, 4, 3, 2, 1, 1, 0
+
+/* Compact 4 x 24-bit lanes into 12 bytes */
+#define PACKED12_PACK_MASK -1, -1, -1, -1, 14, 13, 12, 10, 9, 8, 6, 5, 4, 2, 1, 0
+
+__attribute__((target("sse4.1")))
+static inline __m128i unpack12_sse(__m128i v, __m128i mask){
+    __m128i w = _mm_shuffle_epi8(v, mask);
+    w = _mm_blend_epi16(_mm_slli_epi16(w, 4), w, 0xAA);     // I words (even) need their top nibble cleared
+    return _mm_srai_epi16(w, 4);
+}
+
+__attribute__((target("sse4.1")))
+static inline __m128i pack12_sse(__m128i words, __m128i mask){
+    __m128i lo = _mm_and_si128(words, _mm_set1_epi32(0x000FFF));
+    __m128i hi = _mm_and_si128(_mm_srli_epi32(words, 4), _mm_set1_epi32(0xFFF000));
+    return _mm_shuffle_epi8(_mm_or_si128(lo, hi), mask);
+}
+
+__attribute__((target("sse4.1")))
+static inline void store12_sse(uint8_t* p, __m128i v){
+    int32_t tail = _mm_extract_epi32(v, 2);
+    _mm_storel_epi64((__m128i*)p, v);
+    memcpy(p + 8, &tail, 4);
+}
+
+__attribute__((target("sse4.1")))
+static inline void store8_cf32_sse(float* o, __m128i words, __m128 s){
+    __m128 lo = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(words));
+    __m128 hi = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(_mm_srli_si128(words, 8)));
+    _mm_storeu_ps(o, _mm_mul_ps(lo, s));
+    _mm_storeu_ps(o + 4, _mm_mul_ps(hi, s));
+}
+
+__attribute__((target("sse4.1")))
+static inline __m128i load8_i12_sse(const float* f, __m128 s, __m128 lo, __m128 hi){
+    __m128 a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(f), s), lo), hi);
+    __m128 b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(f + 4), s), lo), hi);
+    return _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+}
+
+__attribute__((target("sse4.1")))
+static void i16_to_cf32_sse(const int16_t* in, complex<float>* out, size_t num_samples, float scale){
+    const __m128 s = _mm_set1_ps(scale);
+    float* o = (float*)out;
+    size_t i = 0;
+    for (; i + 4 <= num_samples; i += 4)
+        store8_cf32_sse(&o[2 * i], _mm_loadu_si128((const __m128i*)&in[2 * i]), s);
+    iq_i16_to_cf32_scalar(&in[2 * i], &out[i], num_samples - i, scale);
+}
+
+__attribute__((target("sse4.1")))
+static void cf32_to_i12_sse(const complex<float>* in, int16_t* out, size_t num_samples, float scale){
+    const __m128 s = _mm_set1_ps(scale);
+    const __m128 lo = _mm_set1_ps((float)I12_MIN);
+    const __m128 hi = _mm_set1_ps((float)I12_MAX);
+    const float* f = (const float*)in;
+    size_t i = 0;
+    for (; i + 4 <= num_samples; i += 4)
+        _mm_storeu_si128((__m128i*)&out[2 * i], load8_i12_sse(&f[2 * i], s, lo, hi));
+    iq_cf32_to_i12_scalar(&in[i], &out[2 * i], num_samples - i, scale);
+}
+
+__attribute__((target("sse4.1")))
+static void packed12_to_cf32_sse(const uint8_t* in, complex<float>* out, size_t num_samples, float scale){
+    const __m128 s = _mm_set1_ps(scale);
+    const __m128i mask = _mm_set_epi8(PACKED12_UNPACK_MASK);
+    float* o = (float*)out;
+    size_t i = 0;
+
+    /* Each 16 byte load consumes 12 bytes - stop early to avoid over-reading */
+    for (; i + 6 <= num_samples; i += 4){
+        __m128i v = _mm_loadu_si128((const __m128i*)&in[PACKED12_BYTES_PER_SAMPLE * i]);
+        store8_cf32_sse(&o[2 * i], unpack12_sse(v, mask), s);
+    }
+    iq_packed12_to_cf32_scalar(&in[PACKED12_BYTES_PER_SAMPLE * i], &out[i], num_samples - i, scale);
+}
+
+__attribute__((target("sse4.1")))
+static void cf32_to_packed12_sse(const complex<float>* in, uint8_t* out, size_t num_samples, float scale){
+    const __m128 s = _mm_set1_ps(scale);
+    const __m128 lo = _mm_set1_ps((float)I12_MIN);
+    const __m128 hi = _mm_set1_ps((float)I12_MAX);
+    const __m128i mask = _mm_set_epi8(PACKED12_PACK_MASK);
+    const float* f = (const float*)in;
+    size_t i = 0;
+    for (; i + 4 <= num_samples; i += 4){
+        __m128i words = load8_i12_sse(&f[2 * i], s, lo, hi);
+        store12_sse(&out[PACKED12_BYTES_PER_SAMPLE * i], pack12_sse(words, mask));
+    }
+    iq_cf32_to_packed12_scalar(&in[i], &out[PACKED12_BYTES_PER_SAMPLE * i], num_samples - i, scale);
+}
+
+
+/*  AVX2 KERNELS  */
+
+__attribute__((target("avx2")))
+static inline void store16_cf32_avx2(float* o, __m128i a, __m128i b, __m256 s){
+    _mm256_storeu_ps(o, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(a)), s));
+    _mm256_storeu_ps(o + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(b)), s));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i load16_i12_avx2(const float* f, __m256 s, __m256 lo, __m256 hi){
+    __m256 a = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(f), s), lo), hi);
+    __m256 b = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(f + 8), s), lo), hi);
+    __m256i w = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+    return _mm256_permute4x64_epi64(w, 0xD8);               // Undo per-lane interleave of packs
+}
+
+__attribute__((target("avx2")))
+static void i16_to_cf32_avx2(const int16_t* in, complex<float>* out, size_t num_samples, float scale){
+    const __m256 s = _mm256_set1_ps(scale);
+    float* o = (float*)out;
+    size_t i = 0;
+    for (; i + 8 <= num_samples; i += 8){
+        __m128i a = _mm_loadu_si128((const __m128i*)&in[2 * i]);
+        __m128i b = _mm_loadu_si128((const __m128i*)&in[2 * i + 8]);
+        store16_cf32_avx2(&o[2 * i], a, b, s);
+    }
+    i16_to_cf32_sse(&in[2 * i], &out[i], num_samples - i, scale);
+}
+
+__attribute__((target("avx2")))
+static void cf32_to_i12_avx2(const complex<float>* in, int16_t* out, size_t num_samples, float scale){
+    const __m256 s = _mm256_set1_ps(scale);
+    const __m256 lo = _mm256_set1_ps((float)I12_MIN);
+    const __m256 hi = _mm256_set1_ps((float)I12_MAX);
+    const float* f = (const float*)in;
+    size_t i = 0;
+    for (; i + 8 <= num_samples; i += 8)
+        _mm256_storeu_si256((__m256i*)&out[2 * i], load16_i12_avx2(&f[2 * i], s, lo, hi));
+    cf32_to_i12_sse(&in[i], &out[2 * i], num_samples - i, scale);
+}
+
+__attribute__((target("avx2")))
+static void packed12_to_cf32_avx2(const uint8_t* in, complex<float>* out, size_t num_samples, float scale){
+    const __m256 s = _mm256_set1_ps(scale);
+    const __m256i mask = _mm256_set_epi8(PACKED12_UNPACK_MASK, PACKED12_UNPACK_MASK);
+    float* o = (float*)out;
+    size_t i = 0;
+
+    /* Two 16 byte loads 12 bytes apart - stop early to avoid over-reading */
+    for (; i + 10 <= num_samples; i += 8){
+        const uint8_t* p = &in[PACKED12_BYTES_PER_SAMPLE * i];
+        __m256i v = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)p)),
+            _mm_loadu_si128((const __m128i*)(p + 12)), 1);
+        __m256i w = _mm256_shuffle_epi8(v, mask);
+        w = _mm256_srai_epi16(_mm256_blend_epi16(_mm256_slli_epi16(w, 4), w, 0xAA), 4);
+        store16_cf32_avx2(&o[2 * i], _mm256_castsi256_si128(w), _mm256_extracti128_si256(w, 1), s);
+    }
+    packed12_to_cf32_sse(&in[PACKED12_BYTES_PER_SAMPLE * i], &out[i], num_samples - i, scale);
+}
+
+__attribute__((target("avx2")))
+static void cf32_to_packed12_avx2(const complex<float>* in, uint8_t* out, size_t num_samples, float scale){
+    const __m256 s = _mm256_set1_ps(scale);
+    const __m256 lo = _mm256_set1_ps((float)I12_MIN);
+    const __m256 hi = _mm256_set1_ps((float)I12_MAX);
+    const __m256i mask = _mm256_set_epi8(PACKED12_PACK_MASK, PACKED12_PACK_MASK);
+    const float* f = (const float*)in;
+    size_t i = 0;
+    for (; i + 8 <= num_samples; i += 8){
+        __m256i words = load16_i12_avx2(&f[2 * i], s, lo, hi);
+        __m256i lo12 = _mm256_and_si256(words, _mm256_set1_epi32(0x000FFF));
+        __m256i hi12 = _mm256_and_si256(_mm256_srli_epi32(words, 4), _mm256_set1_epi32(0xFFF000));
+        __m256i v = _mm256_shuffle_epi8(_mm256_or_si256(lo12, hi12), mask);
+        uint8_t* p = &out[PACKED12_BYTES_PER_SAMPLE * i];
+        store12_sse(p, _mm256_castsi256_si128(v));
+        store12_sse(p + 12, _mm256_extracti128_si256(v, 1));
+    }
+    cf32_to_packed12_sse(&in[i], &out[PACKED12_BYTES_PER_SAMPLE * i], num_samples - i, scale);
+}
+
+#endif
+
+
+/*  NEON KERNELS  */
+
+#ifdef IQ_HAVE_NEON
+
+static void i16_to_cf32_neon(const int16_t* in, complex<float>* out, size_t num_samples, float scale){
+    float* o = (float*)out;
+    size_t i = 0;
+    for (; i + 4 <= num_samples; i += 4){
+        int16x8_t v = vld1q_s16(&in[2 * i]);
+        vst1q_f32(&o[2 * i], vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), scale));
+        vst1q_f32(&o[2 * i + 4], vmulq_n_f32(vcvtq_f32_s32(vmovl_high_s16(v)), scale));
+    }
+    iq_i16_to_cf32_scalar(&in[2 * i], &out[i], num_samples - i, scale);
+}
+
+static inline int16x4_t saturate_i12_neon(float32x4_t x, float scale){
+    x = vminq_f32(vmaxq_f32(vmulq_n_f32(x, scale), vdupq_n_f32((float)I12_MIN)), vdupq_n_f32((float)I12_MAX));
+    return vmovn_s32(vcvtnq_s32_f32(x));
+}
+
+static void cf32_to_i12_neon(const complex<float>* in, int16_t* out, size_t num_samples, float scale){
+    const float* f = (const float*)in;
+    size_t i = 0;
+    for (; i + 4 <= num_samples; i += 4){
+        int16x4_t a = saturate_i12_neon(vld1q_f32(&f[2 * i]), scale);
+        int16x4_t b = saturate_i12_neon(vld1q_f32(&f[2 * i + 4]), scale);
+        vst1q_s16(&out[2 * i], vcombine_s16(a, b));
+    }
+    iq_cf32_to_i12_scalar(&in[i], &out[2 * i], num_samples - i, scale);
+}
+
+static void packed12_to_cf32_neon(const uint8_t* in, complex<float>* out, size_t num_samples, float scale){
+    float* o = (float*)out;
+    size_t i = 0;
+    for (; i + 8 <= num_samples; i += 8){
+        uint8x8x3_t b = vld3_u8(&in[PACKED12_BYTES_PER_SAMPLE * i]);
+        uint16x8_t iw = vorrq_u16(vmovl_u8(b.val[0]), vshll_n_u8(vand_u8(b.val[1], vdup_n_u8(0x0F)), 8));
+        uint16x8_t qw = vorrq_u16(vmovl_u8(b.val[1]), vshll_n_u8(b.val[2], 8));
+        int16x8_t I = vshrq_n_s16(vshlq_n_s16(vreinterpretq_s16_u16(iw), 4), 4);
+        int16x8_t Q = vshrq_n_s16(vreinterpretq_s16_u16(qw), 4);
+
+        float32x4x2_t lo, hi;
+        lo.val[0] = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(I))), scale);
+        lo.val[1] = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(Q))), scale);
+        hi.val[0] = vmulq_n_f32(vcvtq_f32_s32(vmovl_high_s16(I)), scale);
+        hi.val[1] = vmulq_n_f32(vcvtq_f32_s32(vmovl_high_s16(Q)), scale);
+        vst2q_f32(&o[2 * i], lo);
+        vst2q_f32(&o[2 * i + 8], hi);
+    }
+    iq_packed12_to_cf32_scalar(&in[PACKED12_BYTES_PER_SAMPLE * i], &out[i], num_samples - i, scale);
+}
+
+static void cf32_to_packed12_neon(const complex<float>* in, uint8_t* out, size_t num_samples, float scale){
+    const float* f = (const float*)in;
+    size_t i = 0;
+    for (; i + 8 <= num_samples; i += 8){
+        float32x4x2_t lo = vld2q_f32(&f[2 * i]);
+        float32x4x2_t hi = vld2q_f32(&f[2 * i + 8]);
+        uint16x8_t I = vreinterpretq_u16_s16(vcombine_s16(saturate_i12_neon(lo.val[0], scale), saturate_i12_neon(hi.val[0], scale)));
+        uint16x8_t Q = vreinterpretq_u16_s16(vcombine_s16(saturate_i12_neon(lo.val[1], scale), saturate_i12_neon(hi.val[1], scale)));
+
+        uint8x8x3_t b;
+        b.val[0] = vmovn_u16(I);
+        b.val[1] = vorr_u8(vand_u8(vshrn_n_u16(I, 8), vdup_n_u8(0x0F)), vshl_n_u8(vmovn_u16(Q), 4));
+        b.val[2] = vshrn_n_u16(Q, 4);
+        vst3_u8(&out[PACKED12_BYTES_PER_SAMPLE * i], b);
+    }
+    iq_cf32_to_packed12_scalar(&in[i], &out[PACKED12_BYTES_PER_SAMPLE * i], num_samples - i, scale);
+}
+
+#endif
+
+
+/*  RUNTIME DISPATCH  */
+
+/* Kernel Table for an Instruction Set */
+static iq_kernels kernels_for(iq_isa isa){
+    switch (isa){
+#ifdef IQ_HAVE_X86
+        case IQ_ISA_AVX2:
+            return { i16_to_cf32_avx2, cf32_to_i12_avx2, packed12_to_cf32_avx2, cf32_to_packed12_avx2 };
+        case IQ_ISA_SSE:
+            return { i16_to_cf32_sse, cf32_to_i12_sse, packed12_to_cf32_sse, cf32_to_packed12_sse };
+#endif
+#ifdef IQ_HAVE_NEON
+        case IQ_ISA_NEON:
+            return { i16_to_cf32_neon, cf32_to_i12_neon, packed12_to_cf32_neon, cf32_to_packed12_neon };
+#endif
+        default:
+            return { iq_i16_to_cf32_scalar, iq_cf32_to_i12_scalar, iq_packed12_to_cf32_scalar, iq_cf32_to_packed12_scalar };
+    }
+}
+
+/* Check CPU Support */
+bool iq_isa_supported(iq_isa isa){
+    switch (isa){
+        case IQ_ISA_SCALAR:
+            return true;
+#ifdef IQ_HAVE_X86
+        case IQ_ISA_SSE:
+            return __builtin_cpu_supports("sse4.1");
+        case IQ_ISA_AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+#ifdef IQ_HAVE_NEON
+        case IQ_ISA_NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+/* Best Supported Instruction Set */
+static iq_isa best_isa(void){
+    const iq_isa preference[] = { IQ_ISA_AVX2, IQ_ISA_NEON, IQ_ISA_SSE };
+    for (iq_isa isa : preference)
+        if (iq_isa_supported(isa))
+            return isa;
+    return IQ_ISA_SCALAR;
+}
+
+/* Active Selection - Resolved on First Use */
+static iq_isa& active_isa(void){
+    static iq_isa isa = best_isa();
+    return isa;
+}
+
+static iq_kernels& active_kernels(void){
+    static iq_kernels kernels = kernels_for(active_isa());
+    return kernels;
+}
+
+iq_isa iq_get_isa(void){
+    return active_isa();
+}
+
+/* Override Selection - Not Thread Safe, Call Before Starting Workers */
+int iq_set_isa(iq_isa isa){
+    if (!iq_isa_supported(isa))
+        return -1;
+    active_isa() = isa;
+    active_kernels() = kernels_for(isa);
+    return 0;
+}
+
+const char* iq_isa_name(iq_isa isa){
+    switch (isa){
+        case IQ_ISA_SSE:    return "SSE4.1";
+        case IQ_ISA_AVX2:   return "AVX2";
+        case IQ_ISA_NEON:   return "NEON";
+        default:            return "Scalar";
+    }
+}
+
+
+/*  PUBLIC KERNELS  */
+
+void iq_i16_to_cf32(const int16_t* in, complex<float>* out, size_t num_samples, float scale){
+    active_kernels().i16_to_cf32(in, out, num_samples, scale);
+}
+
+void iq_cf32_to_i12(const complex<float>* in, int16_t* out, size_t num_samples, float scale){
+    active_kernels().cf32_to_i12(in, out, num_samples, scale);
+}
+
+void iq_packed12_to_cf32(const uint8_t* in, complex<float>* out, size_t num_samples, float scale){
+    active_kernels().packed12_to_cf32(in, out, num_samples, scale);
+}
+
+void iq_cf32_to_packed12(const complex<float>* in, uint8_t* out, size_t num_samples, float scale){
+    active_kernels().cf32_to_packed12(in, out, num_samples, scale);
+}
@@ -0,0 +1,50 @@
+#ifndef IQ_CONVERT_H
+#define IQ_CONVERT_H
+
+#include <complex>
+#include <stddef.h>
+#include <stdint.h>
+using namespace std;
+
+/* Sample Scale Factors */
+#define I12_SCALE (1.0f / 2048.0f)                      // I12 sample (int16_t) -> +/-1.0
+#define I16_SCALE (1.0f / 32768.0f)                     // I16 sample (int16_t) -> +/-1.0
+#define I12_MAX 2047                                    // Largest 12-bit sample
+#define I12_MIN (-2048)                                 // Smallest 12-bit sample
+
+/* Packed 12-bit Format - 3 bytes per I/Q pair, as sent over the FT601 link */
+#define PACKED12_BYTES_PER_SAMPLE 3
+
+/* Instruction Sets */
+enum iq_isa {
+    IQ_ISA_SCALAR = 0,
+    IQ_ISA_SSE,                                         // SSE4.1
+    IQ_ISA_AVX2,
+    IQ_ISA_NEON
+};
+
+/* Conversion Kernels - num_samples counts complex (I/Q) samples
+ *
+ * iq_i16_to_cf32       Interleaved int16_t I/Q -> complex<float>, out = in * scale
+ * iq_cf32_to_i12       complex<float> -> interleaved I12, out = sat(round(in * scale))
+ * iq_packed12_to_cf32  Packed 12-bit I/Q -> complex<float>, out = in * scale
+ * iq_cf32_to_packed12  complex<float> -> packed 12-bit I/Q, out = sat(round(in * scale))
+ */
+void iq_i16_to_cf32(const int16_t* in, complex<float>* out, size_t num_samples, float scale);
+void iq_cf32_to_i12(const complex<float>* in, int16_t* out, size_t num_samples, float scale);
+void iq_packed12_to_cf32(const uint8_t* in, complex<float>* out, size_t num_samples, float scale);
+void iq_cf32_to_packed12(const complex<float>* in, uint8_t* out, size_t num_samples, float scale);
+
+/* Scalar Reference Kernels */
+void iq_i16_to_cf32_scalar(const int16_t* in, complex<float>* out, size_t num_samples, float scale);
+void iq_cf32_to_i12_scalar(const complex<float>* in, int16_t* out, size_t num_samples, float scale);
+void iq_packed12_to_cf32_scalar(const uint8_t* in, complex<float>* out, size_t num_samples, float scale);
+void iq_cf32_to_packed12_scalar(const complex<float>* in, uint8_t* out, size_t num_samples, float scale);
+
+/* Runtime Dispatch */
+bool iq_isa_supported(iq_isa isa);
+iq_isa iq_get_isa(void);
+int iq_set_isa(iq_isa isa);                             // Returns -1 if unsupported
+const char* iq_isa_name(iq_isa isa);
+
+#endif
@@ -0,0 +1,352 @@
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <linux/errqueue.h>
+#include "net_stream.h"
+
+/* Older Headers */
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#define SO_EE_CODE_ZEROCOPY_COPIED 1
+#endif
+
+using namespace std;
+
+/* Socket Buffers - Several ms at 123 MB/s */
+#define NET_SOCKET_BUFFER (4 * 1024 * 1024)
+
+/* Largest Single sendmsg() in Messages */
+#define NET_MAX_BATCH 64
+
+
+/*  SENDER  */
+
+net_sender::net_sender(const string& host, int port, uint16_t device_id, size_t num_slots)
+    : fd(-1), device_id(device_id), use_zerocopy(false), slots(NULL), num_slots(num_slots),
+      sequence(0), head(0), sent(0), freed(0), next_call(0), stopping(false),
+      num_dropped(0), num_copied(0){
+
+    /* Resolve & Connect */
+    addrinfo hints, *result;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host.c_str(), to_string(port).c_str(), &hints, &result) != 0){
+        cout << "Unable to resolve " << host << endl;
+        return;
+    }
+    for (addrinfo* a = result; a != NULL && fd < 0; a = a->ai_next){
+        fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd >= 0 && connect(fd, a->ai_addr, a->ai_addrlen) != 0){
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(result);
+    if (fd < 0){
+        cout << "Unable to connect to " << host << ":" << port << endl;
+        return;
+    }
+
+    int size = NET_SOCKET_BUFFER, one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    use_zerocopy = (setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0);
+
+    /* Page Aligned Ring - Pinned by the Kernel During Zero Copy Sends */
+    if (posix_memalign((void**)&slots, 4096, num_slots * sizeof(net_message)) != 0){
+        ::close(fd);
+        fd = -1;
+        return;
+    }
+
+    sender = thread(&net_sender::send_loop, this);
+}
+
+net_sender::~net_sender(){
+    close();
+    free(slots);
+}
+
+
+/* Queue a Packet */
+void net_sender::offer(const rx_packet& packet){
+    uint64_t seq = sequence++;
+    uint64_t h = head.load(memory_order_relaxed);
+    if (fd < 0 || h - freed.load(memory_order_acquire) >= num_slots){
+        num_dropped++;
+        return;
+    }
+
+    net_message& message = slots[h % num_slots];
+    message.header.magic = NET_STREAM_MAGIC;
+    message.header.version = NET_STREAM_VERSION;
+    message.header.device_id = device_id;
+    message.header.sequence = seq;
+    message.header.index = packet.index;
+    message.header.pps_index = packet.pps_index;
+    message.header.unix_stamp = packet.unix_stamp;
+    message.header.pps = packet.pps;
+    message.header.num_samples = RX_PACKET_SAMPLES;
+    memcpy(message.samples, packet.samples, sizeof(message.samples));
+
+    head.store(h + 1, memory_order_release);
+    wake_cv.notify_one();
+}
+
+/* Flush & Disconnect */
+void net_sender::close(){
+    if (!sender.joinable())
+        return;
+    stopping = true;
+    wake_cv.notify_one();
+    sender.join();
+    ::close(fd);
+    fd = -1;
+}
+
+
+/* Sender Thread */
+void net_sender::send_loop(){
+    while (true){
+        uint64_t h = head.load(memory_order_acquire);
+
+        /* Idle - Collect Completions or Wait for Packets */
+        if (sent == h){
+            if (stopping)
+                break;
+            if (!in_flight.empty()){
+                reap(1);
+            } else {
+                unique_lock<mutex> lock(wake_mutex);
+                wake_cv.wait_for(lock, chrono::milliseconds(10));
+            }
+            continue;
+        }
+
+        /* Contiguous Run - Stops at the End of the Ring */
+        uint64_t last = min(h, sent + (num_slots - sent % num_slots));
+        last = min(last, sent + NET_MAX_BATCH);
+        if (!send_run(sent, last)){
+            cout << "Network sink disconnected" << endl;
+            stopping = true;
+            break;
+        }
+        sent = last;
+
+        if (use_zerocopy)
+            reap(0);
+        else
+            freed.store(sent, memory_order_release);
+    }
+
+    /* Wait for Outstanding Zero Copy Sends */
+    for (int i = 0; i < 100 && !in_flight.empty(); i++)
+        reap(10);
+}
+
+/* Send Slots [first, last) */
+bool net_sender::send_run(uint64_t first, uint64_t last){
+    const size_t total = (last - first) * sizeof(net_message);
+    char* data = (char*)&slots[first % num_slots];
+    size_t done = 0;
+
+    while (done < total){
+        iovec iov;
+        iov.iov_base = data + done;
+        iov.iov_len = total - done;
+        msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+
+        ssize_t n = sendmsg(fd, &msg, use_zerocopy ? MSG_ZEROCOPY : 0);
+        if (n < 0){
+            if (errno == EINTR)
+                continue;
+
+            /* Out of Pinned Memory - Reap Completions & Retry */
+            if (errno == ENOBUFS && use_zerocopy){
+                reap(10);
+                continue;
+            }
+            return false;
+        }
+        done += n;
+
+        /* Slot Fully Covered Once this Call Completes */
+        if (use_zerocopy)
+            in_flight.push_back(make_pair(next_call++, first + done / sizeof(net_message)));
+    }
+    return true;
+}
+
+/* Read Zero Copy Completions from the Error Queue */
+void net_sender::reap(int timeout_ms){
+    pollfd p;
+    p.fd = fd;
+    p.events = 0;
+    if (poll(&p, 1, timeout_ms) <= 0 || !(p.revents & POLLERR))
+        return;
+
+    while (true){
+        char control[128];
+        msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (recvmsg(fd, &msg, MSG_ERRQUEUE) < 0)
+            break;
+
+        for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != NULL; cm = CMSG_NXTHDR(&msg, cm)){
+            if (!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+                  (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR)))
+                continue;
+            sock_extended_err* ee = (sock_extended_err*)CMSG_DATA(cm);
+            if (ee->ee_errno != 0 || ee->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+                continue;
+
+            /* Calls ee_info to ee_data Inclusive */
+            for (uint32_t id = ee->ee_info; id != ee->ee_data + 1; id++)
+                completed.insert(id);
+            if (ee->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+                num_copied += ee->ee_data - ee->ee_info + 1;
+        }
+    }
+
+    /* Release Slots in Call Order */
+    uint64_t release = freed.load(memory_order_relaxed);
+    while (!in_flight.empty() && completed.erase(in_flight.front().first)){
+        release = max(release, in_flight.front().second);
+        in_flight.pop_front();
+    }
+    freed.store(release, memory_order_release);
+}
+
+
+/*  RECEIVER  */
+
+net_connection::net_connection(int fd)
+    : fd(fd), is_closed(false), device_id(0), have_pending(false), next_sequence(0), num_lost(0){
+}
+
+net_connection::~net_connection(){
+    ::close(fd);
+}
+
+/* Blocking Read of Exactly size Bytes */
+bool net_connection::receive(void* data, size_t size){
+    char* p = (char*)data;
+    while (size > 0){
+        ssize_t n = recv(fd, p, size, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+/* Read the Next Message into pending - 1 Read, 0 Timeout, -1 Closed */
+int net_connection::first_header(int timeout_ms){
+    if (have_pending)
+        return 1;
+    if (is_closed)
+        return -1;
+
+    pollfd p;
+    p.fd = fd;
+    p.events = POLLIN;
+    if (poll(&p, 1, timeout_ms) <= 0)
+        return 0;
+
+    if (!receive(&pending.header, sizeof(pending.header)) ||
+        pending.header.magic != NET_STREAM_MAGIC || pending.header.version != NET_STREAM_VERSION ||
+        pending.header.num_samples != RX_PACKET_SAMPLES ||
+        !receive(pending.samples, sizeof(pending.samples))){
+        is_closed = true;
+        return -1;
+    }
+    device_id = pending.header.device_id;
+    have_pending = true;
+    return 1;
+}
+
+/* Next Packet */
+int net_connection::read(rx_packet* packet, int timeout_ms){
+    if (first_header(timeout_ms) != 1)
+        return 0;
+    have_pending = false;
+
+    /* Sender Drops Show as Sequence Gaps */
+    if (next_sequence != 0 && pending.header.sequence != next_sequence)
+        num_lost += pending.header.sequence - next_sequence;
+    next_sequence = pending.header.sequence + 1;
+
+    packet->index = pending.header.index;
+    packet->pps_index = pending.header.pps_index;
+    packet->pps = pending.header.pps != 0;
+    packet->unix_stamp = pending.header.unix_stamp;
+    memcpy(packet->samples, pending.samples, sizeof(packet->samples));
+    return 1;
+}
+
+
+/*  LISTENER  */
+
+net_listener::net_listener(int port){
+    fd = socket(AF_INET6, SOCK_STREAM, 0);
+    if (fd < 0)
+        return;
+
+    int one = 1, zero = 0;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero));
+
+    sockaddr_in6 addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin6_family = AF_INET6;
+    addr.sin6_addr = in6addr_any;
+    addr.sin6_port = htons(port);
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 16) != 0){
+        cout << "Unable to listen on port " << port << endl;
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+net_listener::~net_listener(){
+    if (fd >= 0)
+        ::close(fd);
+}
+
+net_connection* net_listener::accept(int timeout_ms){
+    pollfd p;
+    p.fd = fd;
+    p.events = POLLIN;
+    if (poll(&p, 1, timeout_ms) <= 0)
+        return NULL;
+
+    int conn = ::accept(fd, NULL, NULL);
+    if (conn < 0)
+        return NULL;
+    int size = NET_SOCKET_BUFFER;
+    setsockopt(conn, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    return new net_connection(conn);
+}
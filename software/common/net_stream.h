@@ -0,0 +1,127 @@
+#ifndef NET_STREAM_H
+#define NET_STREAM_H
+
+#include <set>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <stdint.h>
+#include <condition_variable>
+#include "rx_ring.h"
+using namespace std;
+
+/* Wire Format - One Message per Packet over TCP */
+#define NET_STREAM_MAGIC 0x4E505053                     // "SPPN"
+#define NET_STREAM_VERSION 1
+#define NET_STREAM_PORT 5025
+
+/* Packet Header - All Fields Little Endian */
+class net_packet_header {
+    public:
+        uint32_t magic;
+        uint16_t version;
+        uint16_t device_id;
+        uint64_t sequence;                              // Counts every packet offered, gaps are sender drops
+        uint64_t index;
+        uint64_t pps_index;
+        int64_t unix_stamp;
+        uint32_t pps;
+        uint32_t num_samples;
+};
+
+class net_message {
+    public:
+        net_packet_header header;
+        int16_t samples[RX_PACKET_SAMPLES * 2];
+};
+
+/* TCP Sender with MSG_ZEROCOPY
+ * offer() copies the packet into a message ring and returns, a sender
+ * thread passes runs of the ring straight to sendmsg(). With zero copy
+ * the kernel pins the ring pages, so a slot is only reused once its
+ * completion has been read from the socket error queue. Falls back to
+ * ordinary copying sends if SO_ZEROCOPY is unavailable.
+ */
+class net_sender : public packet_tap {
+    public:
+        net_sender(const string& host, int port, uint16_t device_id, size_t num_slots);
+        ~net_sender();
+
+        bool connected() const { return fd >= 0; }
+        bool zerocopy() const { return use_zerocopy; }
+        void offer(const rx_packet& packet);            // Never blocks, drops if the ring is full
+        void close();                                   // Send what is queued & disconnect
+
+        uint64_t dropped() const { return num_dropped; }
+        uint64_t copied() const { return num_copied; }  // Zero copy sends the kernel had to copy
+
+    private:
+        void send_loop();
+        bool send_run(uint64_t first, uint64_t last);
+        void reap(int timeout_ms);
+
+        int fd;
+        uint16_t device_id;
+        bool use_zerocopy;
+
+        net_message* slots;
+        size_t num_slots;
+        uint64_t sequence;
+        atomic<uint64_t> head;                          // Slots filled by offer()
+        uint64_t sent;                                  // Slots handed to the kernel
+        atomic<uint64_t> freed;                         // Slots reusable
+
+        /* Zero Copy Calls in Flight - (call id, slots sent up to) */
+        deque<pair<uint32_t, uint64_t>> in_flight;
+        set<uint32_t> completed;
+        uint32_t next_call;
+
+        mutex wake_mutex;
+        condition_variable wake_cv;
+        atomic<bool> stopping;
+        thread sender;
+
+        atomic<uint64_t> num_dropped;
+        uint64_t num_copied;
+};
+
+/* One Inbound Device Stream */
+class net_connection : public packet_source {
+    public:
+        net_connection(int fd);
+        ~net_connection();
+
+        int read(rx_packet* packet, int timeout_ms);
+        bool closed() const { return is_closed; }
+        int first_header(int timeout_ms);               // Reads ahead to learn the device id
+
+        uint16_t device() const { return device_id; }
+        uint64_t lost() const { return num_lost; }      // Sequence gaps
+
+    private:
+        bool receive(void* data, size_t size);
+
+        int fd;
+        bool is_closed;
+        uint16_t device_id;
+        bool have_pending;
+        net_message pending;
+        uint64_t next_sequence;
+        uint64_t num_lost;
+};
+
+/* Listening Socket */
+class net_listener {
+    public:
+        net_listener(int port);
+        ~net_listener();
+        bool listening() const { return fd >= 0; }
+        net_connection* accept(int timeout_ms);         // NULL on timeout
+
+    private:
+        int fd;
+};
+
+#endif
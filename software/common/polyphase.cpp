@@ -0,0 +1,291 @@
+#include <math.h>
+#include <stdexcept>
+#include "polyphase.h"
+#include "iq_convert.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+using namespace std;
+
+/* NCO Table Length - Phase is re-anchored in double precision every block */
+#define NCO_BLOCK 1024
+
+
+/*  DOT PRODUCT KERNELS  */
+/* Interleaved I/Q samples against interleaved taps, acc[0] = I, acc[1] = Q */
+
+static void dot_scalar(const float* x, const float* h, size_t len, float* acc){
+    float re = 0, im = 0;
+    for (size_t j = 0; j < len; j += 2){
+        re += x[j] * h[j];
+        im += x[j + 1] * h[j + 1];
+    }
+    acc[0] = re;
+    acc[1] = im;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("sse4.1")))
+static void dot_sse(const float* x, const float* h, size_t len, float* acc){
+    __m128 a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps();
+    size_t j = 0;
+    for (; j + 8 <= len; j += 8){
+        a0 = _mm_add_ps(a0, _mm_mul_ps(_mm_loadu_ps(&x[j]), _mm_loadu_ps(&h[j])));
+        a1 = _mm_add_ps(a1, _mm_mul_ps(_mm_loadu_ps(&x[j + 4]), _mm_loadu_ps(&h[j + 4])));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(a0, a1));
+    dot_scalar(&x[j], &h[j], len - j, acc);
+    acc[0] += lanes[0] + lanes[2];
+    acc[1] += lanes[1] + lanes[3];
+}
+
+__attribute__((target("avx2")))
+static void dot_avx2(const float* x, const float* h, size_t len, float* acc){
+    __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps();
+    size_t j = 0;
+    for (; j + 16 <= len; j += 16){
+        a0 = _mm256_add_ps(a0, _mm256_mul_ps(_mm256_loadu_ps(&x[j]), _mm256_loadu_ps(&h[j])));
+        a1 = _mm256_add_ps(a1, _mm256_mul_ps(_mm256_loadu_ps(&x[j + 8]), _mm256_loadu_ps(&h[j + 8])));
+    }
+    __m256 a = _mm256_add_ps(a0, a1);
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+    float lanes[4];
+    _mm_storeu_ps(lanes, s);
+    dot_scalar(&x[j], &h[j], len - j, acc);
+    acc[0] += lanes[0] + lanes[2];
+    acc[1] += lanes[1] + lanes[3];
+}
+
+#endif
+
+#if defined(__aarch64__)
+
+static void dot_neon(const float* x, const float* h, size_t len, float* acc){
+    float32x4_t a0 = vdupq_n_f32(0), a1 = vdupq_n_f32(0);
+    size_t j = 0;
+    for (; j + 8 <= len; j += 8){
+        a0 = vfmaq_f32(a0, vld1q_f32(&x[j]), vld1q_f32(&h[j]));
+        a1 = vfmaq_f32(a1, vld1q_f32(&x[j + 4]), vld1q_f32(&h[j + 4]));
+    }
+    float lanes[4];
+    vst1q_f32(lanes, vaddq_f32(a0, a1));
+    dot_scalar(&x[j], &h[j], len - j, acc);
+    acc[0] += lanes[0] + lanes[2];
+    acc[1] += lanes[1] + lanes[3];
+}
+
+#endif
+
+/* Select Kernel to Match the Conversion Kernels */
+static void (*select_dot(void))(const float*, const float*, size_t, float*){
+    switch (iq_get_isa()){
+#if defined(__x86_64__) || defined(__i386__)
+        case IQ_ISA_AVX2:   return dot_avx2;
+        case IQ_ISA_SSE:    return dot_sse;
+#endif
+#if defined(__aarch64__)
+        case IQ_ISA_NEON:   return dot_neon;
+#endif
+        default:            return dot_scalar;
+    }
+}
+
+
+/*  FILTER DESIGN  */
+
+/* Blackman Windowed Sinc */
+vector<float> design_lowpass(int num_taps, double cutoff){
+
+    vector<double> h(num_taps);
+    double centre = (num_taps - 1) / 2.0;
+    double sum = 0;
+    for (int k = 0; k < num_taps; k++){
+        double t = k - centre;
+        double sinc = (t == 0) ? 2 * cutoff : sin(2 * M_PI * cutoff * t) / (M_PI * t);
+        double w = (num_taps == 1) ? 1.0 :
+                   0.42 - 0.5 * cos(2 * M_PI * k / (num_taps - 1)) + 0.08 * cos(4 * M_PI * k / (num_taps - 1));
+        h[k] = sinc * w;
+        sum += h[k];
+    }
+
+    /* Normalise to Unity DC Gain */
+    vector<float> taps(num_taps);
+    for (int k = 0; k < num_taps; k++)
+        taps[k] = (float)(h[k] / sum);
+    return taps;
+}
+
+
+/* NCO Mixer */
+void nco_mix(const complex<float>* in, complex<float>* out, size_t num_samples,
+             uint64_t first_index, double nco){
+
+    /* Phasor Table for One Block */
+    size_t table_size = min((size_t)NCO_BLOCK, num_samples);
+    vector<complex<float>> table(table_size);
+    for (size_t k = 0; k < table_size; k++){
+        double w = -2 * M_PI * fmod(nco * k, 1.0);
+        table[k] = complex<float>((float)cos(w), (float)sin(w));
+    }
+
+    for (size_t b = 0; b < num_samples; b += NCO_BLOCK){
+
+        /* Block Start Phase from Absolute Index */
+        double w = -2 * M_PI * fmod(nco * (double)(first_index + b), 1.0);
+        complex<float> start((float)cos(w), (float)sin(w));
+
+        size_t end = min(b + NCO_BLOCK, num_samples);
+        for (size_t k = b; k < end; k++)
+            out[k] = cmul(in[k], cmul(start, table[k - b]));
+    }
+}
+
+
+/*  FIR DECIMATOR  */
+
+/* cutoff - passband edge as a fraction of the output Nyquist frequency
+ * nco_frequency - mixer frequency in cycles per input sample
+ */
+fir_decimator::fir_decimator(int decimation, int num_taps, double cutoff, double nco_frequency)
+    : decimation(decimation), nco(nco_frequency){
+
+    if (decimation < 1 || num_taps < 1)
+        throw invalid_argument("Invalid decimator configuration");
+
+    /* Odd Length for an Integer Group Delay */
+    if (num_taps % 2 == 0)
+        num_taps++;
+
+    taps = design_lowpass(num_taps, cutoff * 0.5 / decimation);
+    taps_interleaved.resize(2 * taps.size());
+    for (size_t k = 0; k < taps.size(); k++)
+        taps_interleaved[2 * k] = taps_interleaved[2 * k + 1] = taps[k];
+    dot = select_dot();
+}
+
+
+/* Only every decimation'th output is evaluated, which is the polyphase
+ * decomposition of the filter - each output draws one tap from each of
+ * the decimation sub-filters in turn.
+ */
+size_t fir_decimator::process(const complex<float>* in, size_t num_in, uint64_t first_index,
+                              complex<float>* out, uint64_t* first_out) const {
+
+    const uint64_t half = (taps.size() - 1) / 2;
+    *first_out = (first_index + half + decimation - 1) / decimation;
+    if (num_in < taps.size())
+        return 0;
+
+    /* Outputs Whose Span Lies Within the Block */
+    uint64_t last_out = (first_index + num_in - 1 - half) / decimation;
+    if (last_out < *first_out)
+        return 0;
+    size_t count = last_out - *first_out + 1;
+
+    /* Mix to Baseband */
+    vector<complex<float>> mixed;
+    const complex<float>* x = in;
+    if (nco != 0){
+        mixed.resize(num_in);
+        nco_mix(in, mixed.data(), num_in, first_index, nco);
+        x = mixed.data();
+    }
+
+    /* Filter - Taps are Symmetric so No Reversal is Needed */
+    for (size_t k = 0; k < count; k++){
+        size_t start = (*first_out + k) * decimation - half - first_index;
+        float acc[2];
+        dot((const float*)&x[start], taps_interleaved.data(), taps_interleaved.size(), acc);
+        out[k] = complex<float>(acc[0], acc[1]);
+    }
+    return count;
+}
+
+
+/*  POLYPHASE CHANNELIZER  */
+
+polyphase_channelizer::polyphase_channelizer(int num_channels, int taps_per_channel, double nco_frequency)
+    : num_channels(num_channels), taps_per_channel(taps_per_channel), nco(nco_frequency),
+      ifft(num_channels, true){
+
+    if (taps_per_channel < 1)
+        throw invalid_argument("Invalid channelizer configuration");
+
+    /* Prototype - Odd Length Low Pass Padded with a Zero Tap to Fill the Branches */
+    int num_taps = num_channels * taps_per_channel;
+    vector<float> prototype = design_lowpass(num_taps - 1, 0.5 / num_channels);
+    prototype.push_back(0);
+    delay = (num_taps - 2) / 2;
+
+    /* Branch Reversed Layout - Lets Each Branch Block be a Contiguous MAC */
+    taps_interleaved.resize(2 * num_taps);
+    for (int k = 0; k < taps_per_channel; k++){
+        for (int q = 0; q < num_channels; q++){
+            float g = prototype[k * num_channels + (num_channels - 1 - q)];
+            taps_interleaved[2 * (k * num_channels + q)] = g;
+            taps_interleaved[2 * (k * num_channels + q) + 1] = g;
+        }
+    }
+
+    /* Per Channel Phase Correction for the Prototype Delay */
+    channel_rotation.resize(num_channels);
+    for (int c = 0; c < num_channels; c++){
+        double w = -2 * M_PI * fmod((double)c * delay / num_channels, 1.0);
+        channel_rotation[c] = complex<float>((float)cos(w), (float)sin(w));
+    }
+}
+
+
+size_t polyphase_channelizer::process(const complex<float>* in, size_t num_in, uint64_t first_index,
+                                      complex<float>** out, uint64_t* first_out) const {
+
+    const uint64_t num_taps = (uint64_t)num_channels * taps_per_channel;
+    *first_out = (first_index + num_taps - 1 - delay + num_channels - 1) / num_channels;
+    if (num_in < num_taps)
+        return 0;
+
+    uint64_t last_out = (first_index + num_in - 1 - delay) / num_channels;
+    if (last_out < *first_out)
+        return 0;
+    size_t count = last_out - *first_out + 1;
+
+    /* Mix */
+    vector<complex<float>> mixed;
+    const complex<float>* x = in;
+    if (nco != 0){
+        mixed.resize(num_in);
+        nco_mix(in, mixed.data(), num_in, first_index, nco);
+        x = mixed.data();
+    }
+
+    vector<float> acc(2 * num_channels);
+    vector<complex<float>> v(num_channels);
+    for (size_t m = 0; m < count; m++){
+
+        /* Branch Filters */
+        size_t top = (*first_out + m) * num_channels + delay - first_index;
+        fill(acc.begin(), acc.end(), 0.0f);
+        for (int k = 0; k < taps_per_channel; k++){
+            const float* xf = (const float*)&x[top - k * num_channels - (num_channels - 1)];
+            const float* g = &taps_interleaved[2 * k * num_channels];
+            for (int j = 0; j < 2 * num_channels; j++)
+                acc[j] += g[j] * xf[j];
+        }
+        for (int p = 0; p < num_channels; p++)
+            v[p] = complex<float>(acc[2 * (num_channels - 1 - p)], acc[2 * (num_channels - 1 - p) + 1]);
+
+        /* Branches -> Channels */
+        ifft.execute(v.data());
+        for (int c = 0; c < num_channels; c++)
+            out[c][m] = cmul(v[c], channel_rotation[c]);
+    }
+    return count;
+}
@@ -0,0 +1,82 @@
+#ifndef POLYPHASE_H
+#define POLYPHASE_H
+
+#include <vector>
+#include <complex>
+#include <stdint.h>
+#include "fft.h"
+using namespace std;
+
+/* Timebase Convention
+ * Both stages are zero phase: decimated sample m is centred on input sample
+ * m * decimation, so input index n maps to n / decimation in the output
+ * timebase. Inputs are identified by their absolute sample index, which lets
+ * independent blocks be processed on different threads with identical results
+ * to processing the stream in one piece.
+ */
+
+/* Polyphase FIR Decimator with NCO Mixer
+ * Mixes by -nco_frequency (cycles per input sample), low pass filters with the
+ * passband edge at cutoff times the output Nyquist frequency and keeps every
+ * decimation'th output.
+ */
+class fir_decimator {
+    public:
+        fir_decimator(int decimation, int num_taps, double cutoff, double nco_frequency);
+
+        /* Filter a Block - in[0] is input sample first_index. Produces every output whose
+         * filter span lies within the block, returning the count and setting *first_out
+         * to the output index of out[0]. out must hold max_output(num_in) samples.
+         */
+        size_t process(const complex<float>* in, size_t num_in, uint64_t first_index,
+                       complex<float>* out, uint64_t* first_out) const;
+
+        size_t max_output(size_t num_in) const { return num_in / decimation + 1; }
+        size_t span() const { return taps.size(); }
+        int factor() const { return decimation; }
+
+    private:
+        int decimation;
+        double nco;                                     // Cycles per input sample
+        vector<float> taps;
+        vector<float> taps_interleaved;                 // Each tap repeated for I and Q
+        void (*dot)(const float*, const float*, size_t, float*);
+};
+
+
+/* Critically Sampled Polyphase Channelizer
+ * Splits the band into num_channels channels of width fs / num_channels,
+ * channel c centred on c * fs / num_channels (upper half are negative frequencies).
+ */
+class polyphase_channelizer {
+    public:
+        polyphase_channelizer(int num_channels, int taps_per_channel, double nco_frequency);
+
+        /* Channelize a Block - out[c] receives channel c and must hold max_output(num_in)
+         * samples. Returns the number of samples per channel and sets *first_out.
+         */
+        size_t process(const complex<float>* in, size_t num_in, uint64_t first_index,
+                       complex<float>** out, uint64_t* first_out) const;
+
+        size_t max_output(size_t num_in) const { return num_in / num_channels + 1; }
+        int channels() const { return num_channels; }
+
+    private:
+        int num_channels;
+        int taps_per_channel;
+        int delay;                                      // Prototype group delay
+        double nco;
+        vector<float> taps_interleaved;                 // Branch reversed, repeated for I and Q
+        vector<complex<float>> channel_rotation;
+        fft_plan ifft;
+};
+
+
+/* Windowed Sinc Low Pass - cutoff in cycles per sample, unity DC gain */
+vector<float> design_lowpass(int num_taps, double cutoff);
+
+/* Mix by -nco (cycles per sample), in[0] being absolute sample first_index */
+void nco_mix(const complex<float>* in, complex<float>* out, size_t num_samples,
+             uint64_t first_index, double nco);
+
+#endif
@@ -0,0 +1,235 @@
+#include <cmath>
+#include <fstream>
+#include <time.h>
+#include "psd_monitor.h"
+#include "iq_convert.h"
+
+using namespace std;
+
+/* Thread CPU Time (ns) */
+static uint64_t thread_cpu_ns(){
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+spectrum_monitor::spectrum_monitor(monitor_configuration config)
+    : config(config), plan(config.fft_size, false), window(config.fft_size),
+      packet_count(0), packet_stride(1), cost_ns(0), stopping(false),
+      newest(0), last_written(0), num_analysed(0){
+
+    /* Hann Window */
+    double sum = 0;
+    for (int i = 0; i < config.fft_size; i++){
+        window[i] = 0.5 - 0.5 * cos(2 * M_PI * i / config.fft_size);
+        sum += window[i];
+    }
+    window_norm = 1.0 / (sum * sum);
+
+    /* Start at the Fraction Limit Until the Cost is Known */
+    packet_stride = (uint64_t)ceil(1.0 / config.max_fraction);
+
+    /* Packet Pool - Bounds Memory if the Threads Fall Behind */
+    for (int i = 0; i < config.num_threads * 4; i++){
+        packets.push_back(new rx_packet);
+        free_packets.push_back(packets.back());
+    }
+}
+
+spectrum_monitor::~spectrum_monitor(){
+    for (rx_packet* p : packets)
+        delete p;
+}
+
+
+/* Start Analysis Threads */
+void spectrum_monitor::start(){
+    for (int i = 0; i < config.num_threads; i++)
+        threads.push_back(thread(&spectrum_monitor::work, this));
+}
+
+/* Drain, Join & Write Remaining Spectra */
+void spectrum_monitor::stop(){
+    {
+        lock_guard<mutex> lock(queue_mutex);
+        stopping = true;
+    }
+    queue_cv.notify_all();
+    for (thread& t : threads)
+        t.join();
+    threads.clear();
+    flush(newest + 1);
+}
+
+
+/* Decimating Sampler */
+void spectrum_monitor::offer(const rx_packet& packet){
+
+    /* Re-derive the Stride from the Measured Cost 4 Times a Second */
+    const double packet_rate = config.sample_rate / RX_PACKET_SAMPLES;
+    if (packet_count % (uint64_t)(packet_rate / 4 + 1) == 0 && cost_ns > 0){
+        double allowed_rate = config.cpu_budget * 1e9 / cost_ns;
+        uint64_t stride = (uint64_t)ceil(packet_rate / allowed_rate);
+        uint64_t min_stride = (uint64_t)ceil(1.0 / config.max_fraction);
+        packet_stride = stride > min_stride ? stride : min_stride;
+    }
+    if (packet_count++ % packet_stride != 0)
+        return;
+
+    /* Skip Rather than Wait on a Busy Queue or an Empty Pool */
+    unique_lock<mutex> lock(queue_mutex, try_to_lock);
+    if (!lock.owns_lock() || free_packets.empty())
+        return;
+    rx_packet* copy = free_packets.back();
+    free_packets.pop_back();
+    *copy = packet;
+    queue.push_back(copy);
+    lock.unlock();
+    queue_cv.notify_one();
+}
+
+
+/* Analysis Thread */
+void spectrum_monitor::work(){
+
+    accumulator acc;
+    acc.unix_stamp = 0;
+    acc.count = 0;
+    acc.power.assign(config.fft_size, 0.0);
+    vector<complex<float>> samples(RX_PACKET_SAMPLES);
+    vector<complex<float>> segment(config.fft_size);
+
+    while (true){
+        rx_packet* packet = NULL;
+        {
+            unique_lock<mutex> lock(queue_mutex);
+            queue_cv.wait_for(lock, chrono::milliseconds(200), [this]{ return stopping || !queue.empty(); });
+            if (!queue.empty()){
+                packet = queue.front();
+                queue.pop_front();
+            } else if (stopping){
+                break;
+            }
+        }
+
+        /* Idle - Hand Over the Open Second so it isn't Held Back */
+        if (packet == NULL){
+            retire(acc);
+            continue;
+        }
+
+        /* New Second */
+        if (packet->unix_stamp != acc.unix_stamp){
+            retire(acc);
+            acc.unix_stamp = packet->unix_stamp;
+        }
+
+        uint64_t t0 = thread_cpu_ns();
+        analyse(*packet, acc, samples, segment);
+        uint64_t cost = thread_cpu_ns() - t0;
+
+        {
+            lock_guard<mutex> lock(queue_mutex);
+            free_packets.push_back(packet);
+        }
+
+        /* Smoothed Cost - Racing Updates Only Lose a Sample */
+        uint64_t prev = cost_ns;
+        cost_ns = prev ? prev - prev / 16 + cost / 16 : cost;
+        num_analysed++;
+    }
+
+    retire(acc);
+}
+
+
+/* Welch Average Segments of One Packet */
+void spectrum_monitor::analyse(const rx_packet& packet, accumulator& acc,
+                               vector<complex<float>>& samples, vector<complex<float>>& segment){
+
+    const int n = config.fft_size;
+    iq_i16_to_cf32(packet.samples, samples.data(), RX_PACKET_SAMPLES, I12_SCALE);
+
+    for (int start = 0; start + n <= RX_PACKET_SAMPLES; start += n / 2){
+        for (int i = 0; i < n; i++)
+            segment[i] = samples[start + i] * window[i];
+        plan.execute(segment.data());
+        for (int i = 0; i < n; i++)
+            acc.power[i] += norm(segment[i]);
+        acc.count++;
+    }
+}
+
+
+/* Merge an Accumulator into its Second & Write Settled Seconds */
+void spectrum_monitor::retire(accumulator& acc){
+    if (acc.count == 0)
+        return;
+
+    time_t before;
+    {
+        lock_guard<mutex> lock(pending_mutex);
+
+        /* Add to the Second's Pending Total - Dropped if that Second is Already Written */
+        if (acc.unix_stamp > last_written){
+            auto it = pending.find(acc.unix_stamp);
+            if (it == pending.end()){
+                pending[acc.unix_stamp] = acc;
+            } else {
+                for (int i = 0; i < config.fft_size; i++)
+                    it->second.power[i] += acc.power[i];
+                it->second.count += acc.count;
+            }
+        }
+        if (acc.unix_stamp > newest)
+            newest = acc.unix_stamp;
+
+        /* Allow a Second for the Other Threads to Contribute */
+        before = newest - 1;
+    }
+
+    acc.count = 0;
+    fill(acc.power.begin(), acc.power.end(), 0.0);
+    flush(before);
+}
+
+/* Write Pending Seconds Older than before */
+void spectrum_monitor::flush(time_t before){
+    vector<accumulator> ready;
+    {
+        lock_guard<mutex> lock(pending_mutex);
+        while (!pending.empty() && pending.begin()->first < before){
+            ready.push_back(pending.begin()->second);
+            last_written = pending.begin()->first;
+            pending.erase(pending.begin());
+        }
+    }
+    for (const accumulator& acc : ready)
+        write_spectrum(acc);
+}
+
+
+/* Write Header & dBFS Bins - DC Centred */
+void spectrum_monitor::write_spectrum(const accumulator& acc){
+
+    const int n = config.fft_size;
+    psd_header header;
+    header.unix_stamp = acc.unix_stamp;
+    header.fft_size = n;
+    header.num_averages = acc.count;
+    header.sample_rate = config.sample_rate;
+    header.centre_frequency = config.centre_frequency;
+
+    vector<float> bins(n);
+    for (int i = 0; i < n; i++){
+        double power = acc.power[(i + n / 2) % n] / acc.count * window_norm;
+        bins[i] = (float)(10 * log10(power + 1e-20));
+    }
+
+    ofstream psd_file;
+    psd_file.open(config.out_path + to_string(acc.unix_stamp) + ".psd", std::ofstream::binary);
+    psd_file.write((char*)&header, sizeof(header));
+    psd_file.write((char*)bins.data(), n * sizeof(float));
+    psd_file.close();
+}
@@ -0,0 +1,101 @@
+#ifndef PSD_MONITOR_H
+#define PSD_MONITOR_H
+
+#include <map>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <complex>
+#include <condition_variable>
+#include "fft.h"
+#include "rx_ring.h"
+using namespace std;
+
+/* Spectrum File Header - Followed by fft_size float32 dBFS Bins, Lowest Frequency First */
+class psd_header {
+    public:
+        time_t unix_stamp;                              // Second the spectrum covers
+        uint32_t fft_size;
+        uint32_t num_averages;                          // FFT segments averaged
+        double sample_rate;
+        double centre_frequency;
+};
+
+/* Monitor Configuration */
+class monitor_configuration {
+    public:
+        string out_path;
+        int fft_size;                                   // Power of 2, <= RX_PACKET_SAMPLES
+        double max_fraction;                            // Upper bound on fraction of packets analysed
+        double cpu_budget;                              // Fraction of one core across all threads
+        int num_threads;
+        double sample_rate;
+        double centre_frequency;
+};
+
+/* Continuous Averaged Power Spectrum
+ * A decimating sampler passes one packet in every stride to the analysis
+ * threads, with the stride adjusted from the measured CPU cost per packet
+ * so the monitor stays inside its budget. Each thread Welch averages
+ * Hann windowed, 50% overlapped segments into its own accumulator, which
+ * are merged and written as <unix>.psd once per second.
+ */
+class spectrum_monitor : public packet_tap {
+    public:
+        spectrum_monitor(monitor_configuration config);
+        ~spectrum_monitor();
+        void start();
+        void stop();
+
+        void offer(const rx_packet& packet);            // Called by the assembler, never blocks
+
+        uint64_t analysed() const { return num_analysed; }
+        uint64_t stride() const { return packet_stride; }
+
+    private:
+        class accumulator {
+            public:
+                time_t unix_stamp;
+                uint32_t count;
+                vector<double> power;
+        };
+
+        void work();
+        void analyse(const rx_packet& packet, accumulator& acc,
+                     vector<complex<float>>& samples, vector<complex<float>>& segment);
+        void retire(accumulator& acc);
+        void flush(time_t before);
+        void write_spectrum(const accumulator& acc);
+
+        monitor_configuration config;
+        fft_plan plan;
+        vector<float> window;
+        double window_norm;                             // Scales a full scale tone to 0 dBFS
+
+        /* Sampler - Assembler Thread Only */
+        uint64_t packet_count;
+        atomic<uint64_t> packet_stride;
+        atomic<uint64_t> cost_ns;                       // Smoothed CPU time per packet
+
+        /* Packet Queue & Free List */
+        mutex queue_mutex;
+        condition_variable queue_cv;
+        deque<rx_packet*> queue;
+        vector<rx_packet*> free_packets;
+        vector<rx_packet*> packets;
+        bool stopping;
+
+        /* Completed Seconds Awaiting Output */
+        mutex pending_mutex;
+        map<time_t, accumulator> pending;
+        time_t newest;
+        time_t last_written;
+
+        atomic<uint64_t> num_analysed;
+        vector<thread> threads;
+};
+
+#endif
@@ -0,0 +1,46 @@
+#include <chrono>
+#include <thread>
+#include "rx_ring.h"
+
+using namespace std;
+
+rx_ring::rx_ring(size_t num_packets)
+    : slots(new rx_packet[num_packets]), num_slots(num_packets),
+      head(0), tail(0), num_dropped(0), is_closed(false){
+}
+
+rx_ring::~rx_ring(){
+    delete [] slots;
+}
+
+
+/* Claim Next Free Slot */
+rx_packet* rx_ring::claim(){
+    uint64_t h = head.load(memory_order_relaxed);
+    if (h - tail.load(memory_order_acquire) >= num_slots)
+        return NULL;
+    return &slots[h % num_slots];
+}
+
+/* Make Claimed Slot Visible to the Consumer */
+void rx_ring::publish(){
+    head.store(head.load(memory_order_relaxed) + 1, memory_order_release);
+}
+
+
+/* Wait for Oldest Packet */
+rx_packet* rx_ring::peek(int timeout_ms){
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(timeout_ms);
+    uint64_t t = tail.load(memory_order_relaxed);
+    while (head.load(memory_order_acquire) == t){
+        if (is_closed || chrono::steady_clock::now() >= deadline)
+            return NULL;
+        this_thread::sleep_for(chrono::microseconds(100));
+    }
+    return &slots[t % num_slots];
+}
+
+/* Return Oldest Slot to the Producer */
+void rx_ring::release(){
+    tail.store(tail.load(memory_order_relaxed) + 1, memory_order_release);
+}
@@ -0,0 +1,78 @@
+#ifndef RX_RING_H
+#define RX_RING_H
+
+#include <ctime>
+#include <atomic>
+#include <stdint.h>
+#include <stddef.h>
+using namespace std;
+
+/* Samples per LMS_RecvStream Call */
+#define RX_PACKET_SAMPLES 1360
+
+/* Received Packet */
+class rx_packet {
+    public:
+        uint64_t index;                                 // Sample index of first sample
+        uint64_t pps_index;                             // Sample index of last PPS event
+        bool pps;                                       // First packet after a new PPS event
+        time_t unix_stamp;                              // Host time at reception
+        int16_t samples[RX_PACKET_SAMPLES * 2];         // Interleaved I12 I/Q
+};
+
+/* Packet Consumer Fed by the Capture Assembler
+ * offer() sees every packet in order and must not block.
+ */
+class packet_tap {
+    public:
+        virtual ~packet_tap() {}
+        virtual void offer(const rx_packet& packet) = 0;
+};
+
+/* Packet Stream from Another Process or Host
+ * read() returns 1 with the next packet, 0 on timeout and -1 if packets
+ * were lost and none was returned.
+ */
+class packet_source {
+    public:
+        virtual ~packet_source() {}
+        virtual int read(rx_packet* packet, int timeout_ms) = 0;
+        virtual bool closed() const = 0;
+};
+
+/* Single Producer / Single Consumer Packet Ring
+ * The receive thread never blocks - if the consumer falls behind the
+ * packet is counted as dropped instead.
+ */
+class rx_ring {
+    public:
+        rx_ring(size_t num_packets);
+        ~rx_ring();
+
+        /* Producer */
+        rx_packet* claim();                             // Next free slot, NULL if full
+        void publish();                                 // Commit claimed slot
+        void drop() { num_dropped++; }
+
+        /* Consumer */
+        rx_packet* peek(int timeout_ms);                // Oldest packet, NULL on timeout
+        void release();                                 // Free oldest packet
+
+        /* End of Stream */
+        void close() { is_closed = true; }
+        bool closed() const { return is_closed; }
+
+        size_t count() const { return head - tail; }   // Packets waiting
+        uint64_t dropped() const { return num_dropped; }
+        size_t capacity() const { return num_slots; }
+
+    private:
+        rx_packet* slots;
+        size_t num_slots;
+        atomic<uint64_t> head;                          // Next slot to publish
+        atomic<uint64_t> tail;                          // Next slot to consume
+        atomic<uint64_t> num_dropped;
+        atomic<bool> is_closed;
+};
+
+#endif
@@ -0,0 +1,197 @@
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "shm_ring.h"
+
+using namespace std;
+
+/* Mapping Size for a Ring of num_slots */
+static size_t ring_bytes(size_t num_slots){
+    size_t header_size = (sizeof(shm_ring_header) + 63) / 64 * 64;
+    return header_size + num_slots * sizeof(shm_slot);
+}
+
+/* Slots Follow the Header on a Cache Line Boundary */
+static shm_slot* ring_slots(shm_ring_header* header){
+    return (shm_slot*)((char*)header + (sizeof(shm_ring_header) + 63) / 64 * 64);
+}
+
+
+/*  WRITER  */
+
+shm_writer::shm_writer(const string& name, size_t num_slots, double sample_rate)
+    : name(name), header(NULL), slots(NULL), on_hugepages(false){
+
+    /* Hugetlbfs First - Size Rounded to Whole Huge Pages */
+    void* map = MAP_FAILED;
+    size_t huge_size = (ring_bytes(num_slots) + SHM_RING_HUGEPAGE_SIZE - 1) / SHM_RING_HUGEPAGE_SIZE * SHM_RING_HUGEPAGE_SIZE;
+    string huge_path = SHM_RING_HUGEPAGE_PATH + name;
+    unlink(huge_path.c_str());
+    int fd = open(huge_path.c_str(), O_CREAT | O_RDWR | O_EXCL, 0644);
+    if (fd >= 0){
+        if (ftruncate(fd, huge_size) == 0)
+            map = mmap(NULL, huge_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED)
+            unlink(huge_path.c_str());
+    }
+
+    if (map != MAP_FAILED){
+        path = huge_path;
+        map_size = huge_size;
+        on_hugepages = true;
+    } else {
+
+        /* POSIX Shared Memory - Ask for Transparent Huge Pages */
+        map_size = ring_bytes(num_slots);
+        shm_unlink(("/" + name).c_str());
+        fd = shm_open(("/" + name).c_str(), O_CREAT | O_RDWR | O_EXCL, 0644);
+        if (fd < 0 || ftruncate(fd, map_size) != 0){
+            cout << "Unable to create shared memory ring " << name << endl;
+            if (fd >= 0)
+                close(fd);
+            return;
+        }
+        map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED){
+            cout << "Unable to map shared memory ring " << name << endl;
+            shm_unlink(("/" + name).c_str());
+            return;
+        }
+        madvise(map, map_size, MADV_HUGEPAGE);
+    }
+
+    /* Initialise - Magic Written Last so Readers Never See a Partial Header */
+    header = (shm_ring_header*)map;
+    slots = ring_slots(header);
+    header->version = SHM_RING_VERSION;
+    header->num_slots = num_slots;
+    header->slot_size = sizeof(shm_slot);
+    header->sample_rate = sample_rate;
+    header->head = 0;
+    header->is_closed = false;
+    for (size_t i = 0; i < num_slots; i++)
+        slots[i].sequence = 0;
+    atomic_thread_fence(memory_order_release);
+    header->magic = SHM_RING_MAGIC;
+}
+
+shm_writer::~shm_writer(){
+    if (header == NULL)
+        return;
+    header->is_closed = true;
+    munmap(header, map_size);
+    if (on_hugepages)
+        unlink(path.c_str());
+    else
+        shm_unlink(("/" + name).c_str());
+}
+
+
+/* Publish One Packet */
+void shm_writer::offer(const rx_packet& packet){
+    if (header == NULL)
+        return;
+
+    uint64_t n = header->head.load(memory_order_relaxed);
+    shm_slot& slot = slots[n % header->num_slots];
+
+    slot.sequence.store(2 * n + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(&slot.packet, &packet, sizeof(rx_packet));
+    slot.sequence.store(2 * n + 2, memory_order_release);
+
+    header->head.store(n + 1, memory_order_release);
+}
+
+
+/*  READER  */
+
+shm_reader::shm_reader(const string& name)
+    : header(NULL), slots(NULL), map_size(0), cursor(0), num_overruns(0), num_lost(0){
+
+    /* Same Search Order as the Writer */
+    int fd = open((SHM_RING_HUGEPAGE_PATH + name).c_str(), O_RDONLY);
+    if (fd < 0)
+        fd = shm_open(("/" + name).c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(shm_ring_header)){
+        close(fd);
+        return;
+    }
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return;
+
+    /* Validate Layout */
+    shm_ring_header* h = (shm_ring_header*)map;
+    if (h->magic != SHM_RING_MAGIC || h->version != SHM_RING_VERSION ||
+        h->slot_size != sizeof(shm_slot) || ring_bytes(h->num_slots) > (size_t)st.st_size){
+        munmap(map, st.st_size);
+        return;
+    }
+    atomic_thread_fence(memory_order_acquire);
+
+    header = h;
+    slots = ring_slots(header);
+    map_size = st.st_size;
+
+    /* Start Live */
+    cursor = header->head.load(memory_order_acquire);
+}
+
+shm_reader::~shm_reader(){
+    if (header != NULL)
+        munmap(header, map_size);
+}
+
+
+/* Copy Next Packet */
+int shm_reader::read(rx_packet* packet, int timeout_ms){
+
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(timeout_ms);
+    while (header->head.load(memory_order_acquire) <= cursor){
+        if (header->is_closed || chrono::steady_clock::now() >= deadline)
+            return 0;
+        this_thread::sleep_for(chrono::microseconds(100));
+    }
+
+    const shm_slot& slot = slots[cursor % header->num_slots];
+    uint64_t before = slot.sequence.load(memory_order_acquire);
+    if (before == 2 * cursor + 2){
+        memcpy(packet, &slot.packet, sizeof(rx_packet));
+        atomic_thread_fence(memory_order_acquire);
+        if (slot.sequence.load(memory_order_relaxed) == before){
+            cursor++;
+            return 1;
+        }
+    }
+
+    /* Slot Reused by a Later Packet */
+    num_overruns++;
+    resync();
+    return -1;
+}
+
+/* Jump to the Oldest Packet Unlikely to be Overwritten Before it is Read */
+void shm_reader::resync(){
+    uint64_t head = header->head.load(memory_order_acquire);
+    uint64_t oldest = head > header->num_slots / 2 ? head - header->num_slots / 2 : 0;
+    if (oldest > cursor){
+        num_lost += oldest - cursor;
+        cursor = oldest;
+    } else {
+        num_lost++;
+        cursor++;
+    }
+}
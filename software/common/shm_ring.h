@@ -0,0 +1,89 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <string>
+#include <atomic>
+#include <stdint.h>
+#include <stddef.h>
+#include "rx_ring.h"
+using namespace std;
+
+/* Shared Memory Layout Identification */
+#define SHM_RING_MAGIC 0x50505352                       // "RSPP"
+#define SHM_RING_VERSION 1
+
+/* Hugetlbfs Mount Tried Before POSIX Shared Memory */
+#define SHM_RING_HUGEPAGE_PATH "/dev/hugepages/"
+#define SHM_RING_HUGEPAGE_SIZE (2 * 1024 * 1024)
+
+/* Ring Header - Start of the Mapping */
+class shm_ring_header {
+    public:
+        uint32_t magic;
+        uint32_t version;
+        uint64_t num_slots;
+        uint64_t slot_size;
+        double sample_rate;
+        atomic<uint64_t> head;                          // Packets published
+        atomic<bool> is_closed;                         // Writer has exited
+};
+
+/* Packet Slot - Sequence is 2n+1 while packet n is written, 2n+2 once complete */
+class alignas(64) shm_slot {
+    public:
+        atomic<uint64_t> sequence;
+        rx_packet packet;
+};
+
+/* Single Writer Broadcast Ring in Shared Memory
+ * The writer never waits for readers, it overwrites the oldest slot. Each
+ * slot carries a sequence lock so a reader detects a slot that was
+ * overwritten before or while it was copied.
+ */
+class shm_writer : public packet_tap {
+    public:
+        shm_writer(const string& name, size_t num_slots, double sample_rate);
+        ~shm_writer();                                  // Marks the ring closed & unlinks it
+
+        void offer(const rx_packet& packet);            // Publish, never blocks
+        bool hugepages() const { return on_hugepages; }
+
+    private:
+        string name;
+        string path;                                    // Hugetlbfs file, empty for shm_open
+        shm_ring_header* header;
+        shm_slot* slots;
+        size_t map_size;
+        bool on_hugepages;
+};
+
+/* Reader with a Private Cursor
+ * read() returns 1 with the next packet, 0 if none arrived within the
+ * timeout and -1 on overrun, in which case the cursor has been moved to
+ * the oldest packet still intact and lost() counts the packets skipped.
+ */
+class shm_reader : public packet_source {
+    public:
+        shm_reader(const string& name);
+        ~shm_reader();
+
+        bool attached() const { return header != NULL; }
+        int read(rx_packet* packet, int timeout_ms);
+        bool closed() const { return header->is_closed; }
+
+        double sample_rate() const { return header->sample_rate; }
+        uint64_t overruns() const { return num_overruns; }
+        uint64_t lost() const { return num_lost; }
+
+    private:
+        void resync();
+
+        shm_ring_header* header;
+        shm_slot* slots;
+        size_t map_size;
+        uint64_t cursor;                                // Next packet to read
+        uint64_t num_overruns;
+        uint64_t num_lost;
+};
+
+#endif
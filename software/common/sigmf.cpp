@@ -0,0 +1,461 @@
+#include <cmath>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <linux/fs.h>
+#include "string.h"
+#include "sigmf.h"
+
+using namespace std;
+
+#define SIGMF_VERSION "1.0.0"
+#define SIGMF_DATATYPE "ci16_le"                        // I12 held in int16_t
+#define SIGMF_SAMPLE_BYTES 4
+
+
+/*  JSON  */
+
+/* Escape a String Value */
+static string quote(const string& s){
+    string out = "\"";
+    for (char c : s){
+        if (c == '"' || c == '\\')
+            out += '\\';
+        if ((unsigned char)c < 0x20){
+            char hex[8];
+            snprintf(hex, sizeof(hex), "\\u%04x", c);
+            out += hex;
+            continue;
+        }
+        out += c;
+    }
+    return out + "\"";
+}
+
+
+/* Minimal Parsed Value - Enough for SigMF Metadata */
+class json_value {
+    public:
+        enum kind_t { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT } kind = NUL;
+        string text;                                    // String contents or number literal
+        vector<json_value> items;
+        vector<pair<string, json_value>> members;
+
+        const json_value* get(const string& key) const {
+            for (auto& m : members)
+                if (m.first == key)
+                    return &m.second;
+            return NULL;
+        }
+        double number(double fallback = 0) const { return (kind == NUMBER) ? atof(text.c_str()) : fallback; }
+        uint64_t integer(uint64_t fallback = 0) const { return (kind == NUMBER) ? strtoull(text.c_str(), NULL, 10) : fallback; }
+};
+
+
+static void skip_space(const char*& p){
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+        p++;
+}
+
+
+static bool parse_string(const char*& p, string& out){
+    if (*p != '"')
+        return false;
+    p++;
+    out.clear();
+    while (*p && *p != '"'){
+        if (*p == '\\'){
+            p++;
+            switch (*p){
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                case 'r': out += '\r'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u': {
+                    unsigned code = 0;
+                    if (sscanf(p + 1, "%4x", &code) != 1)
+                        return false;
+                    out += (code < 0x80) ? (char)code : '?';
+                    p += 4;
+                    break;
+                }
+                case '\0': return false;
+                default: out += *p;
+            }
+            p++;
+        }
+        else
+            out += *p++;
+    }
+    if (*p != '"')
+        return false;
+    p++;
+    return true;
+}
+
+
+static bool parse_value(const char*& p, json_value& v, int depth){
+    if (depth > 32)
+        return false;
+    skip_space(p);
+    if (*p == '{'){
+        v.kind = json_value::OBJECT;
+        p++;
+        skip_space(p);
+        if (*p == '}'){
+            p++;
+            return true;
+        }
+        while (true){
+            skip_space(p);
+            pair<string, json_value> member;
+            if (!parse_string(p, member.first))
+                return false;
+            skip_space(p);
+            if (*p++ != ':' || !parse_value(p, member.second, depth + 1))
+                return false;
+            v.members.push_back(member);
+            skip_space(p);
+            if (*p == ','){
+                p++;
+                continue;
+            }
+            return *p++ == '}';
+        }
+    }
+    if (*p == '['){
+        v.kind = json_value::ARRAY;
+        p++;
+        skip_space(p);
+        if (*p == ']'){
+            p++;
+            return true;
+        }
+        while (true){
+            v.items.push_back(json_value());
+            if (!parse_value(p, v.items.back(), depth + 1))
+                return false;
+            skip_space(p);
+            if (*p == ','){
+                p++;
+                continue;
+            }
+            return *p++ == ']';
+        }
+    }
+    if (*p == '"'){
+        v.kind = json_value::STRING;
+        return parse_string(p, v.text);
+    }
+    if (strncmp(p, "true", 4) == 0 || strncmp(p, "false", 5) == 0){
+        v.kind = json_value::BOOLEAN;
+        v.text = (*p == 't') ? "true" : "false";
+        p += v.text.size();
+        return true;
+    }
+    if (strncmp(p, "null", 4) == 0){
+        p += 4;
+        return true;
+    }
+    const char* start = p;
+    while (*p && strchr("+-0123456789.eE", *p))
+        p++;
+    if (p == start)
+        return false;
+    v.kind = json_value::NUMBER;
+    v.text.assign(start, p);
+    return true;
+}
+
+
+/*  TIME  */
+
+/* ISO 8601 UTC with Nanoseconds */
+static string iso8601(time_t second, double fraction){
+    while (fraction < 0){
+        fraction += 1;
+        second--;
+    }
+    uint64_t nanoseconds = (uint64_t)llround(fraction * 1e9);
+    if (nanoseconds >= 1000000000ULL){
+        nanoseconds -= 1000000000ULL;
+        second++;
+    }
+    tm t;
+    gmtime_r(&second, &t);
+    char text[64];
+    size_t n = strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%S", &t);
+    snprintf(text + n, sizeof(text) - n, ".%09lluZ", (unsigned long long)nanoseconds);
+    return text;
+}
+
+
+/* ISO 8601 UTC -> Unix Seconds & Fraction */
+static bool parse_iso8601(const string& text, time_t& second, double& fraction){
+    tm t;
+    memset(&t, 0, sizeof(t));
+    int consumed = 0;
+    if (sscanf(text.c_str(), "%d-%d-%dT%d:%d:%d%n", &t.tm_year, &t.tm_mon, &t.tm_mday,
+               &t.tm_hour, &t.tm_min, &t.tm_sec, &consumed) != 6)
+        return false;
+    t.tm_year -= 1900;
+    t.tm_mon -= 1;
+    second = timegm(&t);
+    fraction = (text[consumed] == '.') ? atof(text.c_str() + consumed) : 0;
+    return true;
+}
+
+
+/*  METADATA  */
+
+string sigmf_metadata(const sigmf_recording& r){
+
+    /* Time of the First Sample from the PPS on the Second */
+    int64_t pps_offset = (int64_t)(r.header.pps_index - r.header.buffer_index);
+    bool pps_in_file = (pps_offset >= 0 && (uint64_t)pps_offset < r.num_samples);
+    string pps_time = iso8601(r.header.unix_stamp, 0);
+
+    ostringstream m;
+    m.precision(17);
+    m << "{\n";
+    m << "    \"global\": {\n";
+    m << "        \"core:datatype\": " << quote(SIGMF_DATATYPE) << ",\n";
+    m << "        \"core:version\": " << quote(SIGMF_VERSION) << ",\n";
+    m << "        \"core:sample_rate\": " << r.sample_rate << ",\n";
+    m << "        \"core:num_channels\": 1,\n";
+    m << "        \"core:hw\": " << quote(r.hardware) << ",\n";
+    m << "        \"core:recorder\": " << quote(r.recorder) << ",\n";
+    m << "        \"core:description\": " << quote(r.description) << "\n";
+    m << "    },\n";
+    m << "    \"captures\": [\n";
+    m << "        {\n";
+    m << "            \"core:sample_start\": 0,\n";
+    m << "            \"core:global_index\": " << r.header.buffer_index << ",\n";
+    m << "            \"core:header_bytes\": " << r.header_bytes << ",\n";
+    m << "            \"core:frequency\": " << r.frequency << ",\n";
+    m << "            \"core:datetime\": " << quote(iso8601(r.header.unix_stamp, -pps_offset / r.sample_rate)) << "\n";
+    m << "        }";
+    if (pps_in_file && pps_offset > 0){
+        m << ",\n        {\n";
+        m << "            \"core:sample_start\": " << pps_offset << ",\n";
+        m << "            \"core:global_index\": " << r.header.pps_index << ",\n";
+        m << "            \"core:frequency\": " << r.frequency << ",\n";
+        m << "            \"core:datetime\": " << quote(pps_time) << "\n";
+        m << "        }";
+    }
+    m << "\n    ],\n";
+    m << "    \"annotations\": [";
+    if (pps_in_file){
+        m << "\n        {\n";
+        m << "            \"core:sample_start\": " << pps_offset << ",\n";
+        m << "            \"core:sample_count\": 1,\n";
+        m << "            \"core:label\": \"PPS\",\n";
+        if (r.has_q_err)
+            m << "            \"gpsdo:q_err\": " << r.q_err << ",\n";
+        m << "            \"core:comment\": " << quote("GPS second " + pps_time) << "\n";
+        m << "        }\n    ";
+    }
+    m << "]\n";
+    m << "}\n";
+    return m.str();
+}
+
+
+bool write_sigmf_meta(const string& base, const sigmf_recording& recording){
+    ofstream file(base + ".sigmf-meta");
+    file << sigmf_metadata(recording);
+    return file.good();
+}
+
+
+bool read_sigmf_meta(const string& base, sigmf_recording& r){
+
+    ifstream file(base + ".sigmf-meta");
+    stringstream text;
+    text << file.rdbuf();
+    string s = text.str();
+    const char* p = s.c_str();
+    json_value root;
+    if (!file || !parse_value(p, root, 0) || root.kind != json_value::OBJECT)
+        return false;
+
+    const json_value* global = root.get("global");
+    const json_value* captures = root.get("captures");
+    const json_value* annotations = root.get("annotations");
+    if (!global || !captures || captures->kind != json_value::ARRAY || captures->items.empty())
+        return false;
+    const json_value* datatype = global->get("core:datatype");
+    if (!datatype || datatype->text != SIGMF_DATATYPE)
+        return false;
+
+    auto text_of = [](const json_value* v){ return v ? v->text : string(); };
+    auto number_of = [](const json_value* v){ return v ? v->number() : 0.0; };
+    auto integer_of = [](const json_value* v){ return v ? v->integer() : 0; };
+    r.sample_rate = number_of(global->get("core:sample_rate"));
+    r.hardware = text_of(global->get("core:hw"));
+    r.recorder = text_of(global->get("core:recorder"));
+    r.description = text_of(global->get("core:description"));
+    if (r.sample_rate <= 0)
+        return false;
+
+    /* First Capture Segment */
+    const json_value& first = captures->items[0];
+    r.frequency = number_of(first.get("core:frequency"));
+    r.header_bytes = integer_of(first.get("core:header_bytes"));
+    r.header.buffer_index = integer_of(first.get("core:global_index"));
+    time_t start_second = 0;
+    double start_fraction = 0;
+    if (first.get("core:datetime"))
+        parse_iso8601(first.get("core:datetime")->text, start_second, start_fraction);
+
+    /* PPS Annotation - Otherwise the First Sample Stands in for the PPS */
+    uint64_t pps_sample = 0;
+    bool pps_found = false;
+    if (annotations && annotations->kind == json_value::ARRAY){
+        for (const json_value& a : annotations->items){
+            if (text_of(a.get("core:label")) == "PPS"){
+                pps_sample = integer_of(a.get("core:sample_start"));
+                pps_found = true;
+                r.has_q_err = (a.get("gpsdo:q_err") != NULL);
+                r.q_err = number_of(a.get("gpsdo:q_err"));
+                break;
+            }
+        }
+    }
+    r.header.pps_index = r.header.buffer_index + pps_sample;
+    double pps_time = start_fraction + pps_sample / r.sample_rate;
+    r.header.unix_stamp = start_second + (time_t)(pps_found ? llround(pps_time) : floor(pps_time));
+    return true;
+}
+
+
+/*  DATA  */
+
+sigmf_copy_method copy_range(int fd_in, off_t offset_in, int fd_out, off_t offset_out, uint64_t length){
+
+    struct stat st_in, st_out;
+    if (fstat(fd_in, &st_in) != 0 || fstat(fd_out, &st_out) != 0)
+        return SIGMF_COPY_FAILED;
+    bool whole_file = (offset_in == 0 && offset_out == 0 && length == 0);
+    if (length == 0)
+        length = (st_in.st_size > offset_in) ? st_in.st_size - offset_in : 0;
+
+    /* Reflink - Whole File or Block Aligned Range */
+    if (whole_file && ioctl(fd_out, FICLONE, fd_in) == 0)
+        return SIGMF_COPY_REFLINK;
+    uint64_t block = st_out.st_blksize;
+    bool to_end = (offset_in + (off_t)length == st_in.st_size);
+    if (!whole_file && offset_in % block == 0 && offset_out % block == 0 && (length % block == 0 || to_end)){
+        file_clone_range range;
+        range.src_fd = fd_in;
+        range.src_offset = offset_in;
+        range.src_length = to_end ? 0 : length;
+        range.dest_offset = offset_out;
+        if (ioctl(fd_out, FICLONERANGE, &range) == 0)
+            return SIGMF_COPY_REFLINK;
+    }
+
+    /* In Kernel Copy - No User Space Buffers, Server Side on NFS & SMB */
+    loff_t in = offset_in, out = offset_out;
+    uint64_t remaining = length;
+    while (remaining > 0){
+        ssize_t n = copy_file_range(fd_in, &in, fd_out, &out, remaining, 0);
+        if (n <= 0)
+            break;
+        remaining -= n;
+    }
+    if (remaining == 0)
+        return SIGMF_COPY_KERNEL;
+
+    /* Read / Write the Rest */
+    vector<char> buffer(1 << 20);
+    while (remaining > 0){
+        ssize_t n = pread(fd_in, buffer.data(), min((uint64_t)buffer.size(), remaining), in);
+        if (n <= 0 || pwrite(fd_out, buffer.data(), n, out) != n)
+            return SIGMF_COPY_FAILED;
+        in += n;
+        out += n;
+        remaining -= n;
+    }
+    return SIGMF_COPY_USER;
+}
+
+
+const char* copy_method_name(sigmf_copy_method method){
+    switch (method){
+        case SIGMF_COPY_REFLINK: return "reflink";
+        case SIGMF_COPY_KERNEL: return "copy_file_range";
+        case SIGMF_COPY_USER: return "read/write";
+        default: return "failed";
+    }
+}
+
+
+sigmf_copy_method sigmf_export(const string& capture, const string& base, sigmf_recording recording){
+
+    int fd_in = open(capture.c_str(), O_RDONLY);
+    if (fd_in < 0)
+        return SIGMF_COPY_FAILED;
+    struct stat st;
+    if (fstat(fd_in, &st) != 0 || (size_t)st.st_size < sizeof(file_header) ||
+        pread(fd_in, &recording.header, sizeof(file_header), 0) != sizeof(file_header)){
+        close(fd_in);
+        return SIGMF_COPY_FAILED;
+    }
+    recording.header_bytes = sizeof(file_header);
+    recording.num_samples = (st.st_size - sizeof(file_header)) / SIGMF_SAMPLE_BYTES;
+
+    /* The Capture Header Stays in Place as core:header_bytes - Keeps the Whole File Reflinkable */
+    int fd_out = open((base + ".sigmf-data").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_out < 0){
+        close(fd_in);
+        return SIGMF_COPY_FAILED;
+    }
+    sigmf_copy_method method = copy_range(fd_in, 0, fd_out, 0, 0);
+    close(fd_in);
+    if (close(fd_out) != 0 || method == SIGMF_COPY_FAILED || !write_sigmf_meta(base, recording))
+        return SIGMF_COPY_FAILED;
+    return method;
+}
+
+
+sigmf_copy_method sigmf_import(const string& base, const string& capture){
+
+    sigmf_recording recording;
+    if (!read_sigmf_meta(base, recording))
+        return SIGMF_COPY_FAILED;
+    int fd_in = open((base + ".sigmf-data").c_str(), O_RDONLY);
+    if (fd_in < 0)
+        return SIGMF_COPY_FAILED;
+    struct stat st;
+    if (fstat(fd_in, &st) != 0 || (uint64_t)st.st_size < recording.header_bytes){
+        close(fd_in);
+        return SIGMF_COPY_FAILED;
+    }
+    int fd_out = open(capture.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_out < 0){
+        close(fd_in);
+        return SIGMF_COPY_FAILED;
+    }
+
+    /* Exported Captures Clone Whole, Header Rewritten in Place - Others Land after a New Header */
+    sigmf_copy_method method;
+    if (recording.header_bytes == sizeof(file_header))
+        method = copy_range(fd_in, 0, fd_out, 0, 0);
+    else
+        method = copy_range(fd_in, recording.header_bytes, fd_out, sizeof(file_header), st.st_size - recording.header_bytes);
+    if (method != SIGMF_COPY_FAILED && pwrite(fd_out, &recording.header, sizeof(file_header), 0) != sizeof(file_header))
+        method = SIGMF_COPY_FAILED;
+    close(fd_in);
+    if (close(fd_out) != 0)
+        method = SIGMF_COPY_FAILED;
+    return method;
+}
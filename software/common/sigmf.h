@@ -0,0 +1,61 @@
+#ifndef SIGMF_H
+#define SIGMF_H
+
+#include <string>
+#include <stdint.h>
+#include <sys/types.h>
+#include "capture_file.h"
+using namespace std;
+
+/* PPS Capture as a SigMF Recording
+ * One recording per capture: <base>.sigmf-data holds ci16_le samples after
+ * header_bytes bytes (24 when the capture file is carried over as is, 0 when
+ * written directly), <base>.sigmf-meta describes it. The meta carries:
+ *   global       core:sample_rate, core:hw (device identity), core:recorder
+ *   captures     first sample - core:global_index = buffer_index, core:datetime of sample 0,
+ *                core:header_bytes; PPS sample - core:datetime on the GPS second
+ *   annotations  "PPS" at the PPS sample with the GPS time as the comment, and gpsdo:q_err
+ *                when the GPSDO reported the pulse's quantisation error
+ */
+class sigmf_recording {
+    public:
+        sigmf_recording() : has_q_err(false), q_err(0) {}
+
+        double sample_rate;
+        double frequency;                               // Centre of the recorded band (Hz)
+        string hardware;                                // Device identity
+        string recorder;
+        string description;
+        file_header header;                             // Unix second of the PPS & full timebase indices
+        uint64_t header_bytes;
+        uint64_t num_samples;
+        bool has_q_err;
+        double q_err;                                   // PPS quantisation error (s), see corrected_pps_index
+};
+
+/* Metadata */
+string sigmf_metadata(const sigmf_recording& recording);
+bool write_sigmf_meta(const string& base, const sigmf_recording& recording);
+bool read_sigmf_meta(const string& base, sigmf_recording& recording);
+
+/* How a Data Range was Copied */
+enum sigmf_copy_method {
+    SIGMF_COPY_FAILED = -1,
+    SIGMF_COPY_REFLINK = 0,                             // Shared extents - no data I/O
+    SIGMF_COPY_KERNEL,                                  // copy_file_range - server side or in kernel
+    SIGMF_COPY_USER                                     // read / write
+};
+
+/* Copy length bytes between files, the cheapest way the filesystem allows -
+ * reflinks need block aligned ranges, or the whole file with length 0
+ */
+sigmf_copy_method copy_range(int fd_in, off_t offset_in, int fd_out, off_t offset_out, uint64_t length);
+const char* copy_method_name(sigmf_copy_method method);
+
+/* capture.bin -> <base>.sigmf-data/-meta, the data file is a reflink of the capture where possible */
+sigmf_copy_method sigmf_export(const string& capture, const string& base, sigmf_recording recording);
+
+/* <base>.sigmf-data/-meta -> capture.bin */
+sigmf_copy_method sigmf_import(const string& base, const string& capture);
+
+#endif
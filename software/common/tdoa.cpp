@@ -0,0 +1,418 @@
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include "string.h"
+#include "iq_convert.h"
+#include "gpsdo_log.h"
+#include "tdoa.h"
+
+using namespace std;
+
+/* WGS84 Ellipsoid */
+static const double wgs84_a = 6378137.0;
+static const double wgs84_f = 1 / 298.257223563;
+static const double wgs84_e2 = wgs84_f * (2 - wgs84_f);
+
+static const double deg = M_PI / 180;
+
+
+/*  GPSDO POSITION  */
+
+bool gpsdo_position(const string& tty, int num_fixes, int timeout_ms, receiver_position& position){
+
+    int fd = open(tty.c_str(), O_RDONLY | O_NOCTTY);
+    if (fd < 0)
+        return false;
+    termios options;
+    if (tcgetattr(fd, &options) == 0){
+        cfmakeraw(&options);
+        tcsetattr(fd, TCSANOW, &options);
+    }
+
+    /* Average 3D Fixes in ECEF */
+    double sum[3] = { 0, 0, 0 };
+    int fixes = 0;
+    vector<uint8_t> buffer;
+    timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (fixes < num_fixes){
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int remaining = timeout_ms - (int)((now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000);
+        pollfd pfd = { fd, POLLIN, 0 };
+        if (remaining <= 0 || poll(&pfd, 1, remaining) <= 0)
+            break;
+        uint8_t data[GPSDO_LOG_SIZE];
+        ssize_t n = read(fd, data, sizeof(data));
+        if (n <= 0)
+            break;
+        buffer.insert(buffer.end(), data, data + n);
+
+        /* Slide Until a Log Parses, Passing Over Timing Logs */
+        while (buffer.size() >= GPSDO_LOG_SIZE){
+            uint8_t type = gpsdo_log_type(buffer.data());
+            if (type == 0){
+                buffer.erase(buffer.begin());
+                continue;
+            }
+            gpsdo_position_log log;
+            memcpy(&log, buffer.data(), sizeof(log));
+            buffer.erase(buffer.begin(), buffer.begin() + GPSDO_LOG_SIZE);
+            if (type != GPSDO_MESSAGE_POS || log.fix_type < 3)
+                continue;
+            double ecef[3];
+            geodetic_to_ecef(log.lat * 1e-7, log.lon * 1e-7, log.height * 1e-3, ecef);
+            for (int i = 0; i < 3; i++)
+                sum[i] += ecef[i];
+            fixes++;
+        }
+    }
+    close(fd);
+
+    if (fixes == 0)
+        return false;
+    for (int i = 0; i < 3; i++)
+        sum[i] /= fixes;
+    ecef_to_geodetic(sum, position.lat, position.lon, position.height);
+    position.fixes = fixes;
+    return true;
+}
+
+
+/*  GEODESY  */
+
+void geodetic_to_ecef(double lat, double lon, double height, double ecef[3]){
+    double s = sin(lat * deg), c = cos(lat * deg);
+    double n = wgs84_a / sqrt(1 - wgs84_e2 * s * s);
+    ecef[0] = (n + height) * c * cos(lon * deg);
+    ecef[1] = (n + height) * c * sin(lon * deg);
+    ecef[2] = (n * (1 - wgs84_e2) + height) * s;
+}
+
+
+/* Bowring's Method - Sub-Millimetre at Terrestrial Heights */
+void ecef_to_geodetic(const double ecef[3], double& lat, double& lon, double& height){
+    double b = wgs84_a * (1 - wgs84_f);
+    double ep2 = (wgs84_a * wgs84_a - b * b) / (b * b);
+    double p = sqrt(ecef[0] * ecef[0] + ecef[1] * ecef[1]);
+    double theta = atan2(ecef[2] * wgs84_a, p * b);
+    double phi = atan2(ecef[2] + ep2 * b * pow(sin(theta), 3), p - wgs84_e2 * wgs84_a * pow(cos(theta), 3));
+    double n = wgs84_a / sqrt(1 - wgs84_e2 * sin(phi) * sin(phi));
+    lat = phi / deg;
+    lon = atan2(ecef[1], ecef[0]) / deg;
+    height = p / cos(phi) - n;
+}
+
+
+enu_frame::enu_frame(double lat, double lon, double height){
+    geodetic_to_ecef(lat, lon, height, origin);
+    double sl = sin(lat * deg), cl = cos(lat * deg);
+    double so = sin(lon * deg), co = cos(lon * deg);
+    double r[3][3] = { { -so, co, 0 }, { -sl * co, -sl * so, cl }, { cl * co, cl * so, sl } };
+    memcpy(rotation, r, sizeof(rotation));
+}
+
+
+void enu_frame::to_enu(const double ecef[3], double enu[3]) const {
+    double d[3] = { ecef[0] - origin[0], ecef[1] - origin[1], ecef[2] - origin[2] };
+    for (int i = 0; i < 3; i++)
+        enu[i] = rotation[i][0] * d[0] + rotation[i][1] * d[1] + rotation[i][2] * d[2];
+}
+
+
+void enu_frame::to_ecef(const double enu[3], double ecef[3]) const {
+    for (int i = 0; i < 3; i++)
+        ecef[i] = origin[i] + rotation[0][i] * enu[0] + rotation[1][i] * enu[1] + rotation[2][i] * enu[2];
+}
+
+
+/*  ENGINE  */
+
+/* Array Centroid - Origin of the Local Frame */
+static receiver_position centroid(const vector<receiver_position>& receivers){
+    double sum[3] = { 0, 0, 0 };
+    for (const receiver_position& r : receivers){
+        double ecef[3];
+        geodetic_to_ecef(r.lat, r.lon, r.height, ecef);
+        for (int i = 0; i < 3; i++)
+            sum[i] += ecef[i] / receivers.size();
+    }
+    receiver_position c;
+    ecef_to_geodetic(sum, c.lat, c.lon, c.height);
+    return c;
+}
+
+
+tdoa_engine::tdoa_engine(tdoa_configuration config, const vector<receiver_position>& receivers)
+    : config(config), num_receivers(receivers.size()),
+      frame(centroid(receivers).lat, centroid(receivers).lon, centroid(receivers).height),
+      array_radius(1), estimator(config.max_window, config.upsample){
+
+    for (const receiver_position& r : receivers){
+        double ecef[3], enu[3];
+        geodetic_to_ecef(r.lat, r.lon, r.height, ecef);
+        frame.to_enu(ecef, enu);
+        positions.push_back(vector<double>(enu, enu + 3));
+        array_radius = max(array_radius, sqrt(enu[0] * enu[0] + enu[1] * enu[1] + enu[2] * enu[2]));
+    }
+}
+
+
+/* Burst Detection
+ * Block power per receiver against its 20th percentile block as the noise
+ * floor. The reference must see the burst, the span covers every receiver
+ * that does plus the guard so weaker receivers' delayed copies are kept.
+ */
+burst_span tdoa_engine::detect(const int16_t* samples, size_t frame_length, uint32_t valid_mask) const {
+
+    burst_span span = { false, 0, 0 };
+    size_t num_blocks = frame_length / config.block_length;
+    if (num_blocks < 5 || !(valid_mask & (1u << config.reference)))
+        return span;
+
+    const double ratio = pow(10, config.threshold / 10);
+    size_t first = num_blocks, last = 0;
+    bool reference_found = false;
+    vector<double> power(num_blocks), sorted(num_blocks);
+    for (int d = 0; d < num_receivers; d++){
+        if (!(valid_mask & (1u << d)))
+            continue;
+        for (size_t b = 0; b < num_blocks; b++){
+            int64_t sum = 0;
+            const int16_t* s = samples + (b * config.block_length * num_receivers + d) * 2;
+            for (size_t k = 0; k < config.block_length; k++, s += num_receivers * 2)
+                sum += (int32_t)s[0] * s[0] + (int32_t)s[1] * s[1];
+            power[b] = sorted[b] = sum;
+        }
+        nth_element(sorted.begin(), sorted.begin() + num_blocks / 5, sorted.end());
+        double floor = max(sorted[num_blocks / 5], 1.0 * config.block_length);
+        for (size_t b = 0; b < num_blocks; b++){
+            if (power[b] > floor * ratio){
+                first = min(first, b);
+                last = max(last, b);
+                if (d == config.reference)
+                    reference_found = true;
+            }
+        }
+    }
+    if (!reference_found)
+        return span;
+
+    size_t start = first * config.block_length;
+    size_t end = min((last + 1) * config.block_length + config.guard, frame_length);
+    start = (start > config.guard) ? start - config.guard : 0;
+    span.found = true;
+    span.start = start;
+    span.length = min(end - start, config.max_window);
+    return span;
+}
+
+
+tdoa_fix tdoa_engine::locate(time_t gps_second, uint32_t offset, uint32_t valid_mask,
+                             const int16_t* samples, size_t frame_length) const {
+
+    tdoa_fix fix;
+    fix.valid = false;
+    fix.gps_second = gps_second;
+    fix.offset = offset / config.sample_rate;
+    fix.receivers = 0;
+    burst_span span = detect(samples, frame_length, valid_mask);
+    if (!span.found)
+        return fix;
+
+    /* De-interleave the Burst */
+    vector<vector<complex<float>>> windows(num_receivers);
+    for (int d = 0; d < num_receivers; d++){
+        if (!(valid_mask & (1u << d)))
+            continue;
+        windows[d].resize(span.length);
+        const int16_t* s = samples + (span.start * num_receivers + d) * 2;
+        for (size_t k = 0; k < span.length; k++, s += num_receivers * 2)
+            windows[d][k] = complex<float>(s[0], s[1]) * I12_SCALE;
+    }
+
+    /* Pairwise TDOA Against the Reference */
+    vector<double> tdoa(num_receivers, numeric_limits<double>::quiet_NaN());
+    tdoa[config.reference] = 0;
+    for (int d = 0; d < num_receivers; d++){
+        if (d == config.reference || windows[d].empty())
+            continue;
+        delay_estimate e = estimator.estimate(windows[config.reference].data(), windows[d].data(), span.length);
+        if (e.peak >= config.min_peak)
+            tdoa[d] = e.delay / config.sample_rate;
+    }
+
+    fix = solve(tdoa);
+    fix.gps_second = gps_second;
+    fix.offset = (offset + span.start) / config.sample_rate;
+    return fix;
+}
+
+
+/* Solve a Small Dense System in Place - Partial Pivoting */
+static bool solve_linear(double a[3][3], double b[3], int n){
+    for (int c = 0; c < n; c++){
+        int p = c;
+        for (int r = c + 1; r < n; r++)
+            if (fabs(a[r][c]) > fabs(a[p][c]))
+                p = r;
+        if (fabs(a[p][c]) < 1e-12)
+            return false;
+        swap(a[p], a[c]);
+        swap(b[p], b[c]);
+        for (int r = c + 1; r < n; r++){
+            double m = a[r][c] / a[c][c];
+            for (int k = c; k < n; k++)
+                a[r][k] -= m * a[c][k];
+            b[r] -= m * b[c];
+        }
+    }
+    for (int c = n - 1; c >= 0; c--){
+        for (int k = c + 1; k < n; k++)
+            b[c] -= a[c][k] * b[k];
+        b[c] /= a[c][c];
+    }
+    return true;
+}
+
+
+/* Levenberg Damped Gauss-Newton on the Range Differences - true on Convergence */
+bool tdoa_engine::gauss_newton(const vector<double>& range_difference, int dims, double x[3], double& rms, int& iterations) const {
+
+    const vector<double>& ref = positions[config.reference];
+
+    /* Residuals & Jacobian at a Point */
+    auto evaluate = [&](const double* p, vector<double>& f, vector<double>* jacobian){
+        f.clear();
+        if (jacobian)
+            jacobian->clear();
+        double dr[3], rr = 0;
+        for (int i = 0; i < 3; i++){
+            dr[i] = p[i] - ref[i];
+            rr += dr[i] * dr[i];
+        }
+        rr = max(sqrt(rr), 1e-6);
+        for (int d = 0; d < num_receivers; d++){
+            if (d == config.reference || std::isnan(range_difference[d]))
+                continue;
+            double di[3], ri = 0;
+            for (int i = 0; i < 3; i++){
+                di[i] = p[i] - positions[d][i];
+                ri += di[i] * di[i];
+            }
+            ri = max(sqrt(ri), 1e-6);
+            f.push_back(ri - rr - range_difference[d]);
+            if (jacobian)
+                for (int i = 0; i < dims; i++)
+                    jacobian->push_back(di[i] / ri - dr[i] / rr);
+        }
+        double cost = 0;
+        for (double v : f)
+            cost += v * v;
+        return cost;
+    };
+
+    vector<double> f, j, trial_f;
+    double cost = evaluate(x, f, &j);
+    double lambda = 1e-3;
+    bool converged = false;
+    for (iterations = 0; iterations < config.max_iterations && !converged; iterations++){
+
+        /* Normal Equations with Diagonal Damping */
+        double a[3][3] = {}, g[3] = {};
+        size_t m = f.size();
+        for (size_t r = 0; r < m; r++){
+            for (int p = 0; p < dims; p++){
+                g[p] -= j[r * dims + p] * f[r];
+                for (int q = 0; q < dims; q++)
+                    a[p][q] += j[r * dims + p] * j[r * dims + q];
+            }
+        }
+
+        /* Raise the Damping Until a Step Reduces the Cost */
+        while (true){
+            double damped[3][3], step[3];
+            memcpy(damped, a, sizeof(a));
+            memcpy(step, g, sizeof(g));
+            for (int p = 0; p < dims; p++)
+                damped[p][p] += lambda * (a[p][p] + 1e-9);
+            if (!solve_linear(damped, step, dims))
+                return false;
+
+            double trial[3] = { x[0], x[1], x[2] };
+            double norm = 0;
+            for (int p = 0; p < dims; p++){
+                trial[p] += step[p];
+                norm += step[p] * step[p];
+            }
+            double trial_cost = evaluate(trial, trial_f, NULL);
+            if (trial_cost <= cost){
+                memcpy(x, trial, sizeof(trial));
+                cost = evaluate(x, f, &j);
+                lambda = max(lambda * 0.1, 1e-12);
+                converged = (sqrt(norm) < 1e-3);
+                break;
+            }
+            lambda *= 10;
+            if (lambda > 1e12){
+                converged = true;                       // No Descent Left - at a Minimum
+                break;
+            }
+        }
+    }
+    rms = sqrt(cost / max((size_t)1, f.size()));
+    return converged;
+}
+
+
+tdoa_fix tdoa_engine::solve(const vector<double>& tdoa) const {
+
+    tdoa_fix fix;
+    fix.valid = false;
+    fix.tdoa = tdoa;
+    fix.rms = numeric_limits<double>::infinity();
+    fix.iterations = 0;
+
+    /* Range Differences - Need One per Unknown */
+    int dims = config.solve_height ? 3 : 2;
+    vector<double> range_difference(num_receivers);
+    fix.receivers = 1;
+    for (int d = 0; d < num_receivers; d++){
+        range_difference[d] = tdoa[d] * SPEED_OF_LIGHT;
+        if (d != config.reference && !std::isnan(tdoa[d]))
+            fix.receivers++;
+    }
+    if (fix.receivers - 1 < dims)
+        return fix;
+
+    /* Start at the Centroid & on a Ring Outside the Array - Keep the Best */
+    double best[3] = { 0, 0, 0 };
+    for (int s = 0; s < 9; s++){
+        double x[3] = { 0, 0, 0 };
+        if (s > 0){
+            x[0] = 2 * array_radius * cos(s * M_PI / 4);
+            x[1] = 2 * array_radius * sin(s * M_PI / 4);
+        }
+        double rms;
+        int iterations;
+        if (gauss_newton(range_difference, dims, x, rms, iterations) && rms < fix.rms){
+            memcpy(best, x, sizeof(best));
+            fix.rms = rms;
+            fix.iterations = iterations;
+            fix.valid = true;
+        }
+    }
+    if (!fix.valid)
+        return fix;
+
+    fix.east = best[0];
+    fix.north = best[1];
+    fix.up = best[2];
+    double ecef[3];
+    frame.to_ecef(best, ecef);
+    ecef_to_geodetic(ecef, fix.lat, fix.lon, fix.height);
+    return fix;
+}
@@ -0,0 +1,110 @@
+#ifndef TDOA_H
+#define TDOA_H
+
+#include <ctime>
+#include <string>
+#include <vector>
+#include <complex>
+#include <stdint.h>
+#include "delay_estimator.h"
+using namespace std;
+
+#define SPEED_OF_LIGHT 299792458.0
+
+/* Receiver Antenna Position */
+class receiver_position {
+    public:
+        string name;                                    // Capture ring name
+        double lat, lon;                                // Degrees
+        double height;                                  // Metres above the WGS84 ellipsoid
+        int fixes;                                      // GPSDO fixes averaged, 0 if entered by hand
+};
+
+/* Average the NAV-PVT Position Logs a GPSDO Sends over USB - 3D Fixes Only */
+bool gpsdo_position(const string& tty, int num_fixes, int timeout_ms, receiver_position& position);
+
+/* WGS84 Conversions */
+void geodetic_to_ecef(double lat, double lon, double height, double ecef[3]);
+void ecef_to_geodetic(const double ecef[3], double& lat, double& lon, double& height);
+
+/* Local East / North / Up Frame */
+class enu_frame {
+    public:
+        enu_frame(double lat, double lon, double height);
+        void to_enu(const double ecef[3], double enu[3]) const;
+        void to_ecef(const double enu[3], double ecef[3]) const;
+
+    private:
+        double origin[3];
+        double rotation[3][3];                          // Rows are east, north, up in ECEF
+};
+
+/* Engine Configuration */
+class tdoa_configuration {
+    public:
+        int reference;                                  // TDOAs are taken against this receiver
+        int upsample;                                   // Correlation interpolation grid
+        size_t max_window;                              // Longest burst correlated (samples)
+        double min_peak;                                // Drop receivers with a weaker correlation
+        size_t block_length;                            // Burst detector power block (samples)
+        double threshold;                               // Burst detection above the noise floor (dB)
+        size_t guard;                                   // Samples kept either side of the burst
+        bool solve_height;                              // 3D fix, otherwise the height is held at the array centroid
+        int max_iterations;
+        double sample_rate;
+};
+
+/* Burst Common to the Receivers within One Frame */
+class burst_span {
+    public:
+        bool found;
+        size_t start;                                   // Samples into the frame
+        size_t length;
+};
+
+/* Located Emitter */
+class tdoa_fix {
+    public:
+        bool valid;
+        time_t gps_second;
+        double offset;                                  // Burst start after the PPS (seconds)
+        int receivers;                                  // Receivers used in the solution
+        double east, north, up;                         // Metres from the array centroid
+        double lat, lon, height;
+        double rms;                                     // Range difference residual (metres)
+        int iterations;
+        vector<double> tdoa;                            // Seconds against the reference, NaN if unused
+};
+
+/* TDOA Multilateration over PPS Aligned Frames
+ * Bursts are found on block power against each receiver's noise floor,
+ * the TDOAs measured by sub-sample cross-correlation against the reference
+ * and the position solved by damped Gauss-Newton from several starting
+ * points in an ENU frame about the array centroid. locate() is const, so
+ * one engine can serve a thread pool.
+ */
+class tdoa_engine {
+    public:
+        tdoa_engine(tdoa_configuration config, const vector<receiver_position>& receivers);
+
+        /* Frame of frame_length samples interleaved across receivers (frame_file.h layout) */
+        tdoa_fix locate(time_t gps_second, uint32_t offset, uint32_t valid_mask,
+                        const int16_t* samples, size_t frame_length) const;
+
+        /* Position from TDOAs against the reference, NaN for receivers without one */
+        tdoa_fix solve(const vector<double>& tdoa) const;
+
+        burst_span detect(const int16_t* samples, size_t frame_length, uint32_t valid_mask) const;
+
+    private:
+        bool gauss_newton(const vector<double>& range_difference, int dims, double x[3], double& rms, int& iterations) const;
+
+        tdoa_configuration config;
+        int num_receivers;
+        enu_frame frame;
+        vector<vector<double>> positions;               // ENU
+        double array_radius;
+        delay_estimator estimator;
+};
+
+#endif
@@ -0,0 +1,235 @@
+#include <cmath>
+#include <iostream>
+#include "tone_check.h"
+#include "iq_convert.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+using namespace std;
+
+
+/*  PHASE DIFFERENCE KERNELS  */
+/* d = x[k+1] * conj(x[k]), e = d * conj(rot), break if angle(e) > threshold
+ * i.e. e.re * |e.re| < cos^2(threshold) * |e|^2, which avoids sqrt & atan2.
+ */
+
+size_t phase_diff_scalar(const complex<float>* x, size_t num_pairs, complex<float> rot,
+                         float cos2_threshold, float* sum){
+    const float* f = (const float*)x;
+    float rr = rot.real(), ri = rot.imag();
+    float sr = 0, si = 0;
+    size_t breaks = 0;
+    for (size_t k = 0; k < num_pairs; k++){
+        float ar = f[2 * k], ai = f[2 * k + 1];
+        float br = f[2 * k + 2], bi = f[2 * k + 3];
+        float dre = br * ar + bi * ai;
+        float dim = bi * ar - br * ai;
+        sr += dre;
+        si += dim;
+        float ere = dre * rr + dim * ri;
+        float eim = dim * rr - dre * ri;
+        if (ere * fabsf(ere) < cos2_threshold * (ere * ere + eim * eim))
+            breaks++;
+    }
+    sum[0] = sr;
+    sum[1] = si;
+    return breaks;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/* hadd / hsub Pair Up Adjacent Products - Lane Order is Shuffled but Only Sums & Counts are Kept */
+__attribute__((target("sse4.1")))
+static size_t phase_diff_sse(const complex<float>* x, size_t num_pairs, complex<float> rot,
+                             float cos2_threshold, float* sum){
+    const float* f = (const float*)x;
+    const __m128 rr = _mm_set1_ps(rot.real()), ri = _mm_set1_ps(rot.imag());
+    const __m128 c2 = _mm_set1_ps(cos2_threshold);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 sr = _mm_setzero_ps(), si = _mm_setzero_ps();
+    size_t breaks = 0, k = 0;
+    for (; k + 4 <= num_pairs; k += 4){
+        __m128 a0 = _mm_loadu_ps(&f[2 * k]), a1 = _mm_loadu_ps(&f[2 * k + 4]);
+        __m128 b0 = _mm_loadu_ps(&f[2 * k + 2]), b1 = _mm_loadu_ps(&f[2 * k + 6]);
+        __m128 dre = _mm_hadd_ps(_mm_mul_ps(a0, b0), _mm_mul_ps(a1, b1));
+        __m128 dim = _mm_hsub_ps(_mm_mul_ps(a0, _mm_shuffle_ps(b0, b0, 0xB1)),
+                                 _mm_mul_ps(a1, _mm_shuffle_ps(b1, b1, 0xB1)));
+        sr = _mm_add_ps(sr, dre);
+        si = _mm_add_ps(si, dim);
+        __m128 ere = _mm_add_ps(_mm_mul_ps(dre, rr), _mm_mul_ps(dim, ri));
+        __m128 eim = _mm_sub_ps(_mm_mul_ps(dim, rr), _mm_mul_ps(dre, ri));
+        __m128 lhs = _mm_mul_ps(ere, _mm_andnot_ps(sign, ere));
+        __m128 rhs = _mm_mul_ps(c2, _mm_add_ps(_mm_mul_ps(ere, ere), _mm_mul_ps(eim, eim)));
+        breaks += __builtin_popcount(_mm_movemask_ps(_mm_cmplt_ps(lhs, rhs)));
+    }
+    float lr[4], li[4];
+    _mm_storeu_ps(lr, sr);
+    _mm_storeu_ps(li, si);
+    breaks += phase_diff_scalar(&x[k], num_pairs - k, rot, cos2_threshold, sum);
+    sum[0] += lr[0] + lr[1] + lr[2] + lr[3];
+    sum[1] += li[0] + li[1] + li[2] + li[3];
+    return breaks;
+}
+
+__attribute__((target("avx2")))
+static size_t phase_diff_avx2(const complex<float>* x, size_t num_pairs, complex<float> rot,
+                              float cos2_threshold, float* sum){
+    const float* f = (const float*)x;
+    const __m256 rr = _mm256_set1_ps(rot.real()), ri = _mm256_set1_ps(rot.imag());
+    const __m256 c2 = _mm256_set1_ps(cos2_threshold);
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    __m256 sr = _mm256_setzero_ps(), si = _mm256_setzero_ps();
+    size_t breaks = 0, k = 0;
+    for (; k + 8 <= num_pairs; k += 8){
+        __m256 a0 = _mm256_loadu_ps(&f[2 * k]), a1 = _mm256_loadu_ps(&f[2 * k + 8]);
+        __m256 b0 = _mm256_loadu_ps(&f[2 * k + 2]), b1 = _mm256_loadu_ps(&f[2 * k + 10]);
+        __m256 dre = _mm256_hadd_ps(_mm256_mul_ps(a0, b0), _mm256_mul_ps(a1, b1));
+        __m256 dim = _mm256_hsub_ps(_mm256_mul_ps(a0, _mm256_permute_ps(b0, 0xB1)),
+                                    _mm256_mul_ps(a1, _mm256_permute_ps(b1, 0xB1)));
+        sr = _mm256_add_ps(sr, dre);
+        si = _mm256_add_ps(si, dim);
+        __m256 ere = _mm256_add_ps(_mm256_mul_ps(dre, rr), _mm256_mul_ps(dim, ri));
+        __m256 eim = _mm256_sub_ps(_mm256_mul_ps(dim, rr), _mm256_mul_ps(dre, ri));
+        __m256 lhs = _mm256_mul_ps(ere, _mm256_andnot_ps(sign, ere));
+        __m256 rhs = _mm256_mul_ps(c2, _mm256_add_ps(_mm256_mul_ps(ere, ere), _mm256_mul_ps(eim, eim)));
+        breaks += __builtin_popcount(_mm256_movemask_ps(_mm256_cmp_ps(lhs, rhs, _CMP_LT_OQ)));
+    }
+    float lr[8], li[8];
+    _mm256_storeu_ps(lr, sr);
+    _mm256_storeu_ps(li, si);
+    breaks += phase_diff_scalar(&x[k], num_pairs - k, rot, cos2_threshold, sum);
+    for (int i = 0; i < 8; i++){
+        sum[0] += lr[i];
+        sum[1] += li[i];
+    }
+    return breaks;
+}
+
+#endif
+
+#if defined(__aarch64__)
+
+static size_t phase_diff_neon(const complex<float>* x, size_t num_pairs, complex<float> rot,
+                              float cos2_threshold, float* sum){
+    const float* f = (const float*)x;
+    const float32x4_t rr = vdupq_n_f32(rot.real()), ri = vdupq_n_f32(rot.imag());
+    const float32x4_t c2 = vdupq_n_f32(cos2_threshold);
+    float32x4_t sr = vdupq_n_f32(0), si = vdupq_n_f32(0);
+    uint32x4_t count = vdupq_n_u32(0);
+    size_t k = 0;
+    for (; k + 4 <= num_pairs; k += 4){
+        float32x4x2_t a = vld2q_f32(&f[2 * k]);
+        float32x4x2_t b = vld2q_f32(&f[2 * k + 2]);
+        float32x4_t dre = vfmaq_f32(vmulq_f32(b.val[0], a.val[0]), b.val[1], a.val[1]);
+        float32x4_t dim = vfmsq_f32(vmulq_f32(b.val[1], a.val[0]), b.val[0], a.val[1]);
+        sr = vaddq_f32(sr, dre);
+        si = vaddq_f32(si, dim);
+        float32x4_t ere = vfmaq_f32(vmulq_f32(dre, rr), dim, ri);
+        float32x4_t eim = vfmsq_f32(vmulq_f32(dim, rr), dre, ri);
+        float32x4_t lhs = vmulq_f32(ere, vabsq_f32(ere));
+        float32x4_t rhs = vmulq_f32(c2, vfmaq_f32(vmulq_f32(ere, ere), eim, eim));
+        count = vsubq_u32(count, vcltq_f32(lhs, rhs));
+    }
+    size_t breaks = phase_diff_scalar(&x[k], num_pairs - k, rot, cos2_threshold, sum);
+    sum[0] += vaddvq_f32(sr);
+    sum[1] += vaddvq_f32(si);
+    return breaks + vaddvq_u32(count);
+}
+
+#endif
+
+/* Dispatch on the Conversion Kernel ISA */
+size_t phase_diff(const complex<float>* x, size_t num_pairs, complex<float> rot,
+                  float cos2_threshold, float* sum){
+    switch (iq_get_isa()){
+#if defined(__x86_64__) || defined(__i386__)
+        case IQ_ISA_AVX2:   return phase_diff_avx2(x, num_pairs, rot, cos2_threshold, sum);
+        case IQ_ISA_SSE:    return phase_diff_sse(x, num_pairs, rot, cos2_threshold, sum);
+#endif
+#if defined(__aarch64__)
+        case IQ_ISA_NEON:   return phase_diff_neon(x, num_pairs, rot, cos2_threshold, sum);
+#endif
+        default:            return phase_diff_scalar(x, num_pairs, rot, cos2_threshold, sum);
+    }
+}
+
+
+/*  TONE CHECK  */
+
+tone_check::tone_check(double tone_frequency, double threshold)
+    : nominal(fabs(tone_frequency)), locked(false), reference_power(0),
+      samples(RX_PACKET_SAMPLES + 1), next_index(0),
+      num_checked(0), num_flagged(0), min_frequency(0), max_frequency(0){
+    float c = (float)cos(threshold);
+    cos2_threshold = c * c;
+}
+
+
+/* Check One Packet */
+tone_result tone_check::check(const rx_packet& packet){
+
+    tone_result result;
+    result.boundary_break = false;
+    result.low_level = false;
+    float sum[2];
+
+    /* Carry the Previous Last Sample Across Contiguous Packets */
+    bool contiguous = locked && packet.index == next_index;
+    iq_i16_to_cf32(packet.samples, &samples[1], RX_PACKET_SAMPLES, I12_SCALE);
+    const complex<float>* x = contiguous ? &samples[0] : &samples[1];
+    size_t num_pairs = contiguous ? RX_PACKET_SAMPLES : RX_PACKET_SAMPLES - 1;
+
+    /* Lock to the Tone Sign & Level on the First Packet */
+    if (!locked){
+        phase_diff(x, num_pairs, complex<float>(1, 0), 0, sum);
+        double w = 2 * M_PI * (atan2(sum[1], sum[0]) >= 0 ? nominal : -nominal);
+        rot = complex<float>((float)cos(w), (float)sin(w));
+        reference_power = hypot(sum[0], sum[1]) / num_pairs;
+        locked = true;
+    }
+
+    result.breaks = phase_diff(x, num_pairs, rot, cos2_threshold, sum);
+    result.frequency = atan2(sum[1], sum[0]) / (2 * M_PI);
+    result.low_level = hypot(sum[0], sum[1]) / num_pairs < 0.25 * reference_power;
+    if (contiguous){
+        float step[2];
+        result.boundary_break = phase_diff_scalar(x, 1, rot, cos2_threshold, step) > 0;
+    }
+
+    samples[0] = samples[RX_PACKET_SAMPLES];
+    next_index = packet.index + RX_PACKET_SAMPLES;
+    return result;
+}
+
+
+/* Check & Count - Runs on the Assembler Thread */
+void tone_check::offer(const rx_packet& packet){
+    tone_result result = check(packet);
+    if (num_checked == 0 || result.frequency < min_frequency)
+        min_frequency = result.frequency;
+    if (num_checked == 0 || result.frequency > max_frequency)
+        max_frequency = result.frequency;
+    num_checked++;
+
+    if (result.breaks > 0 || result.low_level){
+        num_flagged++;
+        if (first_flagged.size() < 10)
+            first_flagged.push_back(packet.index);
+    }
+}
+
+
+/* Print Summary */
+void tone_check::report() const {
+    cout << "Self test: " << num_checked << " packets checked, " << num_flagged << " with phase breaks" << endl;
+    cout << "Tone frequency " << min_frequency << " to " << max_frequency << " cycles/sample"
+         << " (nominal " << (rot.imag() >= 0 ? nominal : -nominal) << ")" << endl;
+    for (uint64_t index : first_flagged)
+        cout << "Phase break in packet at sample " << index << endl;
+}
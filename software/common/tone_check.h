@@ -0,0 +1,67 @@
+#ifndef TONE_CHECK_H
+#define TONE_CHECK_H
+
+#include <vector>
+#include <complex>
+#include <stdint.h>
+#include <stddef.h>
+#include "rx_ring.h"
+using namespace std;
+
+/* Phase Difference Kernel - x holds num_pairs + 1 complex samples
+ * Accumulates sum of x[k+1] * conj(x[k]) into sum[0] (I) & sum[1] (Q) and
+ * returns the number of steps that differ from rot (the expected step) by
+ * more than acos(sqrt(cos2_threshold)).
+ */
+size_t phase_diff(const complex<float>* x, size_t num_pairs, complex<float> rot,
+                  float cos2_threshold, float* sum);
+size_t phase_diff_scalar(const complex<float>* x, size_t num_pairs, complex<float> rot,
+                         float cos2_threshold, float* sum);
+
+/* Per Packet Result */
+class tone_result {
+    public:
+        double frequency;                               // Estimated tone, cycles per sample
+        size_t breaks;                                  // Phase steps outside the threshold
+        bool boundary_break;                            // Discontinuity against the previous packet
+        bool low_level;                                 // Tone power well below the reference
+};
+
+/* Test Tone Continuity Check
+ * Tracks a constant tone of +/-tone_frequency (cycles per sample) across
+ * contiguous packets and flags any packet containing a phase step away from
+ * the expected rotation - slipped, repeated or corrupted samples inside a
+ * packet or at its boundary with the previous one. The sign of the tone is
+ * taken from the first packet. A whole packet lost or repeated is invisible
+ * when the packet length is a multiple of the tone period (NCODIV8 with 1360
+ * sample packets), those are left to the timestamps.
+ */
+class tone_check : public packet_tap {
+    public:
+        tone_check(double tone_frequency, double threshold);    // threshold in radians
+        tone_result check(const rx_packet& packet);
+        void offer(const rx_packet& packet);                     // check() & count, for the assembler
+        void report() const;
+
+        uint64_t checked() const { return num_checked; }
+        uint64_t flagged() const { return num_flagged; }
+
+    private:
+        double nominal;
+        float cos2_threshold;
+        complex<float> rot;
+        bool locked;                                    // Tone sign & reference level known
+        double reference_power;
+
+        vector<complex<float>> samples;                 // Previous last sample + packet
+        uint64_t next_index;
+
+        /* Statistics */
+        uint64_t num_checked;
+        uint64_t num_flagged;
+        double min_frequency;
+        double max_frequency;
+        vector<uint64_t> first_flagged;                 // Sample indices of the first flagged packets
+};
+
+#endif
@@ -0,0 +1,280 @@
+#include <map>
+#include <cmath>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <string>
+#include <iomanip>
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "string.h"
+#include "../common/iq_convert.h"
+#include "../common/frame_file.h"
+#include "../common/capture_file.h"
+#include "../common/delay_estimator.h"
+
+using namespace std;
+
+// g++ main.cpp ../common/delay_estimator.cpp ../common/fft.cpp ../common/iq_convert.cpp -std=c++11 -O2 -pthread -o delay-analyzer.out
+
+/* Analysis Config */
+const int reference_device = 0;                         // Delays are Reported Against this Device
+const int upsample = 8;                                 // Correlation Interpolation - 1/8 Sample Grid
+const size_t max_window = 16384;                        // Longest Window Correlated (Samples)
+const double min_peak = 0.5;                            // Discard Windows with a Weaker Correlation
+
+/* One Window of One Device Pair */
+class pair_result {
+    public:
+        time_t second;
+        int device;
+        bool valid;
+        delay_estimate estimate;
+};
+
+/* Aligned Windows - Frames from a Container or One PPS Capture Set per Second */
+class window_source {
+    public:
+        virtual ~window_source() {}
+        virtual size_t size() const = 0;
+        virtual int devices() const = 0;
+
+        /* Load Window i - Thread Safe, returns the Second & Sets Missing Devices Empty */
+        virtual time_t load(size_t i, vector<vector<complex<float>>>& windows) const = 0;
+};
+
+
+/* .frames Container from pps_aggregator / pps_collector */
+class frame_window_source : public window_source {
+    public:
+        frame_window_source(const string& name){
+            fd = open(name.c_str(), O_RDONLY);
+            struct stat st;
+            if (fd < 0 || fstat(fd, &st) != 0 || pread(fd, &header, sizeof(header), 0) != sizeof(header) ||
+                header.magic != FRAME_FILE_MAGIC){
+                num_frames = 0;
+                return;
+            }
+            frame_size = sizeof(frame_header) + header.num_devices * sizeof(uint64_t) +
+                         (size_t)header.frame_length * header.num_devices * 2 * sizeof(int16_t);
+            num_frames = (st.st_size - sizeof(header)) / frame_size;
+        }
+        ~frame_window_source(){ if (fd >= 0) close(fd); }
+
+        size_t size() const { return num_frames; }
+        int devices() const { return header.num_devices; }
+
+        time_t load(size_t i, vector<vector<complex<float>>>& windows) const {
+            vector<char> frame(frame_size);
+            if (pread(fd, frame.data(), frame_size, sizeof(header) + i * frame_size) != (ssize_t)frame_size)
+                return 0;
+            const frame_header* fh = (const frame_header*)frame.data();
+            const int16_t* samples = (const int16_t*)(frame.data() + sizeof(frame_header) + header.num_devices * sizeof(uint64_t));
+
+            /* De-interleave Devices */
+            size_t len = min((size_t)header.frame_length, max_window);
+            for (uint32_t d = 0; d < header.num_devices; d++){
+                windows[d].clear();
+                if (!(fh->valid_mask & (1u << d)))
+                    continue;
+                windows[d].resize(len);
+                for (size_t k = 0; k < len; k++)
+                    windows[d][k] = complex<float>(samples[(k * header.num_devices + d) * 2],
+                                                   samples[(k * header.num_devices + d) * 2 + 1]) * I12_SCALE;
+            }
+            return fh->gps_second;
+        }
+
+    private:
+        int fd;
+        frame_file_header header;
+        size_t frame_size;
+        size_t num_frames;
+};
+
+
+/* Per Device Captures <dir>/<device>_<unix>.bin from pps_sync_rx - Aligned on the PPS Sample */
+class capture_window_source : public window_source {
+    public:
+        capture_window_source(const string& dir, int num_devices) : dir(dir), num_devices(num_devices){
+
+            /* Seconds Captured by Every Device */
+            map<time_t, int> counts;
+            DIR* d = opendir(dir.c_str());
+            if (d == NULL)
+                return;
+            dirent* entry;
+            while ((entry = readdir(d)) != NULL){
+                int device;
+                long long stamp;
+                char ext[8];
+                if (sscanf(entry->d_name, "%d_%lld.%3s", &device, &stamp, ext) == 3 && strcmp(ext, "bin") == 0 &&
+                    device >= 0 && device < num_devices)
+                    counts[(time_t)stamp]++;
+            }
+            closedir(d);
+            for (auto& c : counts)
+                if (c.second == num_devices)
+                    seconds.push_back(c.first);
+        }
+
+        size_t size() const { return seconds.size(); }
+        int devices() const { return num_devices; }
+
+        time_t load(size_t i, vector<vector<complex<float>>>& windows) const {
+
+            /* Read Each Device from its PPS Sample */
+            vector<vector<int16_t>> raw(num_devices);
+            size_t len = max_window;
+            for (int d = 0; d < num_devices; d++){
+                string name = dir + "/" + to_string(d) + "_" + to_string(seconds[i]) + ".bin";
+                int fd = open(name.c_str(), O_RDONLY);
+                struct stat st;
+                file_header header;
+                if (fd < 0 || fstat(fd, &st) != 0 || pread(fd, &header, sizeof(header), 0) != sizeof(header)){
+                    if (fd >= 0)
+                        close(fd);
+                    windows[d].clear();
+                    continue;
+                }
+                size_t num_samples = (st.st_size - sizeof(header)) / 4;
+                size_t offset = header.pps_index - header.buffer_index;
+                size_t available = (offset < num_samples) ? num_samples - offset : 0;
+                len = min(len, available);
+                raw[d].resize(available * 2);
+                if (pread(fd, raw[d].data(), available * 4, sizeof(header) + offset * 4) != (ssize_t)(available * 4))
+                    raw[d].clear();
+                close(fd);
+            }
+
+            /* Common Length from the PPS */
+            for (int d = 0; d < num_devices; d++){
+                windows[d].clear();
+                if (raw[d].size() < len * 2 || len == 0)
+                    continue;
+                windows[d].resize(len);
+                iq_i16_to_cf32(raw[d].data(), windows[d].data(), len, I12_SCALE);
+            }
+            return seconds[i];
+        }
+
+    private:
+        string dir;
+        int num_devices;
+        vector<time_t> seconds;
+};
+
+
+/* Entry Point */
+int main(int argc, char** argv){
+
+    /* Useage */
+    if (argc < 2 || (argc < 3 && string(argv[1]).find(".frames") == string::npos)){
+        cout << "Usage: " << argv[0] << " <capture.frames>" << endl;
+        cout << "       " << argv[0] << " <capture dir> <num devices>" << endl;
+        return 1;
+    }
+
+    unique_ptr<window_source> source;
+    if (argc == 2)
+        source.reset(new frame_window_source(argv[1]));
+    else
+        source.reset(new capture_window_source(argv[1], atoi(argv[2])));
+    const int num_devices = source->devices();
+    const size_t num_windows = source->size();
+    if (num_windows == 0 || num_devices < 2){
+        cout << "No aligned windows found" << endl;
+        return 1;
+    }
+
+    /* Correlate Every Window Against the Reference on All Cores */
+    delay_estimator estimator(max_window, upsample);
+    vector<pair_result> results(num_windows * num_devices);
+    atomic<size_t> next(0);
+    int num_threads = max(1u, thread::hardware_concurrency());
+    cout << "Correlating " << num_windows << " windows of " << num_devices << " devices on " << num_threads << " threads" << endl;
+
+    vector<thread> threads;
+    for (int t = 0; t < num_threads; t++){
+        threads.push_back(thread([&](){
+            vector<vector<complex<float>>> windows(num_devices);
+            size_t i;
+            while ((i = next++) < num_windows){
+                time_t second = source->load(i, windows);
+                const vector<complex<float>>& ref = windows[reference_device];
+                for (int d = 0; d < num_devices; d++){
+                    pair_result& r = results[i * num_devices + d];
+                    r.second = second;
+                    r.device = d;
+                    r.valid = false;
+                    if (d == reference_device || ref.empty() || windows[d].size() != ref.size())
+                        continue;
+                    r.estimate = estimator.estimate(ref.data(), windows[d].data(), ref.size());
+                    r.valid = (r.estimate.peak >= min_peak);
+                }
+            }
+        }));
+    }
+    for (thread& t : threads)
+        t.join();
+
+    /* Accumulate per Second & per Device */
+    class statistics {
+        public:
+            int count = 0;
+            double sum = 0, sum2 = 0;
+            complex<double> phasor = 0;
+            double peak = 0;
+    };
+    map<time_t, vector<statistics>> seconds;
+    vector<statistics> overall(num_devices);
+    for (const pair_result& r : results){
+        if (!r.valid)
+            continue;
+        vector<statistics>& s = seconds[r.second];
+        s.resize(num_devices);
+        for (statistics* st : { &s[r.device], &overall[r.device] }){
+            st->count++;
+            st->sum += r.estimate.delay;
+            st->sum2 += r.estimate.delay * r.estimate.delay;
+            st->phasor += polar(1.0, r.estimate.phase);
+            st->peak += r.estimate.peak;
+        }
+    }
+
+    /* Report - Residual is the Second's Mean Delay Less the Overall Mean */
+    cout << fixed << setprecision(4);
+    cout << "\nsecond,device,windows,mean_delay,std_delay,residual,mean_phase,phase_spread,mean_peak" << endl;
+    for (auto& entry : seconds){
+        for (int d = 0; d < num_devices; d++){
+            const statistics& s = entry.second[d];
+            if (s.count == 0)
+                continue;
+            double mean = s.sum / s.count;
+            double sd = sqrt(max(0.0, s.sum2 / s.count - mean * mean));
+            double overall_mean = overall[d].sum / overall[d].count;
+            double spread = sqrt(max(0.0, -2 * log(abs(s.phasor) / s.count)));
+            cout << entry.first << "," << d << "," << s.count << "," << mean << "," << sd << ","
+                 << mean - overall_mean << "," << arg(s.phasor) << "," << spread << "," << s.peak / s.count << endl;
+        }
+    }
+
+    /* Summary */
+    cout << endl;
+    for (int d = 0; d < num_devices; d++){
+        const statistics& s = overall[d];
+        if (d == reference_device || s.count == 0)
+            continue;
+        double mean = s.sum / s.count;
+        cout << "Device " << d << ": " << s.count << " windows, delay " << mean << " +/- "
+             << sqrt(max(0.0, s.sum2 / s.count - mean * mean)) << " samples, phase " << arg(s.phasor) << " rad" << endl;
+    }
+
+    return 0;
+}
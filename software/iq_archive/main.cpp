@@ -0,0 +1,306 @@
+#include <ctime>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "string.h"
+#include "../common/iq_codec.h"
+#include "../common/iq_archive.h"
+
+using namespace std;
+
+// g++ main.cpp ../common/iq_codec.cpp -std=c++11 -O3 -pthread -o iq-archive.out
+
+/* Archive Config */
+const double realtime_rate = 30.72e6;                   // Sample Rate Throughput is Compared Against
+const size_t blocks_per_thread = 16;                    // Captures in Flight per Thread While Packing
+
+/* One Capture in Memory */
+class capture {
+    public:
+        string name;
+        file_header header;
+        vector<int16_t> samples;
+        vector<uint8_t> packed;
+};
+
+
+/* Wall Clock Seconds */
+static double now(){
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+
+/* Run f(i) for i < n on All Cores */
+template <typename function>
+static void parallel_for(size_t n, function f){
+    atomic<size_t> next(0);
+    int num_threads = max(1u, thread::hardware_concurrency());
+    vector<thread> threads;
+    for (int t = 0; t < num_threads; t++)
+        threads.push_back(thread([&](){
+            size_t i;
+            while ((i = next++) < n)
+                f(i);
+        }));
+    for (thread& t : threads)
+        t.join();
+}
+
+
+/* Capture Files from Arguments - Directories Expand to their .bin Files */
+static vector<string> find_captures(int argc, char** argv, int first){
+    vector<string> names;
+    for (int i = first; i < argc; i++){
+        DIR* d = opendir(argv[i]);
+        if (d == NULL){
+            names.push_back(argv[i]);
+            continue;
+        }
+        vector<string> found;
+        dirent* entry;
+        while ((entry = readdir(d)) != NULL){
+            string n = entry->d_name;
+            if (n.size() > 4 && n.compare(n.size() - 4, 4, ".bin") == 0)
+                found.push_back(string(argv[i]) + "/" + n);
+        }
+        closedir(d);
+        sort(found.begin(), found.end());
+        names.insert(names.end(), found.begin(), found.end());
+    }
+    return names;
+}
+
+
+static bool load_capture(const string& name, capture& c){
+    ifstream file(name, ios::binary | ios::ate);
+    if (!file)
+        return false;
+    size_t size = file.tellg();
+    if (size < sizeof(file_header))
+        return false;
+    file.seekg(0);
+    file.read((char*)&c.header, sizeof(file_header));
+    c.samples.resize((size - sizeof(file_header)) / 2 & ~(size_t)1);
+    file.read((char*)c.samples.data(), c.samples.size() * sizeof(int16_t));
+    size_t slash = name.find_last_of('/');
+    c.name = (slash == string::npos) ? name : name.substr(slash + 1);
+    return (bool)file;
+}
+
+
+static void report(const char* what, uint64_t raw_bytes, double seconds){
+    double rate = raw_bytes / seconds;
+    cout << what << ": " << setprecision(1) << rate / 1e6 << " MB/s, " << setprecision(2)
+         << rate / (realtime_rate * 4) << "x real time" << endl;
+}
+
+
+/* Compress Captures into an Archive, Chunk by Chunk */
+static int pack(const string& archive, const vector<string>& names){
+
+    ofstream out(archive, ios::binary);
+    iq_archive_header header = { IQ_ARCHIVE_MAGIC, IQ_ARCHIVE_VERSION, 0, 0 };
+    out.write((char*)&header, sizeof(header));
+
+    vector<iq_archive_entry> index;
+    uint64_t raw_bytes = 0, packed_bytes = 0, offset = sizeof(header);
+    size_t chunk = blocks_per_thread * max(1u, thread::hardware_concurrency());
+    double start = now();
+    for (size_t first = 0; first < names.size(); first += chunk){
+
+        /* Load & Compress on All Cores */
+        size_t n = min(chunk, names.size() - first);
+        vector<capture> captures(n);
+        vector<bool> loaded(n);
+        parallel_for(n, [&](size_t i){
+            loaded[i] = load_capture(names[first + i], captures[i]);
+            if (loaded[i])
+                iq_compress(captures[i].samples.data(), captures[i].samples.size() / 2, captures[i].packed);
+        });
+
+        /* Append in Order */
+        for (size_t i = 0; i < n; i++){
+            if (!loaded[i]){
+                cout << "Skipping unreadable " << names[first + i] << endl;
+                continue;
+            }
+            capture& c = captures[i];
+            iq_archive_entry entry;
+            memset(&entry, 0, sizeof(entry));
+            strncpy(entry.name, c.name.c_str(), IQ_ARCHIVE_NAME - 1);
+            entry.header = c.header;
+            entry.num_samples = c.samples.size() / 2;
+            entry.offset = offset;
+            entry.size = c.packed.size();
+            entry.checksum = iq_checksum(c.samples.data(), entry.num_samples);
+            out.write((char*)c.packed.data(), c.packed.size());
+            index.push_back(entry);
+            offset += c.packed.size();
+            raw_bytes += sizeof(file_header) + c.samples.size() * sizeof(int16_t);
+            packed_bytes += c.packed.size() + sizeof(iq_archive_entry);
+        }
+    }
+
+    /* Index Last, then the Header that Points to it */
+    header.num_blocks = index.size();
+    header.index_offset = offset;
+    out.write((char*)index.data(), index.size() * sizeof(iq_archive_entry));
+    out.seekp(0);
+    out.write((char*)&header, sizeof(header));
+    out.close();
+    if (!out){
+        cout << "Write to " << archive << " failed" << endl;
+        return 1;
+    }
+
+    cout << fixed << "Packed " << index.size() << " captures, " << setprecision(1) << raw_bytes / 1e6 << " MB -> "
+         << packed_bytes / 1e6 << " MB, ratio " << setprecision(2) << (double)raw_bytes / max((uint64_t)1, packed_bytes) << endl;
+    report("Throughput (incl. I/O)", raw_bytes, now() - start);
+    return 0;
+}
+
+
+static bool read_index(int fd, iq_archive_header& header, vector<iq_archive_entry>& index){
+    if (pread(fd, &header, sizeof(header), 0) != sizeof(header) || header.magic != IQ_ARCHIVE_MAGIC)
+        return false;
+    index.resize(header.num_blocks);
+    size_t bytes = index.size() * sizeof(iq_archive_entry);
+    return pread(fd, index.data(), bytes, header.index_offset) == (ssize_t)bytes;
+}
+
+
+/* Decode Captures - All, or Only Those of One Second */
+static int unpack(const string& archive, const string& out_dir, bool list_only, long long stamp){
+
+    int fd = open(archive.c_str(), O_RDONLY);
+    iq_archive_header header;
+    vector<iq_archive_entry> index;
+    if (fd < 0 || !read_index(fd, header, index)){
+        cout << "Not an archive: " << archive << endl;
+        return 1;
+    }
+
+    if (list_only){
+        for (const iq_archive_entry& e : index)
+            cout << e.name << "  " << e.header.unix_stamp << "  " << e.num_samples << " samples  PPS +"
+                 << (int64_t)(e.header.pps_index - e.header.buffer_index) << "  "
+                 << setprecision(2) << fixed << e.num_samples * 4.0 / e.size << ":1" << endl;
+        close(fd);
+        return 0;
+    }
+
+    /* Seek - Only the Matching Blocks are Read */
+    vector<const iq_archive_entry*> selected;
+    for (const iq_archive_entry& e : index)
+        if (stamp < 0 || e.header.unix_stamp == stamp)
+            selected.push_back(&e);
+
+    atomic<size_t> failed(0);
+    atomic<uint64_t> raw_bytes(0);
+    double start = now();
+    parallel_for(selected.size(), [&](size_t i){
+        const iq_archive_entry& e = *selected[i];
+        vector<uint8_t> packed(e.size);
+        vector<int16_t> samples(e.num_samples * 2);
+        if (pread(fd, packed.data(), e.size, e.offset) != (ssize_t)e.size ||
+            !iq_decompress(packed.data(), packed.size(), samples.data(), e.num_samples) ||
+            iq_checksum(samples.data(), e.num_samples) != e.checksum){
+            cout << "Corrupt block " << e.name << endl;
+            failed++;
+            return;
+        }
+        ofstream file(out_dir + "/" + e.name, ios::binary);
+        file.write((const char*)&e.header, sizeof(file_header));
+        file.write((const char*)samples.data(), samples.size() * sizeof(int16_t));
+        raw_bytes += sizeof(file_header) + samples.size() * sizeof(int16_t);
+    });
+    close(fd);
+
+    cout << fixed << "Unpacked " << selected.size() - failed << " of " << selected.size() << " captures" << endl;
+    report("Throughput (incl. I/O)", raw_bytes, now() - start);
+    return failed ? 1 : 0;
+}
+
+
+/* In Memory Ratio & Throughput Against Raw int16 */
+static int bench(const vector<string>& names){
+
+    vector<capture> captures(names.size());
+    vector<bool> loaded(names.size());
+    parallel_for(names.size(), [&](size_t i){ loaded[i] = load_capture(names[i], captures[i]); });
+    uint64_t raw_bytes = 0, packed_bytes = 0;
+    for (size_t i = 0; i < captures.size(); i++)
+        if (loaded[i])
+            raw_bytes += captures[i].samples.size() * sizeof(int16_t);
+    if (raw_bytes == 0){
+        cout << "No captures loaded" << endl;
+        return 1;
+    }
+
+    double start = now();
+    parallel_for(captures.size(), [&](size_t i){
+        if (loaded[i])
+            iq_compress(captures[i].samples.data(), captures[i].samples.size() / 2, captures[i].packed);
+    });
+    double compress_time = now() - start;
+    for (size_t i = 0; i < captures.size(); i++)
+        packed_bytes += captures[i].packed.size();
+
+    atomic<size_t> mismatches(0);
+    start = now();
+    parallel_for(captures.size(), [&](size_t i){
+        if (!loaded[i])
+            return;
+        vector<int16_t> decoded(captures[i].samples.size());
+        if (!iq_decompress(captures[i].packed.data(), captures[i].packed.size(), decoded.data(), decoded.size() / 2) ||
+            decoded != captures[i].samples)
+            mismatches++;
+    });
+    double decompress_time = now() - start;
+
+    cout << fixed << names.size() << " captures, " << setprecision(1) << raw_bytes / 1e6 << " MB of int16 I/Q on "
+         << max(1u, thread::hardware_concurrency()) << " threads" << endl;
+    cout << "Compressed: " << packed_bytes / 1e6 << " MB, ratio " << setprecision(2) << (double)raw_bytes / packed_bytes
+         << ", " << setprecision(2) << packed_bytes * 8.0 / (raw_bytes / 2) << " bits per I or Q value" << endl;
+    report("Compress", raw_bytes, compress_time);
+    report("Decompress", raw_bytes, decompress_time);
+    cout << (mismatches ? "MISMATCH in " + to_string(mismatches) + " captures" : string("Round trip exact")) << endl;
+    return mismatches ? 1 : 0;
+}
+
+
+/* Entry Point */
+int main(int argc, char** argv){
+
+    /* Useage */
+    string command = (argc > 1) ? argv[1] : "";
+    if ((command == "pack" && argc < 4) || (command == "unpack" && argc < 4) || (command == "list" && argc < 3) ||
+        (command == "bench" && argc < 3) || (command != "pack" && command != "unpack" && command != "list" && command != "bench")){
+        cout << "Usage: " << argv[0] << " pack <archive.iqz> <capture.bin | dir> ..." << endl;
+        cout << "       " << argv[0] << " unpack <archive.iqz> <out dir> [unix second]" << endl;
+        cout << "       " << argv[0] << " list <archive.iqz>" << endl;
+        cout << "       " << argv[0] << " bench <capture.bin | dir> ..." << endl;
+        return 1;
+    }
+
+    if (command == "pack")
+        return pack(argv[2], find_captures(argc, argv, 3));
+    if (command == "unpack")
+        return unpack(argv[2], argv[3], false, (argc > 4) ? atoll(argv[4]) : -1);
+    if (command == "list")
+        return unpack(argv[2], "", true, -1);
+    return bench(find_captures(argc, argv, 2));
+}
@@ -0,0 +1,102 @@
+#include <chrono>
+#include <vector>
+#include <random>
+#include <iomanip>
+#include <iostream>
+#include <stdio.h>
+#include "string.h"
+#include "../common/iq_convert.h"
+
+using namespace std;
+
+// g++ main.cpp ../common/iq_convert.cpp -std=c++11 -O2 -o iq-bench.out
+
+/* Benchmark Config */
+const size_t num_samples = 1360 * 4096;                 // Samples per Pass (~5.5M, one RX FIFO)
+const int num_passes = 20;                              // Timed Passes per Kernel
+
+/* Time a Kernel - Returns Throughput in MS/s */
+template <typename F>
+static double benchmark(F kernel){
+
+    /* Warm Up */
+    kernel();
+
+    auto t1 = chrono::high_resolution_clock::now();
+    for (int k = 0; k < num_passes; k++)
+        kernel();
+    auto t2 = chrono::high_resolution_clock::now();
+
+    double seconds = chrono::duration<double>(t2 - t1).count();
+    return (double)num_samples * num_passes / seconds / 1e6;
+}
+
+/* Print a Result Row */
+static void report(const char* name, double scalar_rate, double simd_rate, bool match){
+    cout << left << setw(22) << name
+         << right << setw(10) << fixed << setprecision(1) << scalar_rate
+         << setw(10) << simd_rate
+         << setw(9) << setprecision(2) << simd_rate / scalar_rate << "x"
+         << (match ? "" : "   MISMATCH") << endl;
+}
+
+
+/* Entry Point */
+int main(){
+
+    /* Test Data - Full Range I12 plus Out of Range Floats to Exercise Saturation */
+    mt19937 rng(1);
+    uniform_int_distribution<int> i12_dist(I12_MIN, I12_MAX);
+    uniform_real_distribution<float> f_dist(-1.2f, 1.2f);
+
+    vector<int16_t> i16_in(2 * num_samples);
+    vector<complex<float>> cf32_in(num_samples);
+    vector<uint8_t> packed_in(PACKED12_BYTES_PER_SAMPLE * num_samples);
+    for (size_t i = 0; i < 2 * num_samples; i++)
+        i16_in[i] = (int16_t)i12_dist(rng);
+    for (size_t i = 0; i < num_samples; i++)
+        cf32_in[i] = complex<float>(f_dist(rng), f_dist(rng));
+    iq_cf32_to_packed12_scalar(cf32_in.data(), packed_in.data(), num_samples, 2048.0f);
+
+    /* Output Buffers - Scalar Reference & Dispatched */
+    vector<complex<float>> cf32_ref(num_samples), cf32_out(num_samples);
+    vector<int16_t> i16_ref(2 * num_samples), i16_out(2 * num_samples);
+    vector<uint8_t> packed_ref(packed_in.size()), packed_out(packed_in.size());
+
+    cout << "Samples per pass: " << num_samples << ", passes: " << num_passes << endl;
+
+    /* Benchmark Each Supported Instruction Set */
+    const iq_isa isas[] = { IQ_ISA_SSE, IQ_ISA_AVX2, IQ_ISA_NEON };
+    for (iq_isa isa : isas){
+        if (iq_set_isa(isa) != 0)
+            continue;
+
+        cout << "\n" << left << setw(22) << iq_isa_name(isa)
+             << right << setw(10) << "Scalar" << setw(10) << "SIMD" << setw(10) << "Speedup" << endl;
+        cout << setw(22) << "" << setw(10) << "MS/s" << setw(10) << "MS/s" << endl;
+
+        /* I12 -> complex<float> */
+        double scalar_rate = benchmark([&]{ iq_i16_to_cf32_scalar(i16_in.data(), cf32_ref.data(), num_samples, I12_SCALE); });
+        double simd_rate = benchmark([&]{ iq_i16_to_cf32(i16_in.data(), cf32_out.data(), num_samples, I12_SCALE); });
+        report("I12 -> cf32", scalar_rate, simd_rate, cf32_ref == cf32_out);
+
+        /* complex<float> -> I12 */
+        scalar_rate = benchmark([&]{ iq_cf32_to_i12_scalar(cf32_in.data(), i16_ref.data(), num_samples, 2048.0f); });
+        simd_rate = benchmark([&]{ iq_cf32_to_i12(cf32_in.data(), i16_out.data(), num_samples, 2048.0f); });
+        report("cf32 -> I12 (sat)", scalar_rate, simd_rate, i16_ref == i16_out);
+
+        /* Packed 12-bit -> complex<float> */
+        scalar_rate = benchmark([&]{ iq_packed12_to_cf32_scalar(packed_in.data(), cf32_ref.data(), num_samples, I12_SCALE); });
+        simd_rate = benchmark([&]{ iq_packed12_to_cf32(packed_in.data(), cf32_out.data(), num_samples, I12_SCALE); });
+        report("packed12 -> cf32", scalar_rate, simd_rate, cf32_ref == cf32_out);
+
+        /* complex<float> -> Packed 12-bit */
+        scalar_rate = benchmark([&]{ iq_cf32_to_packed12_scalar(cf32_in.data(), packed_ref.data(), num_samples, 2048.0f); });
+        simd_rate = benchmark([&]{ iq_cf32_to_packed12(cf32_in.data(), packed_out.data(), num_samples, 2048.0f); });
+        report("cf32 -> packed12", scalar_rate, simd_rate, packed_ref == packed_out);
+    }
+
+    /* Real Time Requirement */
+    cout << "\nReal time at 30.72 MS/s requires 30.7 MS/s per stream" << endl;
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include <ctime>
+#include <iostream>
+#include <stdio.h>
+#include "string.h"
+#include "../common/aggregator.h"
+#include "../common/shm_ring.h"
+
+using namespace std;
+
+// g++ main.cpp ../common/aggregator.cpp ../common/rx_ring.cpp ../common/shm_ring.cpp -std=c++11 -O2 -pthread -lrt -o pps-aggregator.out
+
+/* Entry Point */
+int main(int argc, char** argv){
+
+    /* Useage - One Shared Memory Ring per Device, as Published by pps_sync_rx */
+    if (argc < 2){
+        cout << "Usage: " << argv[0] << " <ring> [ring ...]" << endl;
+        return 1;
+    }
+
+    /* Aggregator Config */
+    aggregator_configuration config;
+    for (int i = 1; i < argc; i++)
+        config.names.push_back(argv[i]);                // Device Rings - Order Sets Channel Order
+    config.ring_packets = 8192;                         // Buffer per Device (~45 MB, ~0.36s)
+    config.lag_threshold = 0.75;                        // Stop Waiting for Laggards at 75% Full
+    config.frame_length = 30720;                        // Samples per Device per Frame - 1ms
+    config.sample_rate = 30.72e6;                       // Device Sample Rate
+
+    /* Container Output */
+    string name = "data/" + to_string(time(NULL)) + ".frames";
+    frame_file_sink sink(name, config.names.size(), config.frame_length, config.sample_rate);
+
+    /* Attach to Device Rings */
+    vector<unique_ptr<shm_reader>> readers;
+    vector<packet_source*> sources;
+    for (const string& ring : config.names){
+        readers.push_back(unique_ptr<shm_reader>(new shm_reader(ring)));
+        if (!readers.back()->attached()){
+            cout << "No capture ring named " << ring << endl;
+            return 1;
+        }
+        sources.push_back(readers.back().get());
+    }
+
+    aggregator agg(config, sources, sink);
+    cout << "Aggregating " << config.names.size() << " devices into " << name << endl;
+
+    /* Run Until the Devices Stop */
+    agg.run();
+    cout << "\nFrames written: " << agg.frames() << endl;
+
+    return 0;
+}
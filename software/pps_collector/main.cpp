@@ -0,0 +1,76 @@
+#include <ctime>
+#include <algorithm>
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include "string.h"
+#include "../common/aggregator.h"
+#include "../common/net_stream.h"
+
+using namespace std;
+
+// g++ main.cpp ../common/aggregator.cpp ../common/net_stream.cpp ../common/rx_ring.cpp -std=c++11 -O2 -pthread -o pps-collector.out
+
+/* Entry Point */
+int main(int argc, char** argv){
+
+    /* Useage - Number of Devices Expected to Connect */
+    if (argc < 2){
+        cout << "Usage: " << argv[0] << " <num devices> [port]" << endl;
+        return 1;
+    }
+    int num_devices = atoi(argv[1]);
+    int port = (argc > 2) ? atoi(argv[2]) : NET_STREAM_PORT;
+
+    /* Aggregator Config */
+    aggregator_configuration config;
+    config.ring_packets = 8192;                         // Buffer per Device (~45 MB, ~0.36s)
+    config.lag_threshold = 0.75;                        // Stop Waiting for Laggards at 75% Full
+    config.frame_length = 30720;                        // Samples per Device per Frame - 1ms
+    config.sample_rate = 30.72e6;                       // Device Sample Rate
+
+    /* Accept Device Connections */
+    net_listener listener(port);
+    if (!listener.listening())
+        return 1;
+    cout << "Waiting for " << num_devices << " devices on port " << port << endl;
+
+    vector<unique_ptr<net_connection>> connections;
+    while ((int)connections.size() < num_devices){
+        net_connection* conn = listener.accept(1000);
+        if (conn == NULL)
+            continue;
+
+        /* First Message Identifies the Device */
+        if (conn->first_header(5000) != 1){
+            delete conn;
+            continue;
+        }
+        cout << "Device " << conn->device() << " connected" << endl;
+        connections.push_back(unique_ptr<net_connection>(conn));
+    }
+
+    /* Channel Order by Device Id */
+    sort(connections.begin(), connections.end(),
+         [](const unique_ptr<net_connection>& a, const unique_ptr<net_connection>& b){ return a->device() < b->device(); });
+    vector<packet_source*> sources;
+    for (auto& conn : connections){
+        config.names.push_back("device " + to_string(conn->device()));
+        sources.push_back(conn.get());
+    }
+
+    /* Container Output */
+    string name = "data/" + to_string(time(NULL)) + ".frames";
+    frame_file_sink sink(name, num_devices, config.frame_length, config.sample_rate);
+    cout << "Aggregating " << num_devices << " devices into " << name << endl;
+
+    /* Run Until the Devices Disconnect */
+    aggregator agg(config, sources, sink);
+    agg.run();
+
+    cout << "\nFrames written: " << agg.frames() << endl;
+    for (auto& conn : connections)
+        cout << "Device " << conn->device() << " packets lost by sender: " << conn->lost() << endl;
+
+    return 0;
+}
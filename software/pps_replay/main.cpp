@@ -0,0 +1,109 @@
+#include <chrono>
+#include <ctime>
+#include <cmath>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include "string.h"
+#include "../common/rx_ring.h"
+#include "../common/net_stream.h"
+#include "../common/capture_file.h"
+
+using namespace std;
+
+// g++ main.cpp ../common/net_stream.cpp -std=c++11 -O2 -pthread -o pps-replay.out
+
+/* Replay Config */
+const double sample_rate = 30.72e6;                     // Replayed Sample Rate
+const int duration = 15;                                // Seconds to Stream
+const size_t sender_slots = 4096;                       // Network Sink Ring (~22 MB)
+
+/* Load Samples from Capture Files - Header Skipped */
+static vector<int16_t> load_captures(int num_files, char** files){
+    vector<int16_t> samples;
+    for (int i = 0; i < num_files; i++){
+        ifstream file(files[i], std::ifstream::binary);
+        file.seekg(0, std::ios::end);
+        size_t size = file.tellg();
+        if (size <= sizeof(file_header))
+            continue;
+        file.seekg(sizeof(file_header));
+        size_t n = (size - sizeof(file_header)) / sizeof(int16_t) & ~(size_t)1;
+        samples.resize(samples.size() + n);
+        file.read((char*)&samples[samples.size() - n], n * sizeof(int16_t));
+    }
+    return samples;
+}
+
+/* Entry Point */
+int main(int argc, char** argv){
+
+    /* Useage */
+    if (argc < 3){
+        cout << "Usage: " << argv[0] << " <device id> <collector host> [capture.bin ...]" << endl;
+        return 1;
+    }
+    uint16_t device_id = atoi(argv[1]);
+
+    /* Source Samples - Captures Looped, or the fs/8 Test Tone */
+    vector<int16_t> source = load_captures(argc - 3, argv + 3);
+    if (source.empty()){
+        source.resize(8 * 2);
+        for (int n = 0; n < 8; n++){
+            source[2 * n] = (int16_t)lrint(1000 * cos(2 * M_PI * n / 8));
+            source[2 * n + 1] = (int16_t)lrint(1000 * sin(2 * M_PI * n / 8));
+        }
+    }
+    size_t source_samples = source.size() / 2;
+
+    /* Connect to Collector */
+    net_sender sender(argv[2], NET_STREAM_PORT, device_id, sender_slots);
+    if (!sender.connected())
+        return 1;
+    cout << "Connected, zero copy " << (sender.zerocopy() ? "enabled" : "unavailable") << endl;
+
+    /* Start on a Second Boundary so Replays Started Together Share PPS Events */
+    time_t start_stamp = time(NULL) + 1;
+    auto start = chrono::system_clock::from_time_t(start_stamp);
+    this_thread::sleep_until(start);
+
+    const uint64_t samples_per_second = (uint64_t)llround(sample_rate);
+    const uint64_t num_packets = duration * samples_per_second / RX_PACKET_SAMPLES;
+    rx_packet packet;
+    size_t position = 0;
+
+    for (uint64_t k = 0; k < num_packets; k++){
+
+        /* Pace at the Sample Rate */
+        uint64_t index = k * RX_PACKET_SAMPLES;
+        this_thread::sleep_until(start + chrono::nanoseconds((uint64_t)(index * 1e9 / sample_rate)));
+
+        /* PPS Falls in this Packet */
+        uint64_t second = (index + RX_PACKET_SAMPLES - 1) / samples_per_second;
+        packet.index = index;
+        packet.pps = (second * samples_per_second >= index);
+        if (packet.pps)
+            packet.pps_index = second * samples_per_second;
+
+        /* A PPS Packet Starts in the Second Before - Stamp it with the Pulse's, as the Device's Arrival Stamp Would */
+        packet.unix_stamp = start_stamp + (packet.pps ? second : index / samples_per_second);
+
+        for (int n = 0; n < RX_PACKET_SAMPLES; n++){
+            packet.samples[2 * n] = source[2 * position];
+            packet.samples[2 * n + 1] = source[2 * position + 1];
+            position = (position + 1) % source_samples;
+        }
+        sender.offer(packet);
+    }
+
+    /* Flush & Report */
+    sender.close();
+    double seconds = chrono::duration<double>(chrono::system_clock::now() - start).count();
+    cout << "Sent " << num_packets << " packets, " << num_packets * sizeof(net_message) / seconds / 1e6 << " MB/s" << endl;
+    cout << "Dropped: " << sender.dropped() << ", zero copy sends copied by kernel: " << sender.copied() << endl;
+
+    return 0;
+}
@@ -3,19 +3,31 @@
 #include <iostream>
 #include <fstream>
 #include <stdio.h>
+#include <stdlib.h>
 #include "string.h"
 #include "lime/LimeSuite.h"
 #include "reciever_setup.h"
+#include "rx_pipeline.h"
+#include "../common/psd_monitor.h"
+#include "../common/tone_check.h"
+#include "../common/shm_ring.h"
+#include "../common/net_stream.h"
 
 using namespace std;
 
-// g++ main.cpp reciever_setup.cpp -std=c++11 -lLimeSuite -o pps-rx.out
+// g++ main.cpp reciever_setup.cpp rx_pipeline.cpp ../common/rx_ring.cpp ../common/psd_monitor.cpp ../common/tone_check.cpp ../common/shm_ring.cpp ../common/net_stream.cpp ../common/sigmf.cpp ../common/capture_journal.cpp ../common/capture_stripe.cpp ../common/gpsdo_timing.cpp ../common/polyphase.cpp ../common/fft.cpp ../common/iq_convert.cpp -std=c++11 -O2 -pthread -lrt -lLimeSuite -o pps-rx.out
 
 /* Entry Point */
 int main(int argc, char** argv){
 
+    /* Device Selection - Index into the LimeSuite Device List */
+    int device_index = (argc > 1) ? atoi(argv[1]) : 0;
+    string device_tag = (argc > 1) ? to_string(device_index) : "";
+    string file_prefix = (argc > 1) ? device_tag + "_" : "";
+
     /* Hardware Config */
     reciever_configuration config;
+    config.device_index = device_index;                 // Device to Open
     config.rx_centre_frequency = 868e6;                 // RX Center Freuency    
     config.rx_antenna = LMS_PATH_LNAW;                  // RX RF Path = 10MHz - 2GHz
     config.rx_gain = 0.7;                               // RX Normalised Gain - 0 to 1.0
@@ -29,8 +41,12 @@ int main(int argc, char** argv){
     
     configure_reciever(config);
     
+    /* Self Test - Check Continuity of the Internal fs/8 Test Tone */
+    bool self_test = true;                              // Enable NCODIV8 Test Signal & Check Phase
+    tone_check tone(1.0 / 8, 0.05);                     // Tone (cycles/sample), Break Threshold (rad)
+
     /* Enable Test Signal */
-    if (LMS_SetTestSignal(device, LMS_CH_RX, 0, LMS_TESTSIG_NCODIV8, 0, 0) != 0)
+    if (self_test && LMS_SetTestSignal(device, LMS_CH_RX, 0, LMS_TESTSIG_NCODIV8, 0, 0) != 0)
         error();
 
     /* RX Stream Config  */
@@ -42,10 +58,8 @@ int main(int argc, char** argv){
     rx_stream.dataFmt = lms_stream_t::LMS_FMT_I12;      // Data Format - 12-bit sample stored as int16_t
     LMS_SetupStream(device, &rx_stream);
 
-    /* RX Data Buffer */
-    const int num_rx_samples = 1360;
-    const int rx_buffer_size = num_rx_samples * 2;
-    int16_t rx_buffer[rx_buffer_size];
+    /* RX Buffer Size */
+    const int num_rx_samples = RX_PACKET_SAMPLES;
     
     /* RX Stream Metadata */
     lms_stream_meta_t rx_metadata;
@@ -55,32 +69,99 @@ int main(int argc, char** argv){
     uint64_t pps_sync_idx = 0;
     uint64_t prev_pps_sync_idx = 0;
     
-    /* Output File */
-    ofstream data_file;
-    file_header file_metadata;
-    const string out_path = "data/";
-    
-    /* Output Buffer */
-    const int file_length = 12 + 1;
-    int16_t file_buffer[rx_buffer_size * file_length];
+    /* Capture Pipeline Config */
+    pipeline_configuration pipeline_config;
+    pipeline_config.out_path = "data/" + file_prefix;   // Output Directory & Device Prefix
+    pipeline_config.file_length = 12 + 1;               // Buffers per File - PPS Buffer + 12
+    pipeline_config.num_workers = 2;                    // DSP & File Writer Threads
+    pipeline_config.sample_rate = config.sample_rate;   // Input Sample Rate
+    pipeline_config.enable_decimator = false;           // Decimate Before Storage
+    pipeline_config.decimation = 16;                    // Decimation Factor - 30.72 MS/s -> 1.92 MS/s
+    pipeline_config.num_taps = 255;                     // Decimator FIR Length
+    pipeline_config.cutoff = 0.8;                       // Passband Edge as Fraction of Output Nyquist
+    pipeline_config.nco_frequency = 0;                  // Centre of Slice Relative to LO (Hz)
+    pipeline_config.num_channels = 1;                   // Channelizer Channels - Power of 2, > 1 Enables
+    pipeline_config.taps_per_channel = 16;              // Channelizer Taps per Branch
+    pipeline_config.enable_sigmf = false;               // Write SigMF Recordings Instead of .bin
+    pipeline_config.centre_frequency = config.rx_centre_frequency;
+    pipeline_config.hardware = device_identity(device_index);
+    pipeline_config.enable_journal = true;              // Journal Captures & Recover After a Crash
+    pipeline_config.segment_bytes = 8 << 20;            // Sync Once per 8 MB of Captures
+    pipeline_config.stripe_paths = {};                  // e.g. {"/mnt/nvme0/" + file_prefix, "/mnt/nvme1/" + file_prefix}
+    pipeline_config.stripe_mode = STRIPE_LEAST_LOADED;  // Spread by Expected Completion, or STRIPE_ROUND_ROBIN
+    pipeline_config.stripe_queue_bytes = 64 << 20;      // Skip a Drive with 64 MB Queued
+    pipeline_config.gpsdo_tty = "";                     // e.g. "/dev/ttyACM0" - Record the GPSDO's qErr per PPS
+
+    /* Spectrum Monitor Config */
+    bool enable_monitor = false;                        // Write Averaged Spectrum Each Second
+    monitor_configuration monitor_config;
+    monitor_config.out_path = "data/" + file_prefix;    // Output Directory & Device Prefix
+    monitor_config.fft_size = 512;                      // FFT Length - Power of 2, <= 1360
+    monitor_config.max_fraction = 0.1;                  // Analyse at Most 1 in 10 Packets
+    monitor_config.cpu_budget = 0.15;                   // At Most 15% of One Core
+    monitor_config.num_threads = 2;                     // Analysis Threads
+    monitor_config.sample_rate = config.sample_rate;    // Input Sample Rate
+    monitor_config.centre_frequency = config.rx_centre_frequency;
+
+    /* Shared Memory Ring - Live Stream for Other Processes */
+    bool enable_shm = false;                            // Publish Packets for shm_monitor etc.
+    const string shm_name = "pps_rx" + device_tag;      // Ring Name
+    const size_t shm_slots = 8192;                      // Slots (~45 MB, ~0.36s at 30.72 MS/s)
+
+    /* Network Sink - Stream Packets to pps_collector */
+    bool enable_net = false;                            // Send Packets to a Collector
+    const string net_host = "127.0.0.1";                // Collector Address
+    const int net_port = NET_STREAM_PORT;               // Collector Port
+    const size_t net_slots = 4096;                      // Send Ring (~22 MB)
+
+    /* Receive Ring - Decouples the Receive Loop from Storage */
+    rx_ring ring(4096);
+    rx_packet overflow_packet;
+
+    /* Start Capture Pipeline */
+    rx_pipeline pipeline(pipeline_config, ring);
+    spectrum_monitor monitor(monitor_config);
+    if (enable_monitor){
+        monitor.start();
+        pipeline.add_tap(&monitor);
+    }
+    if (self_test)
+        pipeline.add_tap(&tone);
+    unique_ptr<shm_writer> shm;
+    if (enable_shm){
+        shm.reset(new shm_writer(shm_name, shm_slots, config.sample_rate));
+        pipeline.add_tap(shm.get());
+    }
+    unique_ptr<net_sender> net;
+    if (enable_net){
+        net.reset(new net_sender(net_host, net_port, device_index, net_slots));
+        pipeline.add_tap(net.get());
+    }
+    pipeline.start();
 
 
     /* Start streaming */
     LMS_StartStream(&rx_stream);
 
-    /* Process Stream for 5s */
+    /* Process Stream for 15s */
     auto t1 = chrono::high_resolution_clock::now();
-    auto t2 = t1;
     while (chrono::high_resolution_clock::now() - t1 < chrono::seconds(15)){
 
+        /* Claim Ring Slot - Receive into Overflow Packet if Ring is Full */
+        rx_packet* packet = ring.claim();
+        bool ring_full = (packet == NULL);
+        if (ring_full)
+            packet = &overflow_packet;
+
         /* Read Samples into Buffer */
-        if(LMS_RecvStream(&rx_stream, rx_buffer, num_rx_samples, &rx_metadata, 1000) != num_rx_samples){
+        if(LMS_RecvStream(&rx_stream, packet->samples, num_rx_samples, &rx_metadata, 1000) != num_rx_samples){
             LMS_StopStream(&rx_stream);
             LMS_DestroyStream(device, &rx_stream);
             error();
         };
 
         /* Check PPS Sync Flag - MSB Set */
+        bool new_pps = false;
         if((rx_metadata.timestamp & 0x8000000000000000) == 0x8000000000000000){
             
             /* Extract PPS Sync Index - Clear MSB */
@@ -89,48 +170,20 @@ int main(int argc, char** argv){
             curr_buff_idx += num_rx_samples;
             
             /* Ignore Repeated Timestamp */
-            if (pps_sync_idx != prev_pps_sync_idx){
-                
-                /* UNIQUE PPS EVENT DETCETED */
-
-                /* Generate Header */
-                file_metadata.unix_stamp = std::time(NULL);
-                file_metadata.buffer_index = curr_buff_idx;
-                file_metadata.pps_index = pps_sync_idx;                
-
-                /* Save Current Buffer */
-                memcpy(file_buffer, rx_buffer, sizeof(rx_buffer));
-
-                /* Save Subsequent 12 Buffers */
-                for(int k=1; k<file_length; k++){
-
-                    /* Read Samples into Buffer */
-                    if(LMS_RecvStream(&rx_stream, rx_buffer, num_rx_samples, &rx_metadata, 1000) != num_rx_samples){
-                        LMS_StopStream(&rx_stream);
-                        LMS_DestroyStream(device, &rx_stream);
-                        error();
-                    };
-        
-                    memcpy(&file_buffer[rx_buffer_size * k], rx_buffer, sizeof(rx_buffer));
-                    curr_buff_idx += num_rx_samples;
-                }
-
-                /* Write to File */
-                data_file.open(out_path + to_string(file_metadata.unix_stamp) + ".bin", std::ofstream::binary);
-                data_file.write((char*)&file_metadata, sizeof(file_metadata));
-                data_file.write((char*)file_buffer, sizeof(file_buffer));
-                data_file.close();
-
-                /* Debug Output */
-                cout << "\nTime: " << file_metadata.unix_stamp << endl;
-                cout << "File begins with sample " << file_metadata.buffer_index << endl;
-                cout << "PPS sync occured at sample " << file_metadata.pps_index << endl;
-                cout << "Samples since last PPS = " << pps_sync_idx - prev_pps_sync_idx << endl; 
-                cout << "Sync event offset = " << file_metadata.pps_index - file_metadata.buffer_index << endl;     
-            }
+            new_pps = (pps_sync_idx != prev_pps_sync_idx);
         } else {
             curr_buff_idx = rx_metadata.timestamp;
         }
+
+        /* Tag Packet & Hand to Pipeline */
+        packet->index = curr_buff_idx;
+        packet->pps_index = pps_sync_idx;
+        packet->pps = new_pps;
+        packet->unix_stamp = std::time(NULL);
+        if (ring_full)
+            ring.drop();
+        else
+            ring.publish();
     }
 
     /* Stop Streaming */
@@ -139,6 +192,25 @@ int main(int argc, char** argv){
     /* Destroy Stream */
     LMS_DestroyStream(device, &rx_stream);
 
+    /* Flush Pipeline */
+    ring.close();
+    pipeline.stop();
+    if (enable_monitor){
+        monitor.stop();
+        cout << "Spectrum packets analysed: " << monitor.analysed() << " (1 in " << monitor.stride() << ")" << endl;
+    }
+    cout << "\nPackets dropped: " << ring.dropped() << endl;
+    cout << "Captures dropped: " << pipeline.dropped_captures() << endl;
+    cout << "Journal segments synced: " << pipeline.synced_segments() << endl;
+    pipeline.report_stripes();
+    if (self_test)
+        tone.report();
+    shm.reset();
+    if (net){
+        net->close();
+        cout << "Packets dropped by network sink: " << net->dropped() << endl;
+    }
+
     /* Disable RX Channel */
     if (LMS_EnableChannel(device, LMS_CH_RX, 0, false)!=0)
         error();
@@ -0,0 +1,31 @@
+import sys
+import struct
+import numpy as np
+from datetime import datetime
+import matplotlib.pyplot as plt
+
+# Useage
+if len(sys.argv) != 2:
+    print("Usage: {} <spectrum.psd>".format(sys.argv[0]))
+    sys.exit(1)
+
+# Open Spectrum File
+file = open(sys.argv[1], 'rb')
+
+# Read Metadata
+meta = struct.unpack('qIIdd', file.read(32))
+fft_size = meta[1]
+print(datetime.utcfromtimestamp(meta[0]).strftime('%Y-%m-%d %H:%M:%S'))
+print("FFT size", fft_size)
+print("Segments averaged", meta[2])
+
+# Read dBFS Bins - Lowest Frequency First
+psd = np.frombuffer(file.read(fft_size * 4), dtype=np.float32)
+freq = meta[4] + (np.arange(fft_size) - fft_size / 2) * meta[3] / fft_size
+
+# Plot Spectrum
+plt.plot(freq / 1e6, psd)
+plt.xlabel('Frequency (MHz)')
+plt.ylabel('Power (dBFS)')
+plt.grid(True)
+plt.show()
@@ -1,4 +1,6 @@
+#include <string>
 #include <iostream>
+#include <stdio.h>
 #include "lime/LimeSuite.h"
 #include "reciever_setup.h"
 
@@ -8,7 +10,7 @@ using namespace std;
 lms_device_t* device = NULL;
 
 /* Prototypes */
-int open_device(void);
+int open_device(int device_index);
 
 
 /* Configure Reciever */
@@ -17,7 +19,7 @@ int configure_reciever(reciever_configuration rx_config){
     /*  DEVICE SETUP  */
     
     /* Connect to LimeSDR */
-    if (open_device() != 0)
+    if (open_device(rx_config.device_index) != 0)
         return -1;
 
     /* Initialize Device with Default Configuration */
@@ -126,14 +128,14 @@ int configure_reciever(reciever_configuration rx_config){
 
 
 /* Open LimeSDR Device */
-int open_device(void){
+int open_device(int device_index){
 
     /* Find Number of Devices Attached */
     int num_dev;
     if ((num_dev = LMS_GetDeviceList(NULL)) < 0)
         error();
     cout << "Devices found: " << num_dev << endl;
-    if (num_dev < 1)
+    if (num_dev <= device_index)
         return -1;
 
     /* Allocate & Populate Device List */
@@ -146,8 +148,8 @@ int open_device(void){
         cout << i << ": " << list[i] << endl;
     cout << endl;
 
-    /* Open the First Device */
-    if (LMS_Open(&device, list[0], NULL))
+    /* Open the Selected Device */
+    if (LMS_Open(&device, list[device_index], NULL))
         error();
 
     /* Delete List */
@@ -156,6 +158,17 @@ int open_device(void){
 }
 
 
+/* Board Name, Serial & Index of the Open Device */
+string device_identity(int device_index){
+    const lms_dev_info_t* info = (device != NULL) ? LMS_GetDeviceInfo(device) : NULL;
+    if (info == NULL)
+        return "LimeSDR device " + to_string(device_index);
+    char serial[32];
+    snprintf(serial, sizeof(serial), "%llX", (unsigned long long)info->boardSerialNumber);
+    return string(info->deviceName) + " serial " + serial + " device " + to_string(device_index);
+}
+
+
 /* Error Handler */
 int error(){
     if (device != NULL)
@@ -1,11 +1,14 @@
 #ifndef RECIEVER_SETUP_H
 #define RECIEVER_SETUP_H
 
+#include <string>
 #include "lime/LimeSuite.h"
+#include "../common/capture_file.h"
 using namespace std;
 
 class reciever_configuration {
     public:
+        int device_index;
         float_type rx_centre_frequency;
         size_t rx_antenna;        
         float_type rx_gain;
@@ -17,19 +20,15 @@ class reciever_configuration {
         int rf_oversample_ratio;
 };
 
-class file_header {
-    public:
-        time_t unix_stamp;
-        uint64_t buffer_index;
-        uint64_t pps_index;
-};
-
 /* Device Structure */
 extern lms_device_t* device;
 
 /* Reciever Setup */
 int configure_reciever(reciever_configuration rx_config);
 
+/* Board Name, Serial & Index of the Open Device */
+string device_identity(int device_index);
+
 /* Error Handler */
 int error();
 
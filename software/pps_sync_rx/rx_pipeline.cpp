@@ -0,0 +1,316 @@
+#include <iostream>
+#include "string.h"
+#include "rx_pipeline.h"
+#include "../common/iq_convert.h"
+
+using namespace std;
+
+/* Serialise Console Output from Worker Threads */
+static mutex console_mutex;
+
+
+rx_pipeline::rx_pipeline(pipeline_configuration config, rx_ring& ring)
+    : config(config), ring(ring), history_packets(0), stopping(false), num_dropped(0){
+
+    /* DSP Stage - Channelizer Takes Precedence over Plain Decimation */
+    if (config.enable_decimator){
+        double nco = config.nco_frequency / config.sample_rate;
+        size_t span;
+        if (config.num_channels > 1){
+            channelizer.reset(new polyphase_channelizer(config.num_channels, config.taps_per_channel, nco));
+            span = (size_t)config.num_channels * config.taps_per_channel;
+        } else {
+            decimator.reset(new fir_decimator(config.decimation, config.num_taps, config.cutoff, nco));
+            span = decimator->span();
+        }
+
+        /* Keep Enough Preceding Buffers for the Filter to Cover the PPS Buffer */
+        history_packets = (span / 2 + RX_PACKET_SAMPLES - 1) / RX_PACKET_SAMPLES;
+    }
+
+    /* Journal - Replays & Repairs the Previous Run Before Anything is Written */
+    if (config.enable_journal){
+        journal.reset(new capture_journal(config.out_path + "journal.idx", config.segment_bytes));
+        const journal_recovery& r = journal->recovery();
+        if (r.verified || r.damaged || r.torn)
+            cout << "Journal recovery: " << r.committed << " committed, " << r.verified << " verified, "
+                 << r.damaged << " damaged, " << r.torn << " torn records" << endl;
+    }
+    if (!config.stripe_paths.empty())
+        striper.reset(new capture_striper(config.stripe_paths, config.stripe_mode, config.stripe_queue_bytes, journal.get()));
+    if (!config.gpsdo_tty.empty()){
+        timing.reset(new gpsdo_timing(config.gpsdo_tty));
+        if (!timing->opened()){
+            cout << "Unable to open GPSDO " << config.gpsdo_tty << ", PPS left uncorrected" << endl;
+            timing.reset();
+        }
+    }
+}
+
+
+/* Start Assembler & Workers */
+void rx_pipeline::start(){
+    assembler = thread(&rx_pipeline::assemble, this);
+    for (int i = 0; i < config.num_workers; i++)
+        workers.push_back(thread(&rx_pipeline::work, this));
+}
+
+/* Attach a Packet Consumer */
+void rx_pipeline::add_tap(packet_tap* tap){
+    taps.push_back(tap);
+}
+
+/* Drain & Join */
+void rx_pipeline::stop(){
+    assembler.join();
+    {
+        lock_guard<mutex> lock(queue_mutex);
+        stopping = true;
+    }
+    queue_cv.notify_all();
+    for (thread& t : workers)
+        t.join();
+    workers.clear();
+    if (striper)
+        striper->stop();
+    if (journal)
+        journal->commit();
+}
+
+
+/* Cut Captures from the Packet Stream */
+void rx_pipeline::assemble(){
+
+    const size_t packet_size = RX_PACKET_SAMPLES * 2;
+    deque<rx_packet> recent;
+    capture_job* job = NULL;
+    int num_buffers = 0;
+    uint64_t expected_index = 0;
+    uint64_t prev_pps_index = 0;
+
+    while (true){
+        rx_packet* packet = ring.peek(100);
+        if (packet == NULL){
+            if (ring.closed())
+                break;
+            continue;
+        }
+
+        if (job != NULL){
+
+            /* Abandon Captures Spanning Dropped Packets */
+            if (packet->index != expected_index){
+                lock_guard<mutex> lock(console_mutex);
+                cout << "Gap in stream at sample " << expected_index << ", capture discarded" << endl;
+                delete job;
+                job = NULL;
+            } else {
+                job->samples.insert(job->samples.end(), packet->samples, packet->samples + packet_size);
+                expected_index += RX_PACKET_SAMPLES;
+                if (++num_buffers == config.file_length){
+                    submit(job);
+                    job = NULL;
+                }
+            }
+
+        } else if (packet->pps){
+
+            /* UNIQUE PPS EVENT DETECTED */
+            job = new capture_job;
+            job->header.unix_stamp = packet->unix_stamp;
+            job->header.buffer_index = packet->index;
+            job->header.pps_index = packet->pps_index;
+
+            /* Contiguous History for the DSP Stage */
+            size_t first = recent.size();
+            while (first > 0 && recent[first - 1].index == packet->index - (recent.size() - first + 1) * RX_PACKET_SAMPLES)
+                first--;
+            job->history = (recent.size() - first) * RX_PACKET_SAMPLES;
+            job->samples.reserve(job->history * 2 + config.file_length * packet_size);
+            for (size_t i = first; i < recent.size(); i++)
+                job->samples.insert(job->samples.end(), recent[i].samples, recent[i].samples + packet_size);
+
+            job->samples.insert(job->samples.end(), packet->samples, packet->samples + packet_size);
+            expected_index = packet->index + RX_PACKET_SAMPLES;
+            num_buffers = 1;
+
+            /* Debug Output */
+            {
+                lock_guard<mutex> lock(console_mutex);
+                cout << "\nTime: " << job->header.unix_stamp << endl;
+                cout << "File begins with sample " << job->header.buffer_index << endl;
+                cout << "PPS sync occured at sample " << job->header.pps_index << endl;
+                cout << "Samples since last PPS = " << job->header.pps_index - prev_pps_index << endl;
+                cout << "Sync event offset = " << job->header.pps_index - job->header.buffer_index << endl;
+                double q_err;
+                if (timing && timing->q_err(job->header.unix_stamp, q_err))
+                    cout << "PPS quantisation error = " << q_err * 1e9 << " ns" << endl;
+            }
+            prev_pps_index = packet->pps_index;
+
+            if (num_buffers == config.file_length){
+                submit(job);
+                job = NULL;
+            }
+        }
+
+        /* Feed Taps */
+        for (packet_tap* tap : taps)
+            tap->offer(*packet);
+
+        /* Retain History */
+        if (history_packets > 0){
+            recent.push_back(*packet);
+            if (recent.size() > history_packets)
+                recent.pop_front();
+        }
+
+        ring.release();
+    }
+
+    /* Discard Incomplete Capture */
+    delete job;
+}
+
+
+/* Queue a Capture - Dropped Rather than Stalling the Ring if Workers Fall Behind */
+void rx_pipeline::submit(capture_job* job){
+    {
+        lock_guard<mutex> lock(queue_mutex);
+        if (queue.size() < (size_t)config.num_workers * 2){
+            queue.push_back(job);
+            job = NULL;
+        }
+    }
+    if (job != NULL){
+        num_dropped++;
+        lock_guard<mutex> lock(console_mutex);
+        cout << "Workers behind, capture " << job->header.unix_stamp << " dropped" << endl;
+        delete job;
+        return;
+    }
+    queue_cv.notify_one();
+}
+
+
+/* Worker Thread */
+void rx_pipeline::work(){
+    while (true){
+        capture_job* job;
+        {
+            unique_lock<mutex> lock(queue_mutex);
+            queue_cv.wait(lock, [this]{ return stopping || !queue.empty(); });
+            if (queue.empty())
+                return;
+            job = queue.front();
+            queue.pop_front();
+        }
+        process(job);
+        delete job;
+    }
+}
+
+
+/* Run DSP Stage & Write Capture */
+void rx_pipeline::process(capture_job* job){
+
+    const string name = to_string(job->header.unix_stamp);
+    const size_t num_samples = job->samples.size() / 2;
+
+    /* Full Rate - Store PPS Buffer Onwards */
+    if (!decimator && !channelizer){
+        write_capture(name, job->header, &job->samples[job->history * 2], num_samples - job->history,
+                      config.sample_rate, config.centre_frequency);
+        return;
+    }
+
+    /* Convert to Floating Point */
+    vector<complex<float>> in(num_samples);
+    iq_i16_to_cf32(job->samples.data(), in.data(), num_samples, I12_SCALE);
+    uint64_t first_index = job->header.buffer_index - job->history;
+
+    /* Translate PPS to the Decimated Timebase */
+    int factor = decimator ? decimator->factor() : channelizer->channels();
+    file_header header = job->header;
+    header.pps_index = (job->header.pps_index + factor / 2) / factor;
+
+    if (decimator){
+
+        /* Decimate */
+        vector<complex<float>> out(decimator->max_output(num_samples));
+        size_t num_out = decimator->process(in.data(), num_samples, first_index, out.data(), &header.buffer_index);
+        vector<int16_t> samples(num_out * 2);
+        iq_cf32_to_i12(out.data(), samples.data(), num_out, 2048.0f);
+        write_capture(name, header, samples.data(), num_out,
+                      config.sample_rate / factor, config.centre_frequency + config.nco_frequency);
+
+    } else {
+
+        /* Channelize - One File per Channel */
+        int num_channels = channelizer->channels();
+        double channel_spacing = config.sample_rate / num_channels;
+        size_t max_out = channelizer->max_output(num_samples);
+        vector<complex<float>> out(max_out * num_channels);
+        vector<complex<float>*> channels(num_channels);
+        for (int c = 0; c < num_channels; c++)
+            channels[c] = &out[c * max_out];
+        size_t num_out = channelizer->process(in.data(), num_samples, first_index, channels.data(), &header.buffer_index);
+
+        vector<int16_t> samples(num_out * 2);
+        for (int c = 0; c < num_channels; c++){
+            iq_cf32_to_i12(channels[c], samples.data(), num_out, 2048.0f);
+            double offset = ((c < num_channels / 2) ? c : c - num_channels) * channel_spacing;
+            write_capture(name + "_ch" + to_string(c), header, samples.data(), num_out, channel_spacing,
+                          config.centre_frequency + config.nco_frequency + offset);
+        }
+    }
+}
+
+
+/* Write Header & Samples - name Without Directory or Extension */
+void rx_pipeline::write_capture(const string& name, const file_header& header,
+                                const int16_t* samples, size_t num_samples, double rate, double frequency){
+
+    /* Striped Captures are Copied into a Job for the Target's Thread, Others Written from the Buffer */
+    stripe_job* files = striper ? new stripe_job : NULL;
+    auto put = [&](const string& file, const void* head, size_t head_bytes, const void* data, size_t data_bytes){
+        if (files){
+            files->add(file, header.unix_stamp, head, head_bytes, data, data_bytes);
+            return;
+        }
+        if (!write_capture_file(config.out_path + file, header.unix_stamp, head, head_bytes, data, data_bytes,
+                                journal.get()) && !journal){
+            lock_guard<mutex> lock(console_mutex);
+            cout << "Write to " << config.out_path + file << " failed" << endl;
+        }
+    };
+
+    /* SigMF - Samples Only, Header Fields Move to the Metadata */
+    if (config.enable_sigmf){
+        sigmf_recording recording;
+        recording.sample_rate = rate;
+        recording.frequency = frequency;
+        recording.hardware = config.hardware;
+        recording.recorder = "pps_sync_rx";
+        recording.description = "PPS synchronised capture";
+        recording.header = header;
+        recording.header_bytes = 0;
+        recording.num_samples = num_samples;
+        recording.has_q_err = timing && timing->q_err(header.unix_stamp, recording.q_err);
+        string meta = sigmf_metadata(recording);
+        put(name + ".sigmf-data", NULL, 0, samples, num_samples * 2 * sizeof(int16_t));
+        put(name + ".sigmf-meta", NULL, 0, meta.data(), meta.size());
+    } else {
+        put(name + ".bin", &header, sizeof(header), samples, num_samples * 2 * sizeof(int16_t));
+
+        /* The Header has no Room for qErr - it Goes Alongside, on the Same Target */
+        double q_err;
+        if (timing && timing->q_err(header.unix_stamp, q_err)){
+            string pps = pps_sidecar(header.pps_index, rate, q_err);
+            put(name + ".pps", NULL, 0, pps.data(), pps.size());
+        }
+    }
+
+    if (files)
+        striper->write(files);
+}
@@ -0,0 +1,116 @@
+#ifndef RX_PIPELINE_H
+#define RX_PIPELINE_H
+
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+#include "../common/rx_ring.h"
+#include "../common/polyphase.h"
+#include "../common/capture_file.h"
+#include "../common/sigmf.h"
+#include "../common/capture_journal.h"
+#include "../common/capture_stripe.h"
+#include "../common/gpsdo_timing.h"
+using namespace std;
+
+/* Pipeline Configuration */
+class pipeline_configuration {
+    public:
+        string out_path;
+        int file_length;
+        int num_workers;
+        double sample_rate;
+
+        /* DSP Stage */
+        bool enable_decimator;
+        int decimation;
+        int num_taps;
+        double cutoff;
+        double nco_frequency;
+        int num_channels;
+        int taps_per_channel;
+
+        /* Output Format */
+        bool enable_sigmf;                              // .sigmf-data & .sigmf-meta instead of .bin
+        double centre_frequency;                        // LO, for the SigMF metadata
+        string hardware;                                // Device identity, for the SigMF metadata
+
+        /* Crash Consistency */
+        bool enable_journal;                            // Journal captures in <out_path>journal.idx
+        uint64_t segment_bytes;                         // Bytes written between syncs
+
+        /* Striping - Replaces out_path's Directory When Set */
+        vector<string> stripe_paths;                    // Directory & file prefix per drive
+        stripe_policy stripe_mode;
+        uint64_t stripe_queue_bytes;                    // Queue per drive before it is skipped
+
+        /* PPS Correction - GPSDO USB Port for Per Pulse qErr, Empty to Skip */
+        string gpsdo_tty;
+};
+
+/* Capture Waiting for a Worker */
+class capture_job {
+    public:
+        file_header header;                             // Full rate indices of the PPS buffer
+        vector<int16_t> samples;                        // History + file_length buffers
+        size_t history;                                 // Leading samples preceding the PPS buffer
+};
+
+/* Capture Pipeline
+ * receive thread -> rx_ring -> assembler thread -> job queue -> worker threads
+ * The assembler cuts a capture of file_length buffers from each PPS event,
+ * workers run the optional DSP stage and write the capture to disk, or
+ * hand it to the striper's per-drive writer threads.
+ * Attached taps see every packet from the assembler thread.
+ */
+class rx_pipeline {
+    public:
+        rx_pipeline(pipeline_configuration config, rx_ring& ring);
+        void start();
+        void stop();                                    // Drains the ring, call after ring.close()
+        void add_tap(packet_tap* tap);                  // Call before start()
+
+        uint64_t dropped_captures() const { return num_dropped; }
+        uint64_t synced_segments() const { return journal ? journal->segments() : 0; }
+        void report_stripes() { if (striper) striper->report(); }
+
+    private:
+        void assemble();
+        void work();
+        void submit(capture_job* job);
+        void process(capture_job* job);
+        void write_capture(const string& name, const file_header& header,
+                           const int16_t* samples, size_t num_samples, double rate, double frequency);
+
+        pipeline_configuration config;
+        rx_ring& ring;
+        vector<packet_tap*> taps;
+
+        /* DSP Stage - Shared by All Workers */
+        unique_ptr<fir_decimator> decimator;
+        unique_ptr<polyphase_channelizer> channelizer;
+        size_t history_packets;
+
+        /* Journal & Striper - Shared by All Workers */
+        unique_ptr<capture_journal> journal;
+        unique_ptr<capture_striper> striper;
+
+        /* GPSDO Timing Logs */
+        unique_ptr<gpsdo_timing> timing;
+
+        /* Job Queue */
+        mutex queue_mutex;
+        condition_variable queue_cv;
+        deque<capture_job*> queue;
+        bool stopping;
+        uint64_t num_dropped;
+
+        thread assembler;
+        vector<thread> workers;
+};
+
+#endif
@@ -1,43 +1,38 @@
+import os
 import sys
-import struct
 import numpy as np
 from datetime import datetime
 import matplotlib.pyplot as plt
 
+# Zero Copy Capture Reader - Built in software/capture_py
+sys.path.append(os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'capture_py'))
+import ppscapture
+
 # Useage
 if len(sys.argv) != 2:
     print("Usage: {} <samples.bin>".format(sys.argv[0]))
     sys.exit(1)
     
-# Open Datafile
-file = open(sys.argv[1], 'rb')
+# Map Datafile
+capture = ppscapture.open(sys.argv[1])
     
-# Compute Number of Samples Present
-file.read()
-num_samples = int((file.tell()-24)/4)
-file.seek(0)
+# Number of Samples Present
+num_samples = capture.num_samples
 print("File contains", num_samples, "samples.")
 dur = (1/30.72)*num_samples
 print("Duration: %.4f us" % dur)
 print("")
 
 # Read Metadata
-meta = struct.unpack('QQQ', file.read(24))
+meta = (capture.unix_stamp, capture.buffer_index, capture.pps_index)
 print(datetime.utcfromtimestamp(meta[0]).strftime('%Y-%m-%d %H:%M:%S'))
 print("File begins with sample", meta[1])
 print("PPS sync occured at sample", meta[2])
 print("Sync event offset =", meta[2] - meta[1])
 
-# Create I and Q Arrays
-I = np.zeros(num_samples, dtype=float)
-Q = np.zeros(num_samples, dtype=float)
-for n in range(0, num_samples):
-    
-    I[n] = struct.unpack('h', file.read(2))[0]
-    Q[n] = struct.unpack('h', file.read(2))[0]
-
-# Creat Complex Array
-samples = (I + 1j*Q)
+# View I/Q in Place - No Copy Until the Complex Array
+iq = np.asarray(capture)
+samples = iq[:, 0] + 1j*iq[:, 1]
 print(samples)
 
 # Plot I&Q Channels
@@ -0,0 +1,57 @@
+#include <chrono>
+#include <iostream>
+#include <stdio.h>
+#include "string.h"
+#include "../common/shm_ring.h"
+
+using namespace std;
+
+// g++ main.cpp ../common/shm_ring.cpp -std=c++11 -O2 -pthread -lrt -o shm-monitor.out
+
+/* Entry Point */
+int main(int argc, char** argv){
+
+    /* Ring Name - Matches the Writer in pps_sync_rx */
+    string name = (argc > 1) ? argv[1] : "pps_rx";
+
+    shm_reader reader(name);
+    if (!reader.attached()){
+        cout << "No capture ring named " << name << endl;
+        return 1;
+    }
+    cout << "Attached to " << name << " at " << reader.sample_rate() / 1e6 << " MS/s" << endl;
+
+    /* Book Keeping */
+    rx_packet packet;
+    uint64_t num_packets = 0;
+    uint64_t expected_index = 0;
+    uint64_t num_gaps = 0;
+    auto t1 = chrono::steady_clock::now();
+
+    /* Follow the Stream Until the Writer Exits */
+    while (true){
+        int status = reader.read(&packet, 1000);
+        if (status == 0 && reader.closed())
+            break;
+
+        if (status == 1){
+            if (num_packets > 0 && packet.index != expected_index)
+                num_gaps++;
+            expected_index = packet.index + RX_PACKET_SAMPLES;
+            num_packets++;
+
+            if (packet.pps)
+                cout << "PPS at sample " << packet.pps_index << " (unix " << packet.unix_stamp << ")" << endl;
+        }
+
+        /* Once per Second Statistics */
+        if (chrono::steady_clock::now() - t1 >= chrono::seconds(1)){
+            cout << "Packets: " << num_packets << "  Gaps: " << num_gaps
+                 << "  Overruns: " << reader.overruns() << "  Lost: " << reader.lost() << endl;
+            t1 = chrono::steady_clock::now();
+        }
+    }
+
+    cout << "\nWriter closed after " << num_packets << " packets, " << reader.lost() << " lost to overruns" << endl;
+    return 0;
+}
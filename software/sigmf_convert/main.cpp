@@ -0,0 +1,77 @@
+#include <string>
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include "string.h"
+#include "../common/sigmf.h"
+
+using namespace std;
+
+// g++ main.cpp ../common/sigmf.cpp -std=c++11 -O2 -o sigmf-convert.out
+
+/* Capture Description - Matches the pps_sync_rx Defaults */
+const double sample_rate = 30.72e6;                     // Sample Rate of the Captures (Hz)
+const double frequency = 868e6;                         // RX Centre Frequency (Hz)
+const string hardware = "LimeSDR";                      // Receiver, the Device Index is Taken from the File Name
+
+
+/* Strip Directory & Extension */
+static string base_name(const string& name, const string& extension){
+    if (name.size() > extension.size() && name.compare(name.size() - extension.size(), extension.size(), extension) == 0)
+        return name.substr(0, name.size() - extension.size());
+    return name;
+}
+
+
+/* Entry Point */
+int main(int argc, char** argv){
+
+    /* Useage */
+    if (argc < 3 || (strcmp(argv[1], "export") != 0 && strcmp(argv[1], "import") != 0)){
+        cout << "Usage: " << argv[0] << " export <capture.bin> [...]          -> .sigmf-data & .sigmf-meta" << endl;
+        cout << "       " << argv[0] << " import <recording.sigmf-meta> [...] -> .bin" << endl;
+        return 1;
+    }
+    bool to_sigmf = (strcmp(argv[1], "export") == 0);
+
+    int failed = 0;
+    for (int i = 2; i < argc; i++){
+        string name = argv[i];
+        sigmf_copy_method method;
+        string output;
+
+        if (to_sigmf){
+
+            /* Device from a "<device>_<unix>.bin" Name */
+            string base = base_name(name, ".bin");
+            size_t slash = base.find_last_of('/');
+            string file = (slash == string::npos) ? base : base.substr(slash + 1);
+            int device;
+            long long stamp;
+            bool tagged = (sscanf(file.c_str(), "%d_%lld", &device, &stamp) == 2);
+
+            sigmf_recording recording;
+            recording.sample_rate = sample_rate;
+            recording.frequency = frequency;
+            recording.hardware = tagged ? hardware + " device " + to_string(device) : hardware;
+            recording.recorder = "pps_sync_rx";
+            recording.description = "PPS synchronised capture, converted from " + file + ".bin";
+            method = sigmf_export(name, base, recording);
+            output = base + ".sigmf-data";
+        }
+        else {
+            string base = base_name(base_name(name, ".sigmf-meta"), ".sigmf-data");
+            output = base + ".bin";
+            method = sigmf_import(base, output);
+        }
+
+        if (method == SIGMF_COPY_FAILED){
+            cout << name << ": conversion failed" << endl;
+            failed++;
+            continue;
+        }
+        cout << name << " -> " << output << " (" << copy_method_name(method) << ")" << endl;
+    }
+
+    return failed ? 1 : 0;
+}
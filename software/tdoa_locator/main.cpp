@@ -0,0 +1,296 @@
+#include <ctime>
+#include <cmath>
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <condition_variable>
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "string.h"
+#include "../common/tdoa.h"
+#include "../common/shm_ring.h"
+#include "../common/aggregator.h"
+#include "../common/frame_file.h"
+
+using namespace std;
+
+// g++ main.cpp ../common/tdoa.cpp ../common/delay_estimator.cpp ../common/fft.cpp ../common/aggregator.cpp ../common/rx_ring.cpp ../common/shm_ring.cpp -std=c++11 -O2 -pthread -lrt -o tdoa-locator.out
+
+/* Locator Config */
+const int reference_receiver = 0;                       // TDOAs are Measured Against this Receiver
+const int upsample = 8;                                 // Correlation Interpolation - 1/8 Sample Grid
+const size_t max_window = 8192;                         // Longest Burst Correlated (Samples)
+const double min_peak = 0.5;                            // Drop Receivers with a Weaker Correlation
+const size_t block_length = 256;                        // Burst Detector Block (Samples)
+const double threshold = 10;                            // Burst Detection above the Noise Floor (dB)
+const size_t guard = 1024;                              // Kept Either Side of a Burst - Covers ~10 km of Baseline
+const bool solve_height = false;                        // Hold the Height at the Array Centroid
+const size_t batch_frames = 100;                        // Frames per Batch - 100ms
+const size_t max_batches = 8;                           // Queued Batches Before Live Batches are Dropped
+const int position_fixes = 10;                          // GPSDO Fixes Averaged per Receiver
+
+/* Consecutive Frames Processed by One Worker */
+class frame_batch {
+    public:
+        vector<frame_header> headers;
+        vector<int16_t> samples;                        // Frames back to back
+};
+
+/* Bounded Queue Between the Aggregator and the Workers
+ * Live, write() never blocks - a batch is dropped when the workers are
+ * max_batches behind, so results stay within a second of capture. Reading
+ * a file, the reader waits instead.
+ */
+class batch_queue : public frame_sink {
+    public:
+        batch_queue(int num_devices, int frame_length, bool live)
+            : frame_samples((size_t)num_devices * frame_length * 2), live(live), is_closed(false), num_dropped(0){}
+
+        void write(const frame_header& header, const uint64_t* indices, const int16_t* samples){
+            (void)indices;
+            if (!current){
+                current.reset(new frame_batch);
+                current->samples.reserve(frame_samples * batch_frames);
+            }
+            current->headers.push_back(header);
+            current->samples.insert(current->samples.end(), samples, samples + frame_samples);
+            if (current->headers.size() == batch_frames)
+                flush();
+        }
+
+        void flush(){
+            if (!current)
+                return;
+            unique_lock<mutex> lock(queue_mutex);
+            if (live && queue.size() >= max_batches)
+                num_dropped++;
+            else {
+                space.wait(lock, [&](){ return queue.size() < max_batches; });
+                queue.push_back(move(current));
+                ready.notify_one();
+            }
+            current.reset();
+        }
+
+        void close(){
+            flush();
+            lock_guard<mutex> lock(queue_mutex);
+            is_closed = true;
+            ready.notify_all();
+        }
+
+        /* Next Batch, NULL Once Closed and Drained */
+        unique_ptr<frame_batch> pop(){
+            unique_lock<mutex> lock(queue_mutex);
+            ready.wait(lock, [&](){ return !queue.empty() || is_closed; });
+            if (queue.empty())
+                return unique_ptr<frame_batch>();
+            unique_ptr<frame_batch> batch = move(queue.front());
+            queue.pop_front();
+            space.notify_one();
+            return batch;
+        }
+
+        uint64_t dropped() const { return num_dropped; }
+
+    private:
+        size_t frame_samples;
+        bool live;
+        unique_ptr<frame_batch> current;
+        mutex queue_mutex;
+        condition_variable ready, space;
+        deque<unique_ptr<frame_batch>> queue;
+        bool is_closed;
+        uint64_t num_dropped;
+};
+
+
+/* Receivers File - One per Line in Channel Order: <ring> <lat> <lon> <height> or <ring> <gpsdo tty> */
+static bool load_receivers(const string& name, vector<receiver_position>& receivers){
+    ifstream file(name);
+    string line;
+    while (getline(file, line)){
+        istringstream fields(line);
+        receiver_position r;
+        string source;
+        if (!(fields >> r.name) || r.name[0] == '#')
+            continue;
+        if (!(fields >> source)){
+            cout << "No position for " << r.name << endl;
+            return false;
+        }
+        if (source.compare(0, 5, "/dev/") == 0){
+            cout << "Reading position of " << r.name << " from " << source << endl;
+            if (!gpsdo_position(source, position_fixes, 30000, r)){
+                cout << "No 3D fix from " << source << endl;
+                return false;
+            }
+        }
+        else {
+            r.lat = atof(source.c_str());
+            if (!(fields >> r.lon >> r.height)){
+                cout << "Bad position for " << r.name << endl;
+                return false;
+            }
+            r.fixes = 0;
+        }
+        receivers.push_back(r);
+    }
+    return !receivers.empty();
+}
+
+
+/* Entry Point */
+int main(int argc, char** argv){
+
+    /* Useage */
+    if (argc < 2){
+        cout << "Usage: " << argv[0] << " <receivers>                    Live from the pps_sync_rx rings" << endl;
+        cout << "       " << argv[0] << " <receivers> <capture.frames>   From a frame container" << endl;
+        return 1;
+    }
+
+    vector<receiver_position> receivers;
+    if (!load_receivers(argv[1], receivers))
+        return 1;
+    const int num_receivers = receivers.size();
+    if (num_receivers < (solve_height ? 4 : 3) || num_receivers > FRAME_MAX_DEVICES){
+        cout << "Need " << (solve_height ? 4 : 3) << " to " << FRAME_MAX_DEVICES << " receivers" << endl;
+        return 1;
+    }
+    cout << fixed << setprecision(7);
+    for (const receiver_position& r : receivers)
+        cout << r.name << ": " << r.lat << ", " << r.lon << ", " << setprecision(2) << r.height << " m"
+             << (r.fixes ? " (" + to_string(r.fixes) + " fixes)" : "") << setprecision(7) << endl;
+
+    /* Aggregator Config - Live */
+    aggregator_configuration config;
+    for (const receiver_position& r : receivers)
+        config.names.push_back(r.name);
+    config.ring_packets = 8192;                         // Buffer per Device (~45 MB, ~0.36s)
+    config.lag_threshold = 0.75;                        // Stop Waiting for Laggards at 75% Full
+    config.frame_length = 30720;                        // Samples per Device per Frame - 1ms
+    config.sample_rate = 30.72e6;                       // Device Sample Rate
+
+    /* Frame Container Header */
+    bool live = (argc < 3);
+    int fd = -1;
+    frame_file_header file_header;
+    if (!live){
+        fd = open(argv[2], O_RDONLY);
+        if (fd < 0 || pread(fd, &file_header, sizeof(file_header), 0) != sizeof(file_header) ||
+            file_header.magic != FRAME_FILE_MAGIC || (int)file_header.num_devices != num_receivers){
+            cout << "Not a " << num_receivers << " device frame container: " << argv[2] << endl;
+            return 1;
+        }
+        config.frame_length = file_header.frame_length;
+        config.sample_rate = file_header.sample_rate;
+    }
+
+    /* Engine */
+    tdoa_configuration engine_config;
+    engine_config.reference = reference_receiver;
+    engine_config.upsample = upsample;
+    engine_config.max_window = max_window;
+    engine_config.min_peak = min_peak;
+    engine_config.block_length = block_length;
+    engine_config.threshold = threshold;
+    engine_config.guard = guard;
+    engine_config.solve_height = solve_height;
+    engine_config.max_iterations = 50;
+    engine_config.sample_rate = config.sample_rate;
+    tdoa_engine engine(engine_config, receivers);
+
+    /* Workers Locate Whole Batches */
+    batch_queue queue(num_receivers, config.frame_length, live);
+    mutex output_mutex;
+    uint64_t num_fixes = 0;
+    double latency_sum = 0, latency_max = 0;
+    cout << "\nsecond,offset,lat,lon,height,east,north,up,rms,receivers,latency" << endl;
+
+    vector<thread> workers;
+    int num_threads = max(1u, thread::hardware_concurrency());
+    for (int t = 0; t < num_threads; t++){
+        workers.push_back(thread([&](){
+            size_t frame_samples = (size_t)num_receivers * config.frame_length * 2;
+            unique_ptr<frame_batch> batch;
+            while ((batch = queue.pop())){
+                for (size_t f = 0; f < batch->headers.size(); f++){
+                    const frame_header& h = batch->headers[f];
+                    tdoa_fix fix = engine.locate(h.gps_second, h.offset, h.valid_mask,
+                                                 batch->samples.data() + f * frame_samples, config.frame_length);
+                    if (!fix.valid)
+                        continue;
+
+                    /* Latency from the Burst to its Fix */
+                    timespec now;
+                    clock_gettime(CLOCK_REALTIME, &now);
+                    double latency = (now.tv_sec - fix.gps_second) + now.tv_nsec * 1e-9 - fix.offset;
+
+                    lock_guard<mutex> lock(output_mutex);
+                    num_fixes++;
+                    latency_sum += latency;
+                    latency_max = max(latency_max, latency);
+                    cout << setprecision(7) << fix.gps_second << "," << fix.offset << "," << fix.lat << "," << fix.lon << ","
+                         << setprecision(2) << fix.height << "," << fix.east << "," << fix.north << "," << fix.up << ","
+                         << fix.rms << "," << fix.receivers << "," << setprecision(3) << (live ? latency : 0.0) << endl;
+                }
+            }
+        }));
+    }
+
+    if (live){
+
+        /* Attach to Receiver Rings */
+        vector<unique_ptr<shm_reader>> readers;
+        vector<packet_source*> sources;
+        for (const string& ring : config.names){
+            readers.push_back(unique_ptr<shm_reader>(new shm_reader(ring)));
+            if (!readers.back()->attached()){
+                cout << "No capture ring named " << ring << endl;
+                exit(1);
+            }
+            sources.push_back(readers.back().get());
+        }
+
+        /* Run Until the Receivers Stop */
+        aggregator agg(config, sources, queue);
+        agg.run();
+    }
+    else {
+
+        /* Feed Frames from the Container */
+        size_t frame_size = sizeof(frame_header) + num_receivers * sizeof(uint64_t) +
+                            (size_t)config.frame_length * num_receivers * 2 * sizeof(int16_t);
+        vector<char> frame(frame_size);
+        for (off_t offset = sizeof(file_header); pread(fd, frame.data(), frame_size, offset) == (ssize_t)frame_size; offset += frame_size){
+            const frame_header* h = (const frame_header*)frame.data();
+            queue.write(*h, (const uint64_t*)(h + 1), (const int16_t*)(frame.data() + sizeof(frame_header) + num_receivers * sizeof(uint64_t)));
+        }
+        close(fd);
+    }
+
+    queue.close();
+    for (thread& t : workers)
+        t.join();
+
+    cout << "\nFixes: " << num_fixes << endl;
+    if (live){
+        cout << "Batches dropped: " << queue.dropped() << endl;
+        if (num_fixes)
+            cout << setprecision(3) << "Latency: mean " << latency_sum / num_fixes << " s, max " << latency_max << " s" << endl;
+    }
+
+    return 0;
+}